@@ -6,35 +6,45 @@
 #include <opencv2/imgproc.hpp>
 #include <vector>
 #include <map>
-#include <cmath>
 #include <sys/stat.h>
 #include <errno.h>
+#include <mutex>
 #include "shape_detector_c_api.h"
+#include "shape_session.h"
+#include "shape_records.h"
+#include "shape_json.h"
 
 #define LOG_TAG "ShapeDetectorJNI"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// 颜色识别相关结构和常量
-struct HullInfo {
-    std::vector<cv::Point> hull;
-    cv::Point center;
-    double area;
-    std::string color;
-    
-    HullInfo(const std::vector<cv::Point>& h, const cv::Point& c, double a, const std::string& col) 
-        : hull(h), center(c), area(a), color(col) {}
-};
+// 共享的形状检测会话：一次HSV/标签分割，颜色范围可配置，稳定性跟踪（连续命中3帧、中心距离80像素）在库内完成
+static std::mutex sessionMutex;
+
+static ShapeDetector::ShapeSession& sharedSession() {
+    static ShapeDetector::ShapeSession session([] {
+        ShapeDetector::ShapeSessionConfig config;
+        // 位图坐标系直接输出，不做相机旋转校正
+        config.detection.upright = false;
+        // 与原先桥接层一致：面积超过800的区域均保留，不按形状置信度过滤
+        config.detection.minArea = 800.0;
+        config.detection.maxArea = 0.0;
+        config.detection.minConfidence = 0.0;
+        config.tracker.window = 3;
+        config.tracker.maxMisses = 2;
+        config.tracker.maxDistance = 80.0f;
+        return config;
+    }());
+    return session;
+}
 
-// 5帧稳定性检测
-static std::vector<std::vector<HullInfo>> frameBuffer(5);
-static int currentFrameIndex = 0;
-static int frameCount = 0;
-static const double DISTANCE_THRESHOLD = 80.0;
-static const int REQUIRED_FRAMES = 3;
+// detectShapesFromBitmap逐帧复用的JSON写入器（由sessionMutex保护）
+static JsonOutput::JsonWriter& sharedJson() {
+    static JsonOutput::JsonWriter json(JsonOutput::JsonStyle::PRETTY);
+    return json;
+}
 
 // 颜色定义
-static std::vector<std::string> colorNames = {"Yellow", "Green", "Cyan", "Blue", "Black"};
 static std::map<std::string, cv::Scalar> colorMap = {
     {"Yellow", cv::Scalar(0, 255, 255)},
     {"Green", cv::Scalar(0, 255, 0)},
@@ -43,11 +53,6 @@ static std::map<std::string, cv::Scalar> colorMap = {
     {"Black", cv::Scalar(128, 128, 128)}
 };
 
-// 计算两点间距离
-double calculateDistance(const cv::Point& p1, const cv::Point& p2) {
-    return std::sqrt(std::pow(p1.x - p2.x, 2) + std::pow(p1.y - p2.y, 2));
-}
-
 // 创建目录的函数
 bool createDirectory(const std::string& path) {
     struct stat st = {0};
@@ -65,27 +70,24 @@ bool createDirectory(const std::string& path) {
     }
 }
 
-// 创建颜色掩码
-cv::Mat createColorMask(const cv::Mat& image, const std::string& colorName) {
-    cv::Mat hsv, mask;
-    cv::cvtColor(image, hsv, cv::COLOR_BGR2HSV);
-    
-    // 定义颜色范围
-    std::map<std::string, std::pair<cv::Scalar, cv::Scalar>> colorRanges = {
-        {"Yellow", {cv::Scalar(10, 20, 60), cv::Scalar(40, 255, 255)}},
-        {"Green", {cv::Scalar(40, 40, 60), cv::Scalar(85, 255, 255)}},
-        {"Cyan", {cv::Scalar(95, 50, 110), cv::Scalar(120, 255, 255)}},
-        {"Blue", {cv::Scalar(100, 40, 60), cv::Scalar(140, 255, 255)}},
-        {"Black", {cv::Scalar(0, 0, 0), cv::Scalar(180, 50, 40)}}
-    };
-    
-    if (colorRanges.find(colorName) != colorRanges.end()) {
-        cv::inRange(hsv, colorRanges[colorName].first, colorRanges[colorName].second, mask);
-    } else {
-        mask = cv::Mat::zeros(image.size(), CV_8UC1);
-    }
-    
-    return mask;
+// 将已锁定的RGBA_8888位图像素包装为CV_8UC4（不复制，按info.stride跨行）
+cv::Mat wrapBitmap(const AndroidBitmapInfo& info, void* pixels) {
+    return cv::Mat(info.height, info.width, CV_8UC4, pixels, info.stride);
+}
+
+// BGR颜色转换为RGBA位图上的绘制颜色
+cv::Scalar toRgbaColor(const cv::Scalar& bgr) {
+    return cv::Scalar(bgr[2], bgr[1], bgr[0], 255);
+}
+
+// 绘制形状的凸包、中心点与颜色标签
+void drawShape(cv::Mat& image, const ShapeDetector::DetectedShape& shape, const cv::Scalar& color,
+               int centerRadius, double fontScale) {
+    cv::polylines(image, shape.hull, true, color, 3);
+    cv::Point center(static_cast<int>(shape.center.x), static_cast<int>(shape.center.y));
+    cv::circle(image, center, centerRadius, color, -1);
+    cv::putText(image, shape.color, cv::Point(center.x - 20, center.y - 10),
+                cv::FONT_HERSHEY_SIMPLEX, fontScale, color, 2);
 }
 
 extern "C" {
@@ -105,9 +107,44 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_init(JNIEnv *env, jclass clazz) {
 JNIEXPORT void JNICALL
 Java_com_tableos_beakerlab_ShapeDetectorJNI_cleanup(JNIEnv *env, jclass clazz) {
     LOGI("Cleaning up shape detector");
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        sharedSession().reset();
+    }
     shape_detector_cleanup();
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_tableos_beakerlab_ShapeDetectorJNI_setColorRange(JNIEnv *env, jclass clazz, jstring color,
+                                                          jintArray lower, jintArray upper) {
+    if (!color || !lower || !upper || env->GetArrayLength(lower) < 3 || env->GetArrayLength(upper) < 3) {
+        return JNI_FALSE;
+    }
+    jint lo[3];
+    jint hi[3];
+    env->GetIntArrayRegion(lower, 0, 3, lo);
+    env->GetIntArrayRegion(upper, 0, 3, hi);
+    
+    const char* colorStr = env->GetStringUTFChars(color, nullptr);
+    std::string colorName(colorStr);
+    env->ReleaseStringUTFChars(color, colorStr);
+    
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    if (!sharedSession().setColorRange(colorName, ShapeDetector::ColorRange(
+            cv::Scalar(lo[0], lo[1], lo[2]), cv::Scalar(hi[0], hi[1], hi[2])))) {
+        LOGE("颜色范围已达上限（%d种），忽略新颜色: %s", ShapeDetector::MAX_LABEL_COLORS, colorName.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_tableos_beakerlab_ShapeDetectorJNI_setStability(JNIEnv *env, jclass clazz, jint window,
+                                                         jint maxMisses, jfloat distance) {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    sharedSession().setStability(window, maxMisses, distance);
+}
+
 JNIEXPORT jstring JNICALL
 Java_com_tableos_beakerlab_ShapeDetectorJNI_detectShapesFromBitmap(JNIEnv *env, jclass clazz, jobject bitmap) {
     AndroidBitmapInfo info;
@@ -119,121 +156,78 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_detectShapesFromBitmap(JNIEnv *env,
         return env->NewStringUTF("{}");
     }
     
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Unsupported bitmap format: %d", info.format);
+        return env->NewStringUTF("{}");
+    }
+    
     // Lock bitmap pixels
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
         LOGE("Failed to lock bitmap pixels");
         return env->NewStringUTF("{}");
     }
     
-    // Convert RGBA to BGR for OpenCV
-    int width = info.width;
-    int height = info.height;
-    cv::Mat frame(height, width, CV_8UC3);
-    
-    uint8_t* rgba_pixels = (uint8_t*)pixels;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgba_idx = (y * width + x) * 4;
-            int bgr_idx = y * width + x;
-            frame.at<cv::Vec3b>(y, x)[0] = rgba_pixels[rgba_idx + 2]; // B
-            frame.at<cv::Vec3b>(y, x)[1] = rgba_pixels[rgba_idx + 1]; // G
-            frame.at<cv::Vec3b>(y, x)[2] = rgba_pixels[rgba_idx + 0]; // R
-        }
+    // 直接包装位图像素，由共享会话完成分割、检测与稳定性筛选；
+    // 按与generateJsonOutput相同的布局输出（每个字段独占一行，兼容现有逐行解析），id为跨帧持久的轨迹ID
+    jstring result = nullptr;
+    try {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        const auto& stableShapes = sharedSession().process(wrapBitmap(info, pixels));
+        JsonOutput::JsonWriter& json = sharedJson();
+        ShapeDetector::writeDetectionJson(json, stableShapes.size(), [&stableShapes](size_t i) {
+            return ShapeDetector::shapeJsonFields(stableShapes[i], stableShapes[i].trackId);
+        });
+        result = env->NewStringUTF(json.data());
+    } catch (const std::exception& e) {
+        LOGE("Shape detection failed: %s", e.what());
     }
     
     // Unlock bitmap
     AndroidBitmap_unlockPixels(env, bitmap);
     
-    // 更新帧计数和索引
-    frameCount++;
-    currentFrameIndex = frameCount % 5;
+    return result ? result : env->NewStringUTF("{}");
+}
+
+JNIEXPORT jint JNICALL
+Java_com_tableos_beakerlab_ShapeDetectorJNI_detectShapesToBuffer(JNIEnv *env, jclass clazz, jobject bitmap,
+                                                                 jobject buffer) {
+    // 结果按ShapeRecordHeader + ShapeRecord定长布局直接写入DirectByteBuffer，不创建Java字符串
+    void* out = buffer ? env->GetDirectBufferAddress(buffer) : nullptr;
+    const jlong capacity = buffer ? env->GetDirectBufferCapacity(buffer) : -1;
+    if (!out || capacity < static_cast<jlong>(sizeof(ShapeRecordHeader))) {
+        LOGE("Result buffer must be a direct ByteBuffer of at least %zu bytes", sizeof(ShapeRecordHeader));
+        return -1;
+    }
     
-    // 清空当前帧的检测结果
-    frameBuffer[currentFrameIndex].clear();
+    AndroidBitmapInfo info;
+    void* pixels;
     
-    // 对每种颜色进行检测
-    for (const std::string& colorName : colorNames) {
-        cv::Mat mask = createColorMask(frame, colorName);
-        
-        // 找到轮廓
-        std::vector<std::vector<cv::Point>> contours;
-        std::vector<cv::Vec4i> hierarchy;
-        cv::findContours(mask, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-        
-        // 处理每个轮廓
-        for (const auto& contour : contours) {
-            double area = cv::contourArea(contour);
-            
-            if (area > 800) {  // 过滤小轮廓，与保存图片检测保持一致
-                std::vector<cv::Point> hull;
-                cv::convexHull(contour, hull);
-                
-                // 计算中心点
-                cv::Moments m = cv::moments(contour);
-                if (m.m00 != 0) {
-                    cv::Point center(m.m10 / m.m00, m.m01 / m.m00);
-                    
-                    // 存储当前帧的凸包信息
-                    frameBuffer[currentFrameIndex].emplace_back(hull, center, area, colorName);
-                }
-            }
-        }
+    if (AndroidBitmap_getInfo(env, bitmap, &info) < 0) {
+        LOGE("Failed to get bitmap info");
+        return -1;
     }
     
-    // 收集稳定的凸包
-    std::vector<HullInfo> stableHulls;
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Unsupported bitmap format: %d", info.format);
+        return -1;
+    }
     
-    // 如果已经有足够的帧数，进行稳定性检测
-    if (frameCount >= REQUIRED_FRAMES) {
-        // 检查当前帧的每个凸包是否在过去的帧中都有相似位置的凸包
-        for (const auto& currentHull : frameBuffer[currentFrameIndex]) {
-            bool isStable = true;
-            
-            // 检查过去的帧
-            for (int i = 1; i < REQUIRED_FRAMES; i++) {
-                int prevFrameIndex = (currentFrameIndex - i + 5) % 5;
-                bool foundSimilar = false;
-                
-                // 在前一帧中寻找相似位置和颜色的凸包
-                for (const auto& prevHull : frameBuffer[prevFrameIndex]) {
-                    if (prevHull.color == currentHull.color) {
-                        double distance = calculateDistance(currentHull.center, prevHull.center);
-                        if (distance <= DISTANCE_THRESHOLD) {
-                            foundSimilar = true;
-                            break;
-                        }
-                    }
-                }
-                
-                if (!foundSimilar) {
-                    isStable = false;
-                    break;
-                }
-            }
-            
-            // 如果稳定，添加到结果中
-            if (isStable) {
-                stableHulls.push_back(currentHull);
-            }
-        }
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
+        LOGE("Failed to lock bitmap pixels");
+        return -1;
     }
     
-    // 构建简化的JSON结果，兼容现有解析逻辑
-    std::string result = "";
-    for (size_t i = 0; i < stableHulls.size(); ++i) {
-        const auto& hull = stableHulls[i];
-        result += "{\n";
-        result += "  \"id\": " + std::to_string(i) + ",\n";
-        result += "  \"position\": {\n";
-        result += "    \"x\": " + std::to_string(hull.center.x) + ",\n";
-        result += "    \"y\": " + std::to_string(hull.center.y) + "\n";
-        result += "  },\n";
-        result += "  \"color\": \"" + hull.color + "\"\n";
-        result += "}\n";
-        if (i < stableHulls.size() - 1) result += "\n";
+    int count = -1;
+    try {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        const auto& stableShapes = sharedSession().process(wrapBitmap(info, pixels));
+        count = ShapeDetector::writeShapeRecords(stableShapes, out, static_cast<size_t>(capacity));
+    } catch (const std::exception& e) {
+        LOGE("Shape detection failed: %s", e.what());
     }
     
-    return env->NewStringUTF(result.c_str());
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return count;
 }
 
 JNIEXPORT jobject JNICALL
@@ -247,88 +241,23 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_annotateImage(JNIEnv *env, jclass cl
         return nullptr;
     }
     
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Unsupported bitmap format: %d", info.format);
+        return nullptr;
+    }
+    
     // Lock bitmap pixels
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
         LOGE("Failed to lock bitmap pixels");
         return nullptr;
     }
     
-    // Convert RGBA to BGR for OpenCV
-    int width = info.width;
-    int height = info.height;
-    cv::Mat frame(height, width, CV_8UC3);
-    cv::Mat displayFrame(height, width, CV_8UC4);
-    
-    uint8_t* rgba_pixels = (uint8_t*)pixels;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgba_idx = (y * width + x) * 4;
-            // 复制原始RGBA到显示帧
-            displayFrame.at<cv::Vec4b>(y, x)[0] = rgba_pixels[rgba_idx + 2]; // B
-            displayFrame.at<cv::Vec4b>(y, x)[1] = rgba_pixels[rgba_idx + 1]; // G
-            displayFrame.at<cv::Vec4b>(y, x)[2] = rgba_pixels[rgba_idx + 0]; // R
-            displayFrame.at<cv::Vec4b>(y, x)[3] = rgba_pixels[rgba_idx + 3]; // A
-            
-            // BGR for processing
-            frame.at<cv::Vec3b>(y, x)[0] = rgba_pixels[rgba_idx + 2]; // B
-            frame.at<cv::Vec3b>(y, x)[1] = rgba_pixels[rgba_idx + 1]; // G
-            frame.at<cv::Vec3b>(y, x)[2] = rgba_pixels[rgba_idx + 0]; // R
-        }
-    }
-    
-    // 绘制稳定的凸包
-    if (frameCount >= REQUIRED_FRAMES) {
-        for (const auto& currentHull : frameBuffer[currentFrameIndex]) {
-            bool isStable = true;
-            
-            // 检查稳定性
-            for (int i = 1; i < REQUIRED_FRAMES; i++) {
-                int prevFrameIndex = (currentFrameIndex - i + 5) % 5;
-                bool foundSimilar = false;
-                
-                for (const auto& prevHull : frameBuffer[prevFrameIndex]) {
-                    if (prevHull.color == currentHull.color) {
-                        double distance = calculateDistance(currentHull.center, prevHull.center);
-                        if (distance <= DISTANCE_THRESHOLD) {
-                            foundSimilar = true;
-                            break;
-                        }
-                    }
-                }
-                
-                if (!foundSimilar) {
-                    isStable = false;
-                    break;
-                }
-            }
-            
-            // 如果稳定，绘制凸包
-            if (isStable) {
-                cv::Scalar color = colorMap[currentHull.color];
-                
-                // 绘制凸包轮廓
-                std::vector<std::vector<cv::Point>> hullContours = {currentHull.hull};
-                cv::drawContours(displayFrame, hullContours, -1, color, 3);
-                
-                // 绘制中心点
-                cv::circle(displayFrame, currentHull.center, 5, color, -1);
-                
-                // 添加标签
-                cv::putText(displayFrame, currentHull.color, 
-                           cv::Point(currentHull.center.x - 20, currentHull.center.y - 10),
-                           cv::FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
-            }
-        }
-    }
-    
-    // 将结果复制回bitmap
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgba_idx = (y * width + x) * 4;
-            rgba_pixels[rgba_idx + 0] = displayFrame.at<cv::Vec4b>(y, x)[2]; // R
-            rgba_pixels[rgba_idx + 1] = displayFrame.at<cv::Vec4b>(y, x)[1]; // G
-            rgba_pixels[rgba_idx + 2] = displayFrame.at<cv::Vec4b>(y, x)[0]; // B
-            rgba_pixels[rgba_idx + 3] = displayFrame.at<cv::Vec4b>(y, x)[3]; // A
+    // 直接在位图像素上绘制最近一帧的稳定形状
+    cv::Mat displayFrame = wrapBitmap(info, pixels);
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        for (const auto& shape : sharedSession().stableShapes()) {
+            drawShape(displayFrame, shape, toRgbaColor(colorMap[shape.color]), 5, 0.5);
         }
     }
     
@@ -357,13 +286,18 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_saveDebugImages(JNIEnv *env, jclass
     
     LOGI("Bitmap info: width=%d, height=%d, format=%d", info.width, info.height, info.format);
     
+    if (info.format != ANDROID_BITMAP_FORMAT_RGBA_8888) {
+        LOGE("Unsupported bitmap format: %d", info.format);
+        return env->NewStringUTF("Unsupported bitmap format");
+    }
+    
     if (AndroidBitmap_lockPixels(env, bitmap, &pixels) < 0) {
         LOGE("Failed to lock bitmap pixels");
         return env->NewStringUTF("Failed to lock bitmap pixels");
     }
     
     // 转换为OpenCV Mat
-    cv::Mat rgba(info.height, info.width, CV_8UC4, pixels);
+    cv::Mat rgba = wrapBitmap(info, pixels);
     cv::Mat bgr;
     cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
     
@@ -387,6 +321,7 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_saveDebugImages(JNIEnv *env, jclass
         // 创建目录（如果不存在）
         if (!createDirectory(basePath)) {
             LOGE("无法创建目录: %s", basePath.c_str());
+            AndroidBitmap_unlockPixels(env, bitmap);
             return env->NewStringUTF("Failed to create directory");
         }
         
@@ -395,13 +330,24 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_saveDebugImages(JNIEnv *env, jclass
         bool success = cv::imwrite(originalPath, bgr);
         LOGI("保存原始图像: %s, 成功: %d", originalPath.c_str(), success);
         
-        // 为每种颜色创建mask并保存
-        for (const auto& colorName : colorNames) {
-            LOGI("处理颜色: %s", colorName.c_str());
-            
-            cv::Mat mask = createColorMask(bgr, colorName);
-            LOGI("创建mask完成: %s, size=%dx%d, 非零像素数=%d", 
-                 colorName.c_str(), mask.cols, mask.rows, cv::countNonZero(mask));
+        // 与检测会话相同的颜色范围与分割（一次HSV/标签计算），调试输出保留面积超过500的全部区域
+        ShapeDetector::DetectionOptions debugOptions;
+        {
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            debugOptions = sharedSession().config().detection;
+        }
+        debugOptions.minArea = 500.0;
+        debugOptions.maxArea = 0.0;
+        debugOptions.minConfidence = 0.0;
+        
+        std::map<std::string, cv::Mat> masks = ShapeDetector::segmentColorRegions(bgr, debugOptions.colorRanges);
+        ShapeDetector::DetectionResult detection = ShapeDetector::detectShapes(bgr, debugOptions);
+        
+        // 为每种颜色保存mask与检测结果
+        for (const auto& maskPair : masks) {
+            const std::string& colorName = maskPair.first;
+            const cv::Mat& mask = maskPair.second;
+            LOGI("处理颜色: %s, 非零像素数=%d", colorName.c_str(), cv::countNonZero(mask));
             
             // 保存mask图像
             std::string maskPath = basePath + "/" + colorName + "_mask.jpg";
@@ -410,38 +356,13 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_saveDebugImages(JNIEnv *env, jclass
             
             // 在原图上绘制该颜色的检测结果
             cv::Mat colorResult = bgr.clone();
-            std::vector<std::vector<cv::Point>> contours;
-            cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-            
-            LOGI("找到轮廓数量: %zu", contours.size());
-            
             int validContours = 0;
-            for (const auto& contour : contours) {
-                double area = cv::contourArea(contour);
-                if (area > 500) {
-                    validContours++;
-                    std::vector<cv::Point> hull;
-                    cv::convexHull(contour, hull);
-                    
-                    // 绘制凸包
-                    cv::Scalar drawColor = colorMap[colorName];
-                    cv::polylines(colorResult, hull, true, drawColor, 3);
-                    
-                    // 计算并绘制中心点
-                    cv::Moments moments = cv::moments(contour);
-                    if (moments.m00 > 0) {
-                        cv::Point center(moments.m10 / moments.m00, moments.m01 / moments.m00);
-                        cv::circle(colorResult, center, 8, drawColor, -1);
-                        
-                        // 添加颜色标签
-                        cv::putText(colorResult, colorName, 
-                                  cv::Point(center.x - 30, center.y - 15),
-                                  cv::FONT_HERSHEY_SIMPLEX, 0.7, drawColor, 2);
-                        
-                        LOGI("绘制%s检测结果: 中心点(%d,%d), 面积=%.1f", 
-                             colorName.c_str(), center.x, center.y, area);
-                    }
-                }
+            for (const auto& shape : detection.shapes) {
+                if (shape.color != colorName) continue;
+                validContours++;
+                drawShape(colorResult, shape, colorMap[colorName], 8, 0.7);
+                LOGI("绘制%s检测结果: 中心点(%.0f,%.0f), 面积=%.1f",
+                     colorName.c_str(), shape.center.x, shape.center.y, shape.area);
             }
             
             LOGI("有效轮廓数量: %d", validContours);
@@ -454,32 +375,9 @@ Java_com_tableos_beakerlab_ShapeDetectorJNI_saveDebugImages(JNIEnv *env, jclass
         // 创建综合结果图像
         LOGI("创建综合结果图像");
         cv::Mat combinedResult = bgr.clone();
-        int totalDetections = 0;
-        
-        for (const auto& colorName : colorNames) {
-            cv::Mat mask = createColorMask(bgr, colorName);
-            std::vector<std::vector<cv::Point>> contours;
-            cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-            
-            for (const auto& contour : contours) {
-                if (cv::contourArea(contour) > 500) {
-                    totalDetections++;
-                    std::vector<cv::Point> hull;
-                    cv::convexHull(contour, hull);
-                    
-                    cv::Scalar drawColor = colorMap[colorName];
-                    cv::polylines(combinedResult, hull, true, drawColor, 3);
-                    
-                    cv::Moments moments = cv::moments(contour);
-                    if (moments.m00 > 0) {
-                        cv::Point center(moments.m10 / moments.m00, moments.m01 / moments.m00);
-                        cv::circle(combinedResult, center, 8, drawColor, -1);
-                        cv::putText(combinedResult, colorName, 
-                                  cv::Point(center.x - 30, center.y - 15),
-                                  cv::FONT_HERSHEY_SIMPLEX, 0.7, drawColor, 2);
-                    }
-                }
-            }
+        int totalDetections = static_cast<int>(detection.shapes.size());
+        for (const auto& shape : detection.shapes) {
+            drawShape(combinedResult, shape, colorMap[shape.color], 8, 0.7);
         }
         
         LOGI("综合结果图像总检测数量: %d", totalDetections);
@@ -98,7 +98,22 @@ class ChemicalReactionEngine {
     }
     
     /**
-     * 将形状检测结果转换为化学元素
+     * 从二进制检测结果构建化学元素列表（逐帧路径，无需解析字符串）
+     */
+    fun detectedElements(results: ShapeResultBuffer): List<DetectedElement> {
+        val count = results.count
+        val elements = ArrayList<DetectedElement>(count)
+        for (i in 0 until count) {
+            val color = results.colorName(i)
+            colorToChemical[color]?.let { chemicalType ->
+                elements.add(DetectedElement(results.id(i), chemicalType, results.x(i), results.y(i), color))
+            }
+        }
+        return elements
+    }
+    
+    /**
+     * 将形状检测结果转换为化学元素（JSON输入，仅用于调试）
      */
     fun parseDetectedElements(shapeJson: String): List<DetectedElement> {
         val elements = mutableListOf<DetectedElement>()
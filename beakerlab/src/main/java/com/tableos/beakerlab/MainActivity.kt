@@ -432,6 +432,9 @@ class MainActivity : AppCompatActivity(), CameraManager.FrameCallback, ChemicalR
     
     private var imageSizeSet = false
     
+    // 逐帧复用的二进制检测结果缓冲区
+    private val shapeResults = ShapeResultBuffer()
+    
     private fun processFrameForReactions(bitmap: Bitmap) {
         // Set image size for reaction engine on first frame
         if (!imageSizeSet) {
@@ -446,18 +449,18 @@ class MainActivity : AppCompatActivity(), CameraManager.FrameCallback, ChemicalR
             }
         }
         
-        // Use shape detection to find colored squares
-        val detectionResult = ShapeDetectorJNI.detectShapesFromBitmap(bitmap)
+        // Use shape detection to find colored squares（二进制结果直接写入复用的DirectByteBuffer）
+        val count = ShapeDetectorJNI.detectShapesToBuffer(bitmap, shapeResults.buffer)
         
-        // 打印NDK返回的原始JSON检测结果
-        Log.i(TAG, "=== NDK检测原始结果 ===")
-        Log.i(TAG, "检测结果长度: ${detectionResult.length}")
-        if (detectionResult.isNotEmpty()) {
-            Log.i(TAG, "原始JSON: $detectionResult")
+        Log.i(TAG, "=== NDK检测结果 ===")
+        if (count > 0) {
+            if (shapeResults.totalCount > count) {
+                Log.w(TAG, "结果缓冲区容量不足: ${shapeResults.totalCount} 个形状仅写入 $count 个")
+            }
             
-            // Parse detection results and check for reactions
-            val elements = reactionEngine.parseDetectedElements(detectionResult)
-            Log.i(TAG, "解析后的元素数量: ${elements.size}")
+            // Build elements and check for reactions
+            val elements = reactionEngine.detectedElements(shapeResults)
+            Log.i(TAG, "检测到的元素数量: ${elements.size}")
             
             // 将检测到的形状传递给BeakerCanvasView进行显示
             runOnUiThread {
@@ -468,7 +471,7 @@ class MainActivity : AppCompatActivity(), CameraManager.FrameCallback, ChemicalR
             
             reactionEngine.detectReactions(elements)
         } else {
-            Log.i(TAG, "检测结果为空")
+            Log.i(TAG, if (count < 0) "检测失败" else "检测结果为空")
         }
         Log.i(TAG, "=== 检测结果结束 ===")
     }
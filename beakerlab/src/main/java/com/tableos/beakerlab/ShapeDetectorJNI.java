@@ -1,6 +1,7 @@
 package com.tableos.beakerlab;
 
 import android.graphics.Bitmap;
+import java.nio.ByteBuffer;
 
 public class ShapeDetectorJNI {
     
@@ -20,12 +21,38 @@ public class ShapeDetectorJNI {
     public static native void cleanup();
     
     /**
-     * Detect shapes in a bitmap and return JSON result
+     * Set (or add) the HSV range used for one color by the shared detection session
+     * @param color Color name, e.g. "Yellow"
+     * @param lower Lower HSV bound {h, s, v} (H in [0, 180])
+     * @param upper Upper HSV bound {h, s, v}
+     * @return true if the range was applied, false on invalid arguments or when 8 colors are already configured
+     */
+    public static native boolean setColorRange(String color, int[] lower, int[] upper);
+    
+    /**
+     * Configure the stability tracker of the shared detection session
+     * @param window A shape is reported once tracked in this many consecutive frames
+     * @param maxMisses Consecutive missed frames before a track (and its ID) is dropped
+     * @param distance Maximum center distance in pixels between frames for the same color
+     */
+    public static native void setStability(int window, int maxMisses, float distance);
+    
+    /**
+     * Detect shapes in a bitmap and return JSON result (debugging; use detectShapesToBuffer per frame)
      * @param bitmap Input bitmap
-     * @return JSON string containing detection results
+     * @return JSON string containing the stable shapes; "id" is a persistent track ID
      */
     public static native String detectShapesFromBitmap(Bitmap bitmap);
     
+    /**
+     * Detect shapes in a bitmap and write the stable shapes into a direct buffer using the
+     * flat binary layout (see ShapeResultBuffer); JSON output is kept for debugging only
+     * @param bitmap Input bitmap (ARGB_8888)
+     * @param buffer Direct ByteBuffer receiving the header and packed records
+     * @return Number of records written, -1 on error
+     */
+    public static native int detectShapesToBuffer(Bitmap bitmap, ByteBuffer buffer);
+    
     /**
      * Annotate image with detection results
      * @param bitmap Input bitmap
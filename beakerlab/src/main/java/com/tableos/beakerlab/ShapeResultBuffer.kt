@@ -0,0 +1,60 @@
+package com.tableos.beakerlab
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * 形状检测的二进制结果缓冲区（与 shape_detector_c_api.h 中的 ShapeRecordHeader/ShapeRecord 布局一致）
+ *
+ * 头部：magic(u32) version(u16) headerSize(u16) recordSize(u16) reserved(u16) count(i32) totalCount(i32)
+ * 记录：id(i32) color(i32, ColorType) type(i32, ShapeType) x(f32) y(f32) angle(f32) area(f32)
+ *
+ * 缓冲区在构造时一次分配，逐帧复用，由 [ShapeDetectorJNI.detectShapesToBuffer] 直接写入。
+ */
+class ShapeResultBuffer(maxShapes: Int = 64) {
+
+    val buffer: ByteBuffer = ByteBuffer
+        .allocateDirect(HEADER_SIZE + maxShapes * RECORD_SIZE)
+        .order(ByteOrder.LITTLE_ENDIAN)
+
+    // 记录数，头部无效（未写入或版本不符）时为 0
+    val count: Int
+        get() = if (isValid()) buffer.getInt(12) else 0
+
+    // 本帧形状总数，大于 count 表示缓冲区容量不足
+    val totalCount: Int
+        get() = if (isValid()) buffer.getInt(16) else 0
+
+    fun id(index: Int): Int = buffer.getInt(offset(index))
+    fun color(index: Int): Int = buffer.getInt(offset(index) + 4)
+    fun type(index: Int): Int = buffer.getInt(offset(index) + 8)
+    fun x(index: Int): Float = buffer.getFloat(offset(index) + 12)
+    fun y(index: Int): Float = buffer.getFloat(offset(index) + 16)
+    fun angle(index: Int): Float = buffer.getFloat(offset(index) + 20)
+    fun area(index: Int): Float = buffer.getFloat(offset(index) + 24)
+
+    // 将颜色编号转换为检测端使用的颜色名称
+    fun colorName(index: Int): String = COLOR_NAMES.getOrElse(color(index)) { "Unknown" }
+
+    private fun isValid(): Boolean =
+        buffer.getInt(0) == MAGIC && (buffer.getShort(4).toInt() and 0xFFFF) == VERSION
+
+    // 按头部声明的尺寸定位，兼容之后在头部/记录末尾追加的字段
+    private fun offset(index: Int): Int {
+        val headerSize = buffer.getShort(6).toInt() and 0xFFFF
+        val recordSize = buffer.getShort(8).toInt() and 0xFFFF
+        return headerSize + index * recordSize
+    }
+
+    companion object {
+        const val MAGIC = 0x52504853 // "SHPR"
+        const val VERSION = 1
+        const val HEADER_SIZE = 20
+        const val RECORD_SIZE = 28
+
+        // ColorType 枚举顺序
+        private val COLOR_NAMES = listOf(
+            "Unknown", "Red", "Green", "Blue", "Yellow", "Cyan", "Magenta", "Black", "White"
+        )
+    }
+}
@@ -0,0 +1,231 @@
+#include "bit_mask.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define BIT_MASK_USE_NEON 1
+#endif
+
+namespace DotCardDetect {
+
+namespace {
+
+// 8个字节各自非零时置对应位（字节0对应最低位）
+inline uint64_t packBytes(uint64_t v) {
+    uint64_t t = v | (v >> 4);
+    t |= t >> 2;
+    t |= t >> 1;
+    t &= 0x0101010101010101ULL;
+    return (t * 0x0102040810204080ULL) >> 56;
+}
+
+// [x0, x1) 在单个字内的位掩码，要求 0 <= x0 < x1 <= 64
+inline uint64_t bitRange(int x0, int x1) {
+    uint64_t high = (x1 >= 64) ? ~0ULL : ((1ULL << x1) - 1);
+    uint64_t low = (1ULL << x0) - 1;
+    return high & ~low;
+}
+
+int popcountWords(const uint64_t* words, size_t n) {
+    size_t i = 0;
+    int total = 0;
+#ifdef BIT_MASK_USE_NEON
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 2 <= n; i += 2) {
+        uint8x16_t bytes = vreinterpretq_u8_u64(vld1q_u64(words + i));
+        uint8x16_t counts = vcntq_u8(bytes);
+        acc = vpadalq_u16(acc, vpaddlq_u8(counts));
+    }
+    uint32_t lanes[4];
+    vst1q_u32(lanes, acc);
+    total = static_cast<int>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) {
+        total += __builtin_popcountll(words[i]);
+    }
+    return total;
+}
+
+} // namespace
+
+BitMask::BitMask() : rows_(0), cols_(0), wordsPerRow_(0) {}
+
+BitMask::BitMask(int rows, int cols) : rows_(0), cols_(0), wordsPerRow_(0) {
+    create(rows, cols);
+}
+
+void BitMask::create(int rows, int cols) {
+    rows_ = std::max(0, rows);
+    cols_ = std::max(0, cols);
+    wordsPerRow_ = (static_cast<size_t>(cols_) + 63) / 64;
+    words_.assign(wordsPerRow_ * rows_, 0);
+}
+
+BitMask BitMask::fromMat(const cv::Mat& mask) {
+    BitMask bits;
+    bits.assign(mask);
+    return bits;
+}
+
+void BitMask::assign(const cv::Mat& mask) {
+    if (mask.empty() || mask.type() != CV_8UC1) {
+        create(0, 0);
+        return;
+    }
+
+    if (mask.rows != rows_ || mask.cols != cols_) {
+        rows_ = mask.rows;
+        cols_ = mask.cols;
+        wordsPerRow_ = (static_cast<size_t>(cols_) + 63) / 64;
+        words_.resize(wordsPerRow_ * rows_);
+    }
+
+    packRows(mask, 0);
+}
+
+void BitMask::packRows(const cv::Mat& mask, int y0) {
+    if (mask.empty() || mask.type() != CV_8UC1 || mask.cols != cols_) return;
+
+    const int rowCount = std::min(mask.rows, rows_ - y0);
+    for (int r = 0; r < rowCount; ++r) {
+        const uchar* src = mask.ptr<uchar>(r);
+        uint64_t* dst = row(y0 + r);
+
+        int x = 0;
+        size_t w = 0;
+        for (; x + 64 <= cols_; x += 64, ++w) {
+            uint64_t word = 0;
+            for (int k = 0; k < 8; ++k) {
+                uint64_t chunk;
+                std::memcpy(&chunk, src + x + k * 8, sizeof(chunk));
+                word |= packBytes(chunk) << (k * 8);
+            }
+            dst[w] = word;
+        }
+
+        if (x < cols_) {
+            // 末尾不足64像素的部分，未使用的高位保持为0
+            uint64_t word = 0;
+            for (int bit = 0; x + bit < cols_; ++bit) {
+                if (src[x + bit]) {
+                    word |= 1ULL << bit;
+                }
+            }
+            dst[w] = word;
+        }
+    }
+}
+
+cv::Mat BitMask::toMat() const {
+    cv::Mat mask = cv::Mat::zeros(rows_, cols_, CV_8UC1);
+    forEachSpan([&mask](int y, int x0, int x1) {
+        uchar* dst = mask.ptr<uchar>(y);
+        std::fill(dst + x0, dst + x1, static_cast<uchar>(255));
+    });
+    return mask;
+}
+
+void BitMask::setSpan(int y, int x0, int x1) {
+    if (y < 0 || y >= rows_) return;
+    x0 = std::max(0, x0);
+    x1 = std::min(cols_, x1);
+    if (x1 <= x0) return;
+
+    uint64_t* words = row(y);
+    int w0 = x0 >> 6;
+    int w1 = (x1 - 1) >> 6;
+    if (w0 == w1) {
+        words[w0] |= bitRange(x0 & 63, x1 - (w0 << 6));
+        return;
+    }
+    words[w0] |= bitRange(x0 & 63, 64);
+    for (int w = w0 + 1; w < w1; ++w) {
+        words[w] = ~0ULL;
+    }
+    words[w1] |= bitRange(0, x1 - (w1 << 6));
+}
+
+int BitMask::countSpan(int y, int x0, int x1) const {
+    if (y < 0 || y >= rows_) return 0;
+    x0 = std::max(0, x0);
+    x1 = std::min(cols_, x1);
+    if (x1 <= x0) return 0;
+
+    const uint64_t* words = row(y);
+    int w0 = x0 >> 6;
+    int w1 = (x1 - 1) >> 6;
+    if (w0 == w1) {
+        return __builtin_popcountll(words[w0] & bitRange(x0 & 63, x1 - (w0 << 6)));
+    }
+
+    int total = __builtin_popcountll(words[w0] & bitRange(x0 & 63, 64));
+    total += popcountWords(words + w0 + 1, static_cast<size_t>(w1 - w0 - 1));
+    total += __builtin_popcountll(words[w1] & bitRange(0, x1 - (w1 << 6)));
+    return total;
+}
+
+int BitMask::countRect(const cv::Rect& rect) const {
+    cv::Rect r = rect & cv::Rect(0, 0, cols_, rows_);
+    int total = 0;
+    for (int y = r.y; y < r.y + r.height; ++y) {
+        total += countSpan(y, r.x, r.x + r.width);
+    }
+    return total;
+}
+
+int BitMask::count() const {
+    return popcountWords(words_.data(), words_.size());
+}
+
+void BitMask::andWith(const BitMask& other) {
+    bitwiseAnd(*this, other, *this);
+}
+
+void BitMask::orWith(const BitMask& other) {
+    bitwiseOr(*this, other, *this);
+}
+
+void BitMask::bitwiseAnd(const BitMask& a, const BitMask& b, BitMask& dst) {
+    if (a.rows_ != b.rows_ || a.cols_ != b.cols_) return;
+    if (&dst != &a && &dst != &b) {
+        dst.create(a.rows_, a.cols_);
+    }
+
+    const size_t n = a.words_.size();
+    const uint64_t* pa = a.words_.data();
+    const uint64_t* pb = b.words_.data();
+    uint64_t* pd = dst.words_.data();
+    size_t i = 0;
+#ifdef BIT_MASK_USE_NEON
+    for (; i + 2 <= n; i += 2) {
+        vst1q_u64(pd + i, vandq_u64(vld1q_u64(pa + i), vld1q_u64(pb + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        pd[i] = pa[i] & pb[i];
+    }
+}
+
+void BitMask::bitwiseOr(const BitMask& a, const BitMask& b, BitMask& dst) {
+    if (a.rows_ != b.rows_ || a.cols_ != b.cols_) return;
+    if (&dst != &a && &dst != &b) {
+        dst.create(a.rows_, a.cols_);
+    }
+
+    const size_t n = a.words_.size();
+    const uint64_t* pa = a.words_.data();
+    const uint64_t* pb = b.words_.data();
+    uint64_t* pd = dst.words_.data();
+    size_t i = 0;
+#ifdef BIT_MASK_USE_NEON
+    for (; i + 2 <= n; i += 2) {
+        vst1q_u64(pd + i, vorrq_u64(vld1q_u64(pa + i), vld1q_u64(pb + i)));
+    }
+#endif
+    for (; i < n; ++i) {
+        pd[i] = pa[i] | pb[i];
+    }
+}
+
+} // namespace DotCardDetect
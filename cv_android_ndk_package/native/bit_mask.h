@@ -0,0 +1,150 @@
+#ifndef BIT_MASK_H
+#define BIT_MASK_H
+
+#include "dot_card_detect.h"
+#include <cstdint>
+#include <vector>
+
+namespace DotCardDetect {
+
+// 位压缩二值掩码：每像素1位，每行按64像素一个字对齐存储
+// 流水线中的掩码只有0/255两种取值，按位存储后内存与带宽降为CV_8UC1的1/8，
+// 区域计数用popcount完成
+class BitMask {
+public:
+    BitMask();
+    BitMask(int rows, int cols);
+
+    /**
+     * 重新分配并清零
+     * @param rows 行数
+     * @param cols 列数
+     */
+    void create(int rows, int cols);
+
+    /**
+     * 由8位掩码打包（非零即置位）
+     * @param mask CV_8UC1掩码
+     * @return 位掩码
+     */
+    static BitMask fromMat(const cv::Mat& mask);
+
+    /**
+     * 由8位掩码打包到当前对象，尺寸不变时复用存储
+     * @param mask CV_8UC1掩码
+     */
+    void assign(const cv::Mat& mask);
+
+    /**
+     * 将8位掩码打包到第y0行起的若干行，尺寸需已由create设定且列数一致
+     * 不同调用写入互不重叠的行时可并发执行
+     * @param mask CV_8UC1掩码（若干行）
+     * @param y0 目标起始行
+     */
+    void packRows(const cv::Mat& mask, int y0);
+
+    /**
+     * 展开为8位掩码（置位为255）
+     * @return CV_8UC1掩码
+     */
+    cv::Mat toMat() const;
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    bool empty() const { return rows_ == 0 || cols_ == 0; }
+    size_t wordsPerRow() const { return wordsPerRow_; }
+
+    const uint64_t* row(int y) const { return words_.data() + static_cast<size_t>(y) * wordsPerRow_; }
+    uint64_t* row(int y) { return words_.data() + static_cast<size_t>(y) * wordsPerRow_; }
+
+    bool test(int x, int y) const {
+        return (row(y)[x >> 6] >> (x & 63)) & 1ULL;
+    }
+
+    void set(int x, int y) {
+        row(y)[x >> 6] |= 1ULL << (x & 63);
+    }
+
+    /**
+     * 将第y行[x0, x1)置位
+     */
+    void setSpan(int y, int x0, int x1);
+
+    /**
+     * 统计第y行[x0, x1)内置位的像素数
+     */
+    int countSpan(int y, int x0, int x1) const;
+
+    /**
+     * 统计矩形区域内置位的像素数（矩形会被裁剪到掩码范围内）
+     */
+    int countRect(const cv::Rect& rect) const;
+
+    // 统计全部置位像素数
+    int count() const;
+
+    // 原地按位与/或，两个掩码尺寸需一致
+    void andWith(const BitMask& other);
+    void orWith(const BitMask& other);
+
+    // 按位与/或，dst可以与a或b相同
+    static void bitwiseAnd(const BitMask& a, const BitMask& b, BitMask& dst);
+    static void bitwiseOr(const BitMask& a, const BitMask& b, BitMask& dst);
+
+    /**
+     * 遍历第y行中连续置位的区间
+     * @param y 行号
+     * @param f 回调 f(y, x0, x1)，区间为[x0, x1)
+     */
+    template <typename F>
+    void forEachSpanInRow(int y, F&& f) const {
+        const uint64_t* words = row(y);
+        int start = -1;
+        for (size_t i = 0; i < wordsPerRow_; ++i) {
+            uint64_t word = words[i];
+            const int base = static_cast<int>(i << 6);
+            if (start < 0 && word == 0) continue;
+            if (start >= 0 && word == ~0ULL) continue;
+
+            int bit = 0;
+            while (bit < 64) {
+                if (start < 0) {
+                    uint64_t ones = word >> bit;
+                    if (ones == 0) break;
+                    bit += __builtin_ctzll(ones);
+                    start = base + bit;
+                } else {
+                    uint64_t zeros = ~word >> bit;
+                    if (zeros == 0) break;
+                    bit += __builtin_ctzll(zeros);
+                    f(y, start, base + bit);
+                    start = -1;
+                }
+            }
+        }
+        if (start >= 0) {
+            f(y, start, cols_);
+        }
+    }
+
+    /**
+     * 遍历全部连续置位的行区间
+     * @param f 回调 f(y, x0, x1)，区间为[x0, x1)
+     */
+    template <typename F>
+    void forEachSpan(F&& f) const {
+        for (int y = 0; y < rows_; ++y) {
+            forEachSpanInRow(y, f);
+        }
+    }
+
+private:
+    int rows_;
+    int cols_;
+    size_t wordsPerRow_;
+    std::vector<uint64_t> words_;
+};
+
+} // namespace DotCardDetect
+
+#endif // BIT_MASK_H
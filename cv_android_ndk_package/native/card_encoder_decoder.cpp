@@ -4,8 +4,98 @@
 #include <memory>
 #include <set>
 
+namespace {
+
+// Confusion model: probability of reading a dot as its own color, as its hue neighbour,
+// and as each of the remaining colors
+constexpr float CONFUSION_SAME = 0.90f;
+constexpr float CONFUSION_NEIGHBOR = 0.07f;
+constexpr float CONFUSION_OTHER = 0.0075f;
+
+// Any digit outside 0..NUM_COLORS-1 is unreadable
+std::array<int, 4> normalizeObserved(const std::array<int, 4>& digits) {
+    std::array<int, 4> observed;
+    for (int pos = 0; pos < 4; ++pos) {
+        int digit = digits[pos];
+        observed[pos] = (digit >= 0 && digit < CardEncoderDecoder::NUM_COLORS) ? digit : CardEncoderDecoder::UNKNOWN_COLOR;
+    }
+    return observed;
+}
+
+// P(observed | codeword); an unreadable digit is equally likely under every color and drops out
+float codeLikelihood(const std::array<int, 4>& observed, const std::array<int, 4>& code) {
+    float likelihood = 1.0f;
+    for (int pos = 0; pos < 4; ++pos) {
+        if (observed[pos] != CardEncoderDecoder::UNKNOWN_COLOR) {
+            likelihood *= CardEncoderDecoder::confusionProbability(observed[pos], code[pos]);
+        }
+    }
+    return likelihood;
+}
+
+// Substituted or unreadable digits
+int codeDistance(const std::array<int, 4>& observed, const std::array<int, 4>& code) {
+    int distance = 0;
+    for (int pos = 0; pos < 4; ++pos) {
+        if (observed[pos] != code[pos]) ++distance;
+    }
+    return distance;
+}
+
+int observedIndex(const std::array<int, 4>& digits) {
+    int index = 0;
+    for (int digit : digits) {
+        int symbol = (digit >= 0 && digit < CardEncoderDecoder::NUM_COLORS) ? digit : CardEncoderDecoder::UNKNOWN_COLOR;
+        index = index * CardEncoderDecoder::NUM_OBSERVED_SYMBOLS + symbol;
+    }
+    return index;
+}
+
+// Canonical readings of a corner observation, precomputed once. The observation is flattened to
+// eight slots, direction * 2 + (0 near, 1 far). Orientation q reads its counter-clockwise edge q+2
+// then its clockwise edge q+1, so any rotation of the card yields the same code and reading the
+// edges the other way round (a reflection) yields the mirror, i.e. the same card in the other group.
+// An opposite pair reads edge q+2 then edge q. Near/far come from the colors' pixel shares rather
+// than their distance, so each reading also has variants with the pair swapped on one or both edges.
+// Readings are grouped in tiers tried in order: adjacent, adjacent swapped, opposite, opposite swapped.
+struct CanonicalReading {
+    int tier;
+    int orientation;
+    int mask;                   // directions that must be populated
+    std::array<int, 4> slots;   // observed slot of each code digit
+};
+
+constexpr int NUM_READING_TIERS = 4;
+constexpr int NUM_READINGS = 32;
+
+constexpr std::array<CanonicalReading, NUM_READINGS> buildReadingTable() {
+    std::array<CanonicalReading, NUM_READINGS> table{};
+    int n = 0;
+    for (int tier = 0; tier < NUM_READING_TIERS; ++tier) {
+        const bool opposite = tier >= 2;
+        const bool swapped = tier % 2 == 1;
+        for (int swap = swapped ? 1 : 0; swap <= (swapped ? 3 : 0); ++swap) {
+            for (int q = 0; q < 4; ++q) {
+                const int first = (q + 2) % 4;
+                const int second = opposite ? q : (q + 1) % 4;
+                const int swapFirst = swap & 1;
+                const int swapSecond = (swap >> 1) & 1;
+                table[n++] = {tier, q, (1 << first) | (1 << second),
+                              {first * 2 + swapFirst, first * 2 + 1 - swapFirst,
+                               second * 2 + swapSecond, second * 2 + 1 - swapSecond}};
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<CanonicalReading, NUM_READINGS> READING_TABLE = buildReadingTable();
+
+} // namespace
+
 CardEncoderDecoder::CardEncoderDecoder() {
     initializeEncodings();
+    initializeNeighborTable();
 }
 
 std::string CardEncoderDecoder::Encoding::toString() const {
@@ -16,26 +106,13 @@ std::string CardEncoderDecoder::Encoding::toString() const {
 }
 
 CardEncoderDecoder::DecodeResult CardEncoderDecoder::decodeEncoding(const std::array<int, 4>& encoding) const {
-    if (!isValidEncoding(encoding)) {
+    int index = codeIndex(encoding[0], encoding[1], encoding[2], encoding[3]);
+    if (index < 0 || codeTable_[index].cardId < 0) {
         return DecodeResult();
     }
     
-    Encoding enc(encoding);
-    std::string key = enc.toString();
-    
-    // Try A-group first
-    auto aIt = aGroupMap_.find(key);
-    if (aIt != aGroupMap_.end()) {
-        return DecodeResult(aIt->second, GroupType::GROUP_A);
-    }
-    
-    // Try B-group
-    auto bIt = bGroupMap_.find(key);
-    if (bIt != bGroupMap_.end()) {
-        return DecodeResult(bIt->second, GroupType::GROUP_B);
-    }
-    
-    return DecodeResult();
+    const CodeEntry& entry = codeTable_[index];
+    return DecodeResult(entry.cardId, entry.groupType);
 }
 
 CardEncoderDecoder::DecodeResult CardEncoderDecoder::decodeEncoding(int a, int b, int c, int d) const {
@@ -43,15 +120,11 @@ CardEncoderDecoder::DecodeResult CardEncoderDecoder::decodeEncoding(int a, int b
 }
 
 int CardEncoderDecoder::decodeAGroup(const std::array<int, 4>& encoding) const {
-    if (!isValidEncoding(encoding)) {
+    int index = codeIndex(encoding[0], encoding[1], encoding[2], encoding[3]);
+    if (index < 0 || codeTable_[index].groupType != GroupType::GROUP_A) {
         return -1;
     }
-    
-    Encoding enc(encoding);
-    std::string key = enc.toString();
-    
-    auto it = aGroupMap_.find(key);
-    return (it != aGroupMap_.end()) ? it->second : -1;
+    return codeTable_[index].cardId;
 }
 
 int CardEncoderDecoder::decodeAGroup(int a, int b, int c, int d) const {
@@ -59,21 +132,145 @@ int CardEncoderDecoder::decodeAGroup(int a, int b, int c, int d) const {
 }
 
 int CardEncoderDecoder::decodeBGroup(const std::array<int, 4>& encoding) const {
-    if (!isValidEncoding(encoding)) {
+    int index = codeIndex(encoding[0], encoding[1], encoding[2], encoding[3]);
+    if (index < 0 || codeTable_[index].groupType != GroupType::GROUP_B) {
         return -1;
     }
-    
-    Encoding enc(encoding);
-    std::string key = enc.toString();
-    
-    auto it = bGroupMap_.find(key);
-    return (it != bGroupMap_.end()) ? it->second : -1;
+    return codeTable_[index].cardId;
 }
 
 int CardEncoderDecoder::decodeBGroup(int a, int b, int c, int d) const {
     return decodeBGroup({a, b, c, d});
 }
 
+CardEncoderDecoder::OrientedDecodeResult CardEncoderDecoder::decodeObservation(
+    const std::array<int, 4>& nearColors, const std::array<int, 4>& farColors) const {
+    // Flatten to slots; a single detected color fills both dots of that edge
+    std::array<int, 8> slots;
+    int mask = 0;
+    for (int d = 0; d < 4; ++d) {
+        slots[d * 2] = nearColors[d];
+        slots[d * 2 + 1] = farColors[d] >= 0 ? farColors[d] : nearColors[d];
+        if (nearColors[d] >= 0) {
+            mask |= 1 << d;
+        }
+    }
+    
+    // The first tier with an accepted reading decides. Its accepted readings vote for their cards
+    // with their confidence; the winning card needs MIN_DECODE_MARGIN times the runner-up's votes,
+    // otherwise the observation is ambiguous. Within the winner the group A reading is preferred,
+    // then the more confident one, then table order.
+    struct Vote {
+        const TolerantDecodeResult* entry;
+        int orientation;
+    };
+    std::array<Vote, NUM_READINGS> votes;
+    int voteCount = 0;
+    for (int i = 0; i < NUM_READINGS && voteCount == 0; ) {
+        const int tier = READING_TABLE[i].tier;
+        for (; i < NUM_READINGS && READING_TABLE[i].tier == tier; ++i) {
+            const CanonicalReading& reading = READING_TABLE[i];
+            if ((mask & reading.mask) != reading.mask) continue;
+            const auto& order = reading.slots;
+            const TolerantDecodeResult& entry =
+                neighborTable_[observedIndex({slots[order[0]], slots[order[1]], slots[order[2]], slots[order[3]]})];
+            if (entry.success) {
+                votes[voteCount++] = {&entry, reading.orientation};
+            }
+        }
+    }
+    
+    int bestCard = -1;
+    float bestVotes = 0.0f;
+    float runnerUpVotes = 0.0f;
+    for (int i = 0; i < voteCount; ++i) {
+        const int cardId = votes[i].entry->cardId;
+        bool counted = false;
+        for (int j = 0; j < i && !counted; ++j) counted = votes[j].entry->cardId == cardId;
+        if (counted) continue;
+        
+        float total = 0.0f;
+        for (int j = i; j < voteCount; ++j) {
+            if (votes[j].entry->cardId == cardId) total += votes[j].entry->confidence;
+        }
+        if (total > bestVotes) {
+            runnerUpVotes = bestVotes;
+            bestVotes = total;
+            bestCard = cardId;
+        } else if (total > runnerUpVotes) {
+            runnerUpVotes = total;
+        }
+    }
+    
+    OrientedDecodeResult result;
+    if (bestCard < 0 || bestVotes < MIN_DECODE_MARGIN * runnerUpVotes) {
+        return result;
+    }
+    for (int i = 0; i < voteCount; ++i) {
+        const TolerantDecodeResult& entry = *votes[i].entry;
+        if (entry.cardId != bestCard) continue;
+        if (result.success) {
+            if (entry.groupType != result.groupType) {
+                if (entry.groupType != GROUP_A) continue;
+            } else if (entry.confidence <= result.confidence) {
+                continue;
+            }
+        }
+        result.cardId = entry.cardId;
+        result.groupType = entry.groupType;
+        result.orientation = votes[i].orientation;
+        result.confidence = entry.confidence;
+        result.success = true;
+    }
+    return result;
+}
+
+CardEncoderDecoder::TolerantDecodeResult CardEncoderDecoder::decodeTolerant(const std::array<int, 4>& observed) const {
+    return neighborTable_[observedIndex(observed)];
+}
+
+CardEncoderDecoder::TolerantDecodeResult CardEncoderDecoder::decodeTolerant(int a, int b, int c, int d) const {
+    return decodeTolerant({a, b, c, d});
+}
+
+CardEncoderDecoder::OrientedDecodeResult CardEncoderDecoder::decodeCombined(
+    const std::array<int, 4>* observations, int count) const {
+    OrientedDecodeResult result;
+    if (!observations || count <= 0) {
+        return result;
+    }
+    
+    int bestObservation = -1;
+    TolerantDecodeResult best = scoreCandidates(observations, count, &bestObservation);
+    if (best.success) {
+        result.cardId = best.cardId;
+        result.groupType = best.groupType;
+        result.orientation = bestObservation;
+        result.confidence = best.confidence;
+        result.success = true;
+    }
+    return result;
+}
+
+float CardEncoderDecoder::confusionProbability(int observed, int actual) {
+    if (observed == actual) {
+        return CONFUSION_SAME;
+    }
+    // Hue neighbours share a pair: Red/Yellow, Green/Cyan, Blue/Indigo
+    if ((observed ^ 1) == actual) {
+        return CONFUSION_NEIGHBOR;
+    }
+    return CONFUSION_OTHER;
+}
+
+int CardEncoderDecoder::codeIndex(int a, int b, int c, int d) {
+    if (a < 0 || a >= NUM_COLORS || b < 0 || b >= NUM_COLORS ||
+        c < 0 || c >= NUM_COLORS || d < 0 || d >= NUM_COLORS) {
+        return -1;
+    }
+    return ((a * NUM_COLORS + b) * NUM_COLORS + c) * NUM_COLORS + d;
+}
+
 std::unique_ptr<CardEncoderDecoder::CardInfo> CardEncoderDecoder::getCardInfo(int cardId) const {
     auto it = cardInfoMap_.find(cardId);
     if (it != cardInfoMap_.end()) {
@@ -120,17 +317,19 @@ bool CardEncoderDecoder::isValidEncoding(const std::array<int, 4>& encoding) {
 
 void CardEncoderDecoder::initializeEncodings() {
     std::vector<Encoding> validEncodings = generateValidEncodings();
+    codeTable_.fill(CodeEntry{-1, GroupType::GROUP_A});
+    cardCodes_.assign(validEncodings.size() + 1, {});
     
     int cardId = 1;
     for (const auto& encoding : validEncodings) {
         Encoding mirrorEncoding = createMirror(encoding);
         
         // Store A-group and B-group mappings
-        std::string aKey = encoding.toString();
-        std::string bKey = mirrorEncoding.toString();
-        
-        aGroupMap_[aKey] = cardId;
-        bGroupMap_[bKey] = cardId;
+        const auto& a = encoding.digits;
+        const auto& b = mirrorEncoding.digits;
+        codeTable_[codeIndex(a[0], a[1], a[2], a[3])] = CodeEntry{cardId, GroupType::GROUP_A};
+        codeTable_[codeIndex(b[0], b[1], b[2], b[3])] = CodeEntry{cardId, GroupType::GROUP_B};
+        cardCodes_[cardId] = {a, b};
         
         // Store card info
         CardInfo cardInfo;
@@ -146,6 +345,108 @@ void CardEncoderDecoder::initializeEncodings() {
     }
 }
 
+void CardEncoderDecoder::initializeNeighborTable() {
+    neighborTable_.assign(NUM_OBSERVED_CODES, TolerantDecodeResult());
+    for (int index = 0; index < NUM_OBSERVED_CODES; ++index) {
+        std::array<int, 4> observed;
+        for (int pos = 3, rest = index; pos >= 0; --pos, rest /= NUM_OBSERVED_SYMBOLS) {
+            observed[pos] = rest % NUM_OBSERVED_SYMBOLS;
+        }
+        neighborTable_[index] = scoreCandidates(&observed, 1, nullptr);
+    }
+}
+
+CardEncoderDecoder::TolerantDecodeResult CardEncoderDecoder::scoreCandidates(
+    const std::array<int, 4>* observations, int count, int* bestObservation) const {
+    // Usable readings (at most one unreadable digit) and the cards within distance 1 of any of them:
+    // the code itself plus single substitutions, or every fill of the single unreadable digit
+    std::vector<std::array<int, 4>> readings;
+    std::vector<int> readingIndex;
+    std::vector<int> candidates;
+    auto addCandidate = [&](const std::array<int, 4>& code) {
+        int cardId = codeTable_[codeIndex(code[0], code[1], code[2], code[3])].cardId;
+        if (cardId >= 0) candidates.push_back(cardId);
+    };
+    for (int i = 0; i < count; ++i) {
+        std::array<int, 4> observed = normalizeObserved(observations[i]);
+        int unknownCount = 0;
+        int unknownPos = -1;
+        for (int pos = 0; pos < 4; ++pos) {
+            if (observed[pos] == UNKNOWN_COLOR) {
+                ++unknownCount;
+                unknownPos = pos;
+            }
+        }
+        if (unknownCount > 1) {
+            continue;
+        }
+        readings.push_back(observed);
+        readingIndex.push_back(i);
+        
+        if (unknownCount == 0) {
+            addCandidate(observed);
+        }
+        for (int pos = 0; pos < 4; ++pos) {
+            if (unknownCount == 1 && pos != unknownPos) continue;
+            for (int color = 0; color < NUM_COLORS; ++color) {
+                if (color == observed[pos]) continue;
+                std::array<int, 4> candidate = observed;
+                candidate[pos] = color;
+                addCandidate(candidate);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    
+    // Likelihood of all readings under each card: a reading may show either codeword of the card,
+    // and independent readings multiply
+    TolerantDecodeResult best;
+    float total = 0.0f;
+    float bestLikelihood = 0.0f;
+    float runnerUp = 0.0f;
+    for (int cardId : candidates) {
+        const auto& codes = cardCodes_[cardId];
+        float likelihood = 1.0f;
+        for (const auto& observed : readings) {
+            likelihood *= codeLikelihood(observed, codes[GROUP_A]) + codeLikelihood(observed, codes[GROUP_B]);
+        }
+        total += likelihood;
+        if (likelihood > bestLikelihood) {
+            runnerUp = bestLikelihood;
+            bestLikelihood = likelihood;
+            best.cardId = cardId;
+        } else if (likelihood > runnerUp) {
+            runnerUp = likelihood;
+        }
+    }
+    
+    if (best.cardId < 0 || total <= 0.0f ||
+        bestLikelihood < MIN_DECODE_CONFIDENCE * total || bestLikelihood < MIN_DECODE_MARGIN * runnerUp) {
+        return TolerantDecodeResult();
+    }
+    
+    // Each reading is matched to the card's nearer codeword; the reading needing the fewest
+    // corrections (the earliest on a tie) gives the reported group and observation index
+    const auto& codes = cardCodes_[best.cardId];
+    int fewest = 5;
+    best.distance = 0;
+    for (size_t i = 0; i < readings.size(); ++i) {
+        int distanceA = codeDistance(readings[i], codes[GROUP_A]);
+        int distanceB = codeDistance(readings[i], codes[GROUP_B]);
+        int distance = std::min(distanceA, distanceB);
+        best.distance += distance;
+        if (distance < fewest) {
+            fewest = distance;
+            best.groupType = distanceB < distanceA ? GROUP_B : GROUP_A;
+            if (bestObservation) *bestObservation = readingIndex[i];
+        }
+    }
+    best.confidence = bestLikelihood / total;
+    best.success = true;
+    return best;
+}
+
 std::vector<CardEncoderDecoder::Encoding> CardEncoderDecoder::generateValidEncodings() const {
     std::vector<Encoding> validEncodings;
     std::set<std::string> processedEncodings;
@@ -11,6 +11,25 @@ public:
 
     enum ColorIndex { RED=0, YELLOW=1, GREEN=2, CYAN=3, BLUE=4, INDIGO=5 };
     enum GroupType { GROUP_A=0, GROUP_B=1 };
+    // Extension directions around a corner mark, clockwise
+    enum Direction { DIR_UP=0, DIR_RIGHT=1, DIR_DOWN=2, DIR_LEFT=3 };
+
+    // Number of distinct 4-digit codes (NUM_COLORS^4)
+    static constexpr int NUM_CODES = NUM_COLORS * NUM_COLORS * NUM_COLORS * NUM_COLORS;
+
+    // Observed digit for an unreadable dot; observed codes use NUM_COLORS + 1 symbols per digit
+    static constexpr int UNKNOWN_COLOR = NUM_COLORS;
+    static constexpr int NUM_OBSERVED_SYMBOLS = NUM_COLORS + 1;
+    static constexpr int NUM_OBSERVED_CODES =
+        NUM_OBSERVED_SYMBOLS * NUM_OBSERVED_SYMBOLS * NUM_OBSERVED_SYMBOLS * NUM_OBSERVED_SYMBOLS;
+
+    // Acceptance rule shared by every nearest-codeword decode: the chosen card needs at least
+    // MIN_DECODE_CONFIDENCE of the posterior and MIN_DECODE_MARGIN times the runner-up's likelihood.
+    // 1260 of the 1296 codes are valid codewords, so a single reading has no redundancy: the fills of
+    // one unreadable digit are equally likely cards and a hue substitution reads as another card's
+    // exact code. Both are only resolved by combining several readings (see decodeCombined).
+    static constexpr float MIN_DECODE_CONFIDENCE = 0.5f;
+    static constexpr float MIN_DECODE_MARGIN = 4.0f;
 
     struct Encoding {
         std::array<int, 4> digits;
@@ -28,6 +47,30 @@ public:
         DecodeResult(int id, GroupType gt) : cardId(id), groupType(gt), success(true) {}
     };
 
+    // Orientation is the corner the mark occupies in image space, taken from the edge pair the code was
+    // read from: 0={R,D} top-left, 1={D,L} top-right, 2={L,U} bottom-right, 3={U,R} bottom-left.
+    // An opposite pair reads edge q+2 then edge q: 0=D,U  1=L,R  2=U,D  3=R,L
+    struct OrientedDecodeResult {
+        int cardId;
+        GroupType groupType;
+        int orientation;
+        float confidence;
+        bool success;
+        OrientedDecodeResult() : cardId(-1), groupType(GROUP_A), orientation(-1), confidence(0.0f), success(false) {}
+    };
+
+    // Nearest-codeword result; distance counts substituted or unreadable digits,
+    // confidence is the posterior share of the chosen card among all cards within distance 1.
+    // success requires the shared acceptance rule above.
+    struct TolerantDecodeResult {
+        int cardId;
+        GroupType groupType;
+        int distance;
+        float confidence;
+        bool success;
+        TolerantDecodeResult() : cardId(-1), groupType(GROUP_A), distance(-1), confidence(0.0f), success(false) {}
+    };
+
     struct CardInfo {
         int cardId;
         Encoding groupA;
@@ -46,6 +89,34 @@ public:
     int decodeBGroup(const std::array<int,4>& encoding) const;
     int decodeBGroup(int a, int b, int c, int d) const;
 
+    // Decode a corner observation; near/far colors are indexed by Direction, -1 where nothing was seen.
+    // Every canonical reading of the observation (each orientation's adjacent edge pair read
+    // counter-clockwise edge first, opposite pairs, and near/far-swapped variants as a fallback)
+    // is precomputed once as a slot permutation and looked up in the nearest-codeword table.
+    // Readings that decode vote for their card; a card without a clear majority fails as ambiguous.
+    // A rotated card reports the rotated orientation; a reflected one reports the other group.
+    OrientedDecodeResult decodeObservation(const std::array<int,4>& nearColors,
+                                           const std::array<int,4>& farColors) const;
+
+    // Decode allowing one misread or unreadable digit (any value outside 0..NUM_COLORS-1 is unreadable).
+    // A lone reading with an unreadable digit is ambiguous and fails; use decodeCombined.
+    TolerantDecodeResult decodeTolerant(const std::array<int,4>& observed) const;
+    TolerantDecodeResult decodeTolerant(int a, int b, int c, int d) const;
+
+    // Decode several readings of the same card (e.g. its four corners) jointly: per-card likelihoods
+    // multiply across readings, so a reading with one unreadable digit is resolved by the others and
+    // readings that disagree by a substitution fail the margin instead of picking either card.
+    // Readings with more than one unreadable digit are skipped. orientation is the index of the
+    // reading that best supports the card; pass corner readings in orientation order (TL, TR, BR, BL).
+    OrientedDecodeResult decodeCombined(const std::array<int,4>* observations, int count) const;
+
+    // Index of a valid encoding in the canonical code table, -1 if a digit is out of range
+    static int codeIndex(int a, int b, int c, int d);
+
+    // P(observed color | printed color) used to weight nearest-codeword candidates.
+    // Hue neighbours Red/Yellow, Green/Cyan and Blue/Indigo are the likely confusions.
+    static float confusionProbability(int observed, int actual);
+
     std::unique_ptr<CardInfo> getCardInfo(int cardId) const;
     int getTotalCards() const;
     static std::string getColorName(int colorIndex);
@@ -55,10 +126,27 @@ public:
 
 private:
     void initializeEncodings();
+    void initializeNeighborTable();
     std::vector<Encoding> generateValidEncodings() const;
     std::vector<std::string> encodingToColors(const Encoding& encoding) const;
 
-    std::map<std::string, int> aGroupMap_;
-    std::map<std::string, int> bGroupMap_;
+    // Posterior over the cards within distance 1 of the readings, with the acceptance rule applied;
+    // bestObservation receives the index of the reading most likely under the chosen card
+    TolerantDecodeResult scoreCandidates(const std::array<int,4>* observations, int count,
+                                         int* bestObservation) const;
+
+    // Flat code -> (cardId, group) table, built once; palindromes keep cardId -1
+    struct CodeEntry {
+        int cardId;
+        GroupType groupType;
+    };
+    std::array<CodeEntry, NUM_CODES> codeTable_;
+
+    // A/B codewords indexed by cardId (entry 0 unused)
+    std::vector<std::array<std::array<int,4>, 2>> cardCodes_;
+
+    // Nearest-codeword decode of every single observed code, precomputed with scoreCandidates
+    std::vector<TolerantDecodeResult> neighborTable_;
+
     std::map<int, CardInfo> cardInfoMap_;
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <memory>
 #include <array>
 #include <string>
+#include <vector>
 
 // Version information
 static const char* CARD_DECODER_VERSION = "1.0.0";
@@ -45,6 +46,76 @@ DecodeResult card_decode_encoding(CardDecoderHandle handle, int a, int b, int c,
     return result;
 }
 
+OrientedDecodeResult card_decode_observation(CardDecoderHandle handle,
+                                             const int near_colors[4], const int far_colors[4]) {
+    OrientedDecodeResult result = {-1, -1, -1, 0.0f, 0};
+    
+    if (!handle || !near_colors || !far_colors) {
+        return result;
+    }
+    
+    CardEncoderDecoder* decoder = static_cast<CardEncoderDecoder*>(handle);
+    std::array<int, 4> nearColors = {near_colors[0], near_colors[1], near_colors[2], near_colors[3]};
+    std::array<int, 4> farColors = {far_colors[0], far_colors[1], far_colors[2], far_colors[3]};
+    auto cppResult = decoder->decodeObservation(nearColors, farColors);
+    
+    if (cppResult.success) {
+        result.card_id = cppResult.cardId;
+        result.group_type = (cppResult.groupType == CardEncoderDecoder::GroupType::GROUP_A) ? 0 : 1;
+        result.orientation = cppResult.orientation;
+        result.confidence = cppResult.confidence;
+        result.success = 1;
+    }
+    
+    return result;
+}
+
+TolerantDecodeResult card_decode_tolerant(CardDecoderHandle handle, int a, int b, int c, int d) {
+    TolerantDecodeResult result = {-1, -1, -1, 0.0f, 0};
+    
+    if (!handle) {
+        return result;
+    }
+    
+    CardEncoderDecoder* decoder = static_cast<CardEncoderDecoder*>(handle);
+    auto cppResult = decoder->decodeTolerant(a, b, c, d);
+    
+    if (cppResult.success) {
+        result.card_id = cppResult.cardId;
+        result.group_type = (cppResult.groupType == CardEncoderDecoder::GroupType::GROUP_A) ? 0 : 1;
+        result.distance = cppResult.distance;
+        result.confidence = cppResult.confidence;
+        result.success = 1;
+    }
+    
+    return result;
+}
+
+OrientedDecodeResult card_decode_combined(CardDecoderHandle handle, const int codes[][4], int count) {
+    OrientedDecodeResult result = {-1, -1, -1, 0.0f, 0};
+    
+    if (!handle || !codes || count <= 0) {
+        return result;
+    }
+    
+    CardEncoderDecoder* decoder = static_cast<CardEncoderDecoder*>(handle);
+    std::vector<std::array<int, 4>> observations(count);
+    for (int i = 0; i < count; ++i) {
+        observations[i] = {codes[i][0], codes[i][1], codes[i][2], codes[i][3]};
+    }
+    auto cppResult = decoder->decodeCombined(observations.data(), count);
+    
+    if (cppResult.success) {
+        result.card_id = cppResult.cardId;
+        result.group_type = (cppResult.groupType == CardEncoderDecoder::GroupType::GROUP_A) ? 0 : 1;
+        result.orientation = cppResult.orientation;
+        result.confidence = cppResult.confidence;
+        result.success = 1;
+    }
+    
+    return result;
+}
+
 int card_decode_a_group(CardDecoderHandle handle, int a, int b, int c, int d) {
     if (!handle) {
         return -1;
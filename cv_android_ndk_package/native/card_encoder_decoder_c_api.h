@@ -13,6 +13,23 @@ typedef struct {
     int success;    // 1 success, 0 fail
 } DecodeResult;
 
+typedef struct {
+    int card_id;
+    int group_type;  // 0=A,1=B,-1 fail
+    int orientation; // 0=top-left {R,D}, 1=top-right {D,L}, 2=bottom-right {L,U}, 3=bottom-left {U,R}, -1 fail
+                     // (opposite pairs: 0=D,U 1=L,R 2=U,D 3=R,L, first edge read first)
+    float confidence; // posterior share of the card among cards within distance 1, 0..1
+    int success;     // 1 success, 0 fail
+} OrientedDecodeResult;
+
+typedef struct {
+    int card_id;
+    int group_type;   // 0=A,1=B,-1 fail
+    int distance;     // misread or unreadable digits corrected, -1 fail
+    float confidence; // posterior share of the card among codewords within distance 1, 0..1
+    int success;      // 1 success, 0 fail
+} TolerantDecodeResult;
+
 typedef struct {
     int card_id;
     int group_a[4];
@@ -23,6 +40,15 @@ CardDecoderHandle card_decoder_create();
 void card_decoder_destroy(CardDecoderHandle handle);
 
 DecodeResult card_decode_encoding(CardDecoderHandle handle, int a, int b, int c, int d);
+// near_colors/far_colors are indexed U,R,D,L; -1 where the direction has no color
+OrientedDecodeResult card_decode_observation(CardDecoderHandle handle,
+                                             const int near_colors[4], const int far_colors[4]);
+// Nearest-codeword decode; digits outside 0..5 are treated as unreadable.
+// A single reading with an unreadable digit is ambiguous and fails; see card_decode_combined.
+TolerantDecodeResult card_decode_tolerant(CardDecoderHandle handle, int a, int b, int c, int d);
+// Joint decode of count readings of the same card (e.g. its corners in TL, TR, BR, BL order);
+// orientation is the index of the reading that best supports the decoded card
+OrientedDecodeResult card_decode_combined(CardDecoderHandle handle, const int codes[][4], int count);
 int card_decode_a_group(CardDecoderHandle handle, int a, int b, int c, int d);
 int card_decode_b_group(CardDecoderHandle handle, int a, int b, int c, int d);
 int card_get_info(CardDecoderHandle handle, int card_id, CardInfo* info);
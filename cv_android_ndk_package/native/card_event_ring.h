@@ -0,0 +1,77 @@
+#ifndef CARD_EVENT_RING_H
+#define CARD_EVENT_RING_H
+
+#include "detect_decode_api.h"
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace DotCardDetect {
+
+// 卡片增量事件的单生产者/单消费者环形缓冲区：
+// 处理线程调用push，UI线程每帧调用pop一次，双方均不加锁
+class CardEventRing {
+public:
+    /**
+     * @param capacity 容量（向上取整为2的幂）
+     */
+    explicit CardEventRing(size_t capacity = 256) : head_(0), tail_(0), lost_(false) {
+        size_t size = 1;
+        while (size < capacity) size <<= 1;
+        buffer_.resize(size);
+        mask_ = size - 1;
+    }
+
+    CardEventRing(const CardEventRing&) = delete;
+    CardEventRing& operator=(const CardEventRing&) = delete;
+
+    /**
+     * 生产者：写入一个事件，缓冲区已满时丢弃并标记丢失
+     * @return 是否写入
+     */
+    bool push(const CardEvent& event) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            lost_.store(true, std::memory_order_release);
+            return false;
+        }
+        buffer_[tail & mask_] = event;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * 消费者：取出至多maxEvents个事件
+     * @return 取出的事件数
+     */
+    int pop(CardEvent* out, int maxEvents) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        int n = 0;
+        while (head != tail && n < maxEvents) {
+            out[n++] = buffer_[head & mask_];
+            ++head;
+        }
+        head_.store(head, std::memory_order_release);
+        return n;
+    }
+
+    // 消费者：丢弃全部待取事件
+    void discard() {
+        head_.store(tail_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // 消费者：读取并清除丢失标记
+    bool takeLost() { return lost_.exchange(false, std::memory_order_acq_rel); }
+
+private:
+    std::vector<CardEvent> buffer_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;   // 消费者写
+    alignas(64) std::atomic<size_t> tail_;   // 生产者写
+    std::atomic<bool> lost_;
+};
+
+} // namespace DotCardDetect
+
+#endif // CARD_EVENT_RING_H
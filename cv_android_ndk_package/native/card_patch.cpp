@@ -0,0 +1,156 @@
+#include "card_patch.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace DotCardDetect {
+
+namespace {
+
+// 采样窗口内某颜色像素占比超过该值才认为识别到该颜色
+constexpr float CELL_COLOR_RATIO = 0.25f;
+
+std::vector<cv::Point2f> patchCorners(int patchSize, int margin) {
+    const float lo = static_cast<float>(margin);
+    const float hi = static_cast<float>(patchSize - 1 - margin);
+    return {cv::Point2f(lo, lo), cv::Point2f(hi, lo), cv::Point2f(hi, hi), cv::Point2f(lo, hi)};
+}
+
+// 估计mark平均边长（像素）
+float averageMarkSide(const Card& card, const std::vector<std::vector<cv::Point>>& rectangles) {
+    float total = 0.0f;
+    int count = 0;
+    for (int idx : card.cornerIndices) {
+        if (idx < 0 || idx >= static_cast<int>(rectangles.size())) continue;
+        cv::Rect rect = cv::boundingRect(rectangles[idx]);
+        total += 0.5f * static_cast<float>(rect.width + rect.height);
+        ++count;
+    }
+    return count > 0 ? total / count : 0.0f;
+}
+
+// 估计卡片平均边长（像素，按mark中心计）
+float averageCardSide(const std::vector<cv::Point2f>& corners) {
+    float total = 0.0f;
+    for (size_t i = 0; i < corners.size(); ++i) {
+        const cv::Point2f d = corners[(i + 1) % corners.size()] - corners[i];
+        total += std::sqrt(d.x * d.x + d.y * d.y);
+    }
+    return corners.empty() ? 0.0f : total / corners.size();
+}
+
+/**
+ * 统计图块中以center为中心的方形窗口内的主颜色
+ * @return 颜色ID，未识别为-1
+ */
+int sampleCell(const cv::Mat& patch, const ColorFrame& frame, cv::Point2f center, int halfSize) {
+    const int cx = cvRound(center.x);
+    const int cy = cvRound(center.y);
+    const int x0 = std::max(0, cx - halfSize);
+    const int x1 = std::min(patch.cols - 1, cx + halfSize);
+    const int y0 = std::max(0, cy - halfSize);
+    const int y1 = std::min(patch.rows - 1, cy + halfSize);
+    if (x1 < x0 || y1 < y0) return -1;
+
+    int counts[8] = {0};
+    const size_t colorCount = std::min<size_t>(frame.colorCount(), 8);
+    for (int y = y0; y <= y1; ++y) {
+        const uchar* row = patch.ptr<uchar>(y);
+        for (int x = x0; x <= x1; ++x) {
+            const uchar bits = row[x];
+            if (!bits) continue;
+            for (size_t i = 0; i < colorCount; ++i) {
+                counts[i] += (bits >> i) & 1;
+            }
+        }
+    }
+
+    const int cellArea = (x1 - x0 + 1) * (y1 - y0 + 1);
+    int best = -1;
+    for (size_t i = 0; i < colorCount; ++i) {
+        if (counts[i] > CELL_COLOR_RATIO * cellArea && (best < 0 || counts[i] > counts[best])) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best >= 0 ? frame.colorIds[best] : -1;
+}
+
+} // namespace
+
+cv::Mat buildCardPatch(const ColorFrame& frame,
+                       const std::vector<cv::Point2f>& corners,
+                       int patchSize,
+                       int margin) {
+    if (frame.empty() || corners.size() != 4 || patchSize <= 2 * margin + 1) {
+        return cv::Mat();
+    }
+
+    // 图块坐标 -> 图像坐标，逆向映射后按最近邻取颜色标签
+    cv::Mat H = cv::getPerspectiveTransform(patchCorners(patchSize, margin), corners);
+    if (H.empty()) return cv::Mat();
+    const double* h = H.ptr<double>();
+
+    cv::Mat patch = cv::Mat::zeros(patchSize, patchSize, CV_8UC1);
+    const size_t colorCount = std::min<size_t>(frame.colorCount(), 8);
+    for (int v = 0; v < patchSize; ++v) {
+        uchar* dst = patch.ptr<uchar>(v);
+        for (int u = 0; u < patchSize; ++u) {
+            const double w = h[6] * u + h[7] * v + h[8];
+            if (std::abs(w) < 1e-9) continue;
+            const int x = cvRound((h[0] * u + h[1] * v + h[2]) / w);
+            const int y = cvRound((h[3] * u + h[4] * v + h[5]) / w);
+            if (x < 0 || y < 0 || x >= frame.cols() || y >= frame.rows()) continue;
+
+            uchar bits = 0;
+            for (size_t i = 0; i < colorCount; ++i) {
+                if (frame.contains(i, x, y)) {
+                    bits |= static_cast<uchar>(1u << i);
+                }
+            }
+            dst[u] = bits;
+        }
+    }
+    return patch;
+}
+
+CardPatchObservation sampleCardPatch(const ColorFrame& frame,
+                                     const Card& card,
+                                     const std::vector<std::vector<cv::Point>>& rectangles) {
+    CardPatchObservation obs;
+    if (card.corners.size() != 4) return obs;
+
+    std::vector<cv::Point2f> corners;
+    for (const auto& pt : card.corners) {
+        corners.emplace_back(static_cast<float>(pt.x), static_cast<float>(pt.y));
+    }
+
+    const float markSide = averageMarkSide(card, rectangles);
+    const float cardSide = averageCardSide(corners);
+    if (markSide <= 0.0f || cardSide <= markSide) return obs;
+
+    cv::Mat patch = buildCardPatch(frame, corners);
+    if (patch.empty()) return obs;
+
+    // mark边长换算到图块坐标
+    const std::vector<cv::Point2f> anchors = patchCorners(CARD_PATCH_SIZE, CARD_PATCH_MARGIN);
+    const float patchSide = static_cast<float>(CARD_PATCH_SIZE - 1 - 2 * CARD_PATCH_MARGIN);
+    const float markPatch = markSide * patchSide / cardSide;
+    const int halfSize = std::max(1, cvRound(markPatch * CARD_CELL_HALF_SIZE));
+
+    for (int k = 0; k < 4; ++k) {
+        const cv::Point2f origin = anchors[k];
+        const cv::Point2f ccw = (anchors[(k + 3) % 4] - origin) * (1.0f / patchSide);
+        const cv::Point2f cw = (anchors[(k + 1) % 4] - origin) * (1.0f / patchSide);
+
+        auto& code = obs.cornerCodes[k];
+        code[0] = sampleCell(patch, frame, origin + ccw * (CARD_CELL_NEAR_DISTANCE * markPatch), halfSize);
+        code[1] = sampleCell(patch, frame, origin + ccw * (CARD_CELL_FAR_DISTANCE * markPatch), halfSize);
+        code[2] = sampleCell(patch, frame, origin + cw * (CARD_CELL_NEAR_DISTANCE * markPatch), halfSize);
+        code[3] = sampleCell(patch, frame, origin + cw * (CARD_CELL_FAR_DISTANCE * markPatch), halfSize);
+    }
+
+    obs.valid = true;
+    return obs;
+}
+
+} // namespace DotCardDetect
@@ -0,0 +1,62 @@
+#ifndef CARD_PATCH_H
+#define CARD_PATCH_H
+
+#include "color_frame.h"
+#include <array>
+#include <vector>
+
+namespace DotCardDetect {
+
+// 规范化卡片图块的边长与边距（角点mark中心映射到距图块边缘CARD_PATCH_MARGIN处）
+constexpr int CARD_PATCH_SIZE = 64;
+constexpr int CARD_PATCH_MARGIN = 8;
+
+// 角点编码色块的几何（以mark边长为单位）。暂定值：卡片印刷版式尚无规格，
+// 近/远色块中心取沿边方向1倍与2倍mark边长，需按实际卡片测量后校准
+constexpr float CARD_CELL_NEAR_DISTANCE = 1.0f;   // 近色块中心到角点mark中心
+constexpr float CARD_CELL_FAR_DISTANCE = 2.0f;    // 远色块中心到角点mark中心
+constexpr float CARD_CELL_HALF_SIZE = 0.35f;      // 采样窗口半宽，小于半个色块以避开色块边缘
+
+// 卡片四角的编码观测
+// 角点顺序为TL, TR, BR, BL（顺时针）；每个角点读取两条相邻边上的近/远色块，
+// 顺序为(逆时针边近色, 逆时针边远色, 顺时针边近色, 顺时针边远色)，未识别为-1
+struct CardPatchObservation {
+    std::array<std::array<int, 4>, 4> cornerCodes;
+    bool valid;
+
+    CardPatchObservation() : valid(false) {
+        for (auto& code : cornerCodes) {
+            code.fill(-1);
+        }
+    }
+};
+
+/**
+ * 将四角已知的卡片透视校正为规范化的颜色标签图块
+ * 每个图块像素为各颜色的位标志（第i位对应frame中的第i种颜色），最近邻采样
+ * @param frame 单帧颜色统计上下文
+ * @param corners 四个角点mark中心（TL, TR, BR, BL）
+ * @param patchSize 图块边长
+ * @param margin 角点到图块边缘的距离
+ * @return CV_8UC1标签图块，角点无效时返回空Mat
+ */
+cv::Mat buildCardPatch(const ColorFrame& frame,
+                       const std::vector<cv::Point2f>& corners,
+                       int patchSize = CARD_PATCH_SIZE,
+                       int margin = CARD_PATCH_MARGIN);
+
+/**
+ * 在规范化图块的固定位置采样每个角点的编码色块
+ * 色块中心位于角点沿两条相邻边方向CARD_CELL_NEAR_DISTANCE与CARD_CELL_FAR_DISTANCE倍mark边长处（暂定几何）
+ * @param frame 单帧颜色统计上下文
+ * @param card 四角卡片
+ * @param rectangles 检测到的mark轮廓（用于估计mark尺寸）
+ * @return 四角编码观测
+ */
+CardPatchObservation sampleCardPatch(const ColorFrame& frame,
+                                     const Card& card,
+                                     const std::vector<std::vector<cv::Point>>& rectangles);
+
+} // namespace DotCardDetect
+
+#endif // CARD_PATCH_H
@@ -0,0 +1,43 @@
+# Runs detect_decode_cli in batch mode and checks that stdout is pure JSON Lines:
+# every non-empty line must parse as one JSON object (diagnostics belong on stderr).
+#
+#   cmake -DCLI=path/to/detect_decode_cli -DINPUT=<dir|glob|list> [-DJOBS=4] -P check_batch_jsonl.cmake
+
+cmake_minimum_required(VERSION 3.19)  # string(JSON)
+
+if(NOT CLI OR NOT INPUT)
+    message(FATAL_ERROR "CLI and INPUT must be set")
+endif()
+if(NOT JOBS)
+    set(JOBS 4)
+endif()
+
+execute_process(
+    COMMAND ${CLI} --batch ${INPUT} -j ${JOBS}
+    OUTPUT_VARIABLE batch_stdout
+    RESULT_VARIABLE batch_result
+)
+if(NOT batch_result EQUAL 0 AND NOT batch_result EQUAL 3)
+    message(FATAL_ERROR "detect_decode_cli --batch failed with ${batch_result}")
+endif()
+
+# CMake lists split on ';', which may appear inside JSON strings
+string(REPLACE ";" "\\;" batch_stdout "${batch_stdout}")
+string(REPLACE "\n" ";" batch_lines "${batch_stdout}")
+
+set(line_count 0)
+foreach(line IN LISTS batch_lines)
+    if(line STREQUAL "")
+        continue()
+    endif()
+    math(EXPR line_count "${line_count} + 1")
+    string(JSON image ERROR_VARIABLE json_error GET "${line}" image)
+    if(json_error)
+        message(FATAL_ERROR "stdout line ${line_count} is not a JSON object with \"image\": ${line}\n${json_error}")
+    endif()
+endforeach()
+
+if(line_count EQUAL 0)
+    message(FATAL_ERROR "detect_decode_cli --batch produced no output")
+endif()
+message(STATUS "${line_count} JSON Lines checked")
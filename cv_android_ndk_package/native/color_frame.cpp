@@ -0,0 +1,269 @@
+#include "color_frame.h"
+#include "stripe_scheduler.h"
+#include <cmath>
+#include <algorithm>
+
+namespace DotCardDetect {
+
+namespace {
+
+// 黑色mark的固定阈值，与dotPreprocess中的"fixed"默认参数一致
+constexpr double DARK_THRESHOLD = 60;
+
+// 条带内每像素的中间数据：BGR(3) + HSV(3) + 灰度(1) + 两个临时掩码(2)
+constexpr int STRIPE_BYTES_PER_PIXEL = 9;
+
+// 一种输出颜色对应的一个或多个HSV范围（Red合并Red2）
+struct ColorSpec {
+    std::string name;
+    std::vector<ColorRange> ranges;
+};
+
+int colorIdForName(const std::string& colorName) {
+    static const std::map<std::string, int> colorNameToId = {
+        {"Red", 0}, {"Red2", 0},
+        {"Yellow", 1},
+        {"Green", 2},
+        {"Cyan", 3},
+        {"Blue", 4},
+        {"Indigo", 5}
+    };
+    auto it = colorNameToId.find(colorName);
+    return it != colorNameToId.end() ? it->second : -1;
+}
+
+// 积分图上单行区间[x0, x1)的像素数，裁剪规则与BitMask::countSpan相同
+inline int integralSpan(const cv::Mat& sum, int y, int x0, int x1) {
+    if (y < 0 || y >= sum.rows - 1) return 0;
+    x0 = std::max(0, x0);
+    x1 = std::min(sum.cols - 1, x1);
+    if (x1 <= x0) return 0;
+    const int* top = sum.ptr<int>(y);
+    const int* bottom = sum.ptr<int>(y + 1);
+    return bottom[x1] - bottom[x0] - top[x1] + top[x0];
+}
+
+} // namespace
+
+cv::Mat ColorFrame::colorMask(size_t colorIndex) const {
+    if (colorIndex >= colorBits.size()) return cv::Mat();
+    return colorBits[colorIndex].toMat();
+}
+
+int ColorFrame::countInRect(size_t colorIndex, const cv::Rect& rect) const {
+    if (colorIndex >= colorBits.size()) return 0;
+
+    cv::Rect r = rect & cv::Rect(0, 0, cols(), rows());
+    if (r.width <= 0 || r.height <= 0) return 0;
+
+    if (colorIndex < integrals.size()) {
+        const cv::Mat& sum = integrals[colorIndex];
+        const int* top = sum.ptr<int>(r.y);
+        const int* bottom = sum.ptr<int>(r.y + r.height);
+        return bottom[r.x + r.width] - bottom[r.x] - top[r.x + r.width] + top[r.x];
+    }
+    return colorBits[colorIndex].countRect(r);
+}
+
+int ColorFrame::countInRowSpan(size_t colorIndex, int row, int x0, int x1) const {
+    if (colorIndex >= colorBits.size()) return 0;
+    if (colorIndex < integrals.size()) {
+        return integralSpan(integrals[colorIndex], row, x0, x1);
+    }
+    return colorBits[colorIndex].countSpan(row, x0, x1);
+}
+
+int ColorFrame::countInSpans(size_t colorIndex, const std::vector<RowSpan>& spans, cv::Point offset) const {
+    if (colorIndex >= colorBits.size()) return 0;
+
+    int total = 0;
+    if (colorIndex < integrals.size()) {
+        const cv::Mat& sum = integrals[colorIndex];
+        for (const auto& span : spans) {
+            total += integralSpan(sum, span.y + offset.y, span.x0 + offset.x, span.x1 + offset.x);
+        }
+        return total;
+    }
+
+    const BitMask& bits = colorBits[colorIndex];
+    for (const auto& span : spans) {
+        total += bits.countSpan(span.y + offset.y, span.x0 + offset.x, span.x1 + offset.x);
+    }
+    return total;
+}
+
+ColorFrame buildColorFrame(const cv::Mat& bgr, const std::map<std::string, ColorRange>& colorRanges,
+                           bool withIntegrals) {
+    ColorFrame frame;
+    frame.size = bgr.size();
+
+    std::vector<ColorSpec> specs;
+    for (const auto& colorPair : colorRanges) {
+        const std::string& colorName = colorPair.first;
+        if (colorName == "Red2") continue;
+
+        ColorSpec spec;
+        spec.name = colorName;
+        spec.ranges.push_back(colorPair.second);
+        if (colorName == "Red") {
+            auto red2It = colorRanges.find("Red2");
+            if (red2It != colorRanges.end()) {
+                spec.ranges.push_back(red2It->second);
+            }
+        }
+        specs.push_back(spec);
+    }
+
+    frame.colorNames.reserve(specs.size());
+    frame.colorIds.reserve(specs.size());
+    frame.colorBits.resize(specs.size());
+    for (size_t i = 0; i < specs.size(); ++i) {
+        frame.colorNames.push_back(specs[i].name);
+        frame.colorIds.push_back(colorIdForName(specs[i].name));
+        frame.colorBits[i].create(bgr.rows, bgr.cols);
+    }
+    frame.threshold.create(bgr.rows, bgr.cols, CV_8UC1);
+
+    struct Scratch {
+        cv::Mat hsv;
+        cv::Mat gray;
+        cv::Mat mask;
+        cv::Mat extraMask;
+    };
+
+    // 逐像素运算没有邻域依赖，条带不需要额外的halo行
+    const int stripeRows = StripeProcessing::stripeRowsFor(bgr.cols, STRIPE_BYTES_PER_PIXEL);
+    const auto stripes = StripeProcessing::makeStripes(bgr.rows, stripeRows);
+
+    StripeProcessing::forEachStripe(stripes, [] { return Scratch(); },
+        [&](const StripeProcessing::Stripe& stripe, Scratch& scratch) {
+            const cv::Mat src = bgr.rowRange(stripe.y0, stripe.y1);
+
+            cv::cvtColor(src, scratch.gray, cv::COLOR_BGR2GRAY);
+            cv::Mat thresholdRows = frame.threshold.rowRange(stripe.y0, stripe.y1);
+            cv::threshold(scratch.gray, thresholdRows, DARK_THRESHOLD, 255, cv::THRESH_BINARY_INV);
+
+            cv::cvtColor(src, scratch.hsv, cv::COLOR_BGR2HSV);
+            for (size_t i = 0; i < specs.size(); ++i) {
+                const auto& ranges = specs[i].ranges;
+                cv::inRange(scratch.hsv, ranges[0].lower, ranges[0].upper, scratch.mask);
+                for (size_t r = 1; r < ranges.size(); ++r) {
+                    cv::inRange(scratch.hsv, ranges[r].lower, ranges[r].upper, scratch.extraMask);
+                    cv::bitwise_or(scratch.mask, scratch.extraMask, scratch.mask);
+                }
+                frame.colorBits[i].packRows(scratch.mask, stripe.y0);
+            }
+        });
+
+    if (withIntegrals) {
+        cv::Mat binary;
+        for (size_t i = 0; i < frame.colorBits.size(); ++i) {
+            cv::bitwise_and(frame.colorBits[i].toMat(), cv::Scalar(1), binary);
+
+            cv::Mat sum;
+            cv::integral(binary, sum, CV_32S);
+            frame.integrals.push_back(sum);
+        }
+    }
+
+    return frame;
+}
+
+ColorFrame buildColorFrameFromMasks(const cv::Mat& hsv, const std::map<std::string, cv::Mat>& colorMasks,
+                                    bool withIntegrals) {
+    ColorFrame frame;
+    frame.size = hsv.size();
+    frame.hsv = hsv;
+
+    frame.colorNames.reserve(colorMasks.size());
+    frame.colorIds.reserve(colorMasks.size());
+    frame.colorBits.resize(colorMasks.size());
+
+    size_t colorIndex = 0;
+    cv::Mat binary;
+    for (const auto& maskPair : colorMasks) {
+        frame.colorNames.push_back(maskPair.first);
+        frame.colorIds.push_back(colorIdForName(maskPair.first));
+        frame.colorBits[colorIndex++].assign(maskPair.second);
+
+        if (withIntegrals) {
+            // 掩码值为0/255，先归一化为0/1，保证大分辨率下CV_32S积分不溢出
+            cv::bitwise_and(maskPair.second, cv::Scalar(1), binary);
+
+            cv::Mat sum;
+            cv::integral(binary, sum, CV_32S);
+            frame.integrals.push_back(sum);
+        }
+    }
+
+    return frame;
+}
+
+void rasterizeConvexPolygon(const std::vector<cv::Point2f>& polygon,
+                            const cv::Rect& clip,
+                            std::vector<RowSpan>& spans) {
+    if (polygon.size() < 3 || clip.width <= 0 || clip.height <= 0) return;
+
+    const float eps = 1e-4f;
+
+    float minY = polygon[0].y, maxY = polygon[0].y;
+    for (const auto& p : polygon) {
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+    }
+
+    int yStart = std::max(clip.y, static_cast<int>(std::ceil(minY - eps)));
+    int yEnd = std::min(clip.y + clip.height - 1, static_cast<int>(std::floor(maxY + eps)));
+
+    const size_t n = polygon.size();
+    for (int y = yStart; y <= yEnd; ++y) {
+        const float fy = static_cast<float>(y);
+        float xMin = 0.f, xMax = 0.f;
+        bool hit = false;
+
+        // 以像素中心所在水平线与各边求交，凸多边形每行只有一个区间
+        for (size_t i = 0; i < n; ++i) {
+            const cv::Point2f& a = polygon[i];
+            const cv::Point2f& b = polygon[(i + 1) % n];
+
+            float lo = std::min(a.y, b.y), hi = std::max(a.y, b.y);
+            if (fy < lo - eps || fy > hi + eps) continue;
+
+            float xa, xb;
+            if (hi - lo < eps) {
+                xa = std::min(a.x, b.x);
+                xb = std::max(a.x, b.x);
+            } else {
+                float t = (fy - a.y) / (b.y - a.y);
+                t = std::min(1.f, std::max(0.f, t));
+                xa = xb = a.x + t * (b.x - a.x);
+            }
+
+            if (!hit) {
+                xMin = xa;
+                xMax = xb;
+                hit = true;
+            } else {
+                xMin = std::min(xMin, xa);
+                xMax = std::max(xMax, xb);
+            }
+        }
+        if (!hit) continue;
+
+        int x0 = std::max(clip.x, static_cast<int>(std::ceil(xMin - eps)));
+        int x1 = std::min(clip.x + clip.width, static_cast<int>(std::floor(xMax + eps)) + 1);
+        if (x1 > x0) {
+            spans.emplace_back(y, x0, x1);
+        }
+    }
+}
+
+int spanArea(const std::vector<RowSpan>& spans) {
+    int area = 0;
+    for (const auto& span : spans) {
+        area += span.x1 - span.x0;
+    }
+    return area;
+}
+
+} // namespace DotCardDetect
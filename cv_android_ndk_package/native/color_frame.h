@@ -0,0 +1,127 @@
+#ifndef COLOR_FRAME_H
+#define COLOR_FRAME_H
+
+#include "dot_card_detect.h"
+#include "bit_mask.h"
+#include <vector>
+#include <map>
+#include <string>
+
+namespace DotCardDetect {
+
+// 行区间：第y行的[x0, x1)像素
+struct RowSpan {
+    int y;
+    int x0;
+    int x1;
+
+    RowSpan() : y(0), x0(0), x1(0) {}
+    RowSpan(int yy, int a, int b) : y(yy), x0(a), x1(b) {}
+};
+
+// 单帧颜色统计上下文
+// 每帧只做一次HSV转换与颜色分割，每个颜色标签保存为位压缩掩码，
+// 该帧内所有区域颜色查询（检测阶段与解码阶段）共享同一份数据。
+// 默认同时建立积分图，矩形与每个行区间的计数为O(1)；不建立积分图时回退到popcount。
+struct ColorFrame {
+    cv::Size size;                              // 图像尺寸
+    cv::Mat hsv;                                // HSV图像（仅由buildColorFrameFromMasks保留）
+    cv::Mat threshold;                          // 黑色mark二值图（与dotPreprocess结果一致）
+    std::vector<std::string> colorNames;        // 与colorBits一一对应（Red已合并Red2）
+    std::vector<int> colorIds;                  // 颜色ID: 0=Red, 1=Yellow, 2=Green, 3=Cyan, 4=Blue, 5=Indigo
+    std::vector<BitMask> colorBits;             // 每种颜色的位压缩掩码
+    std::vector<cv::Mat> integrals;             // 0/1掩码的积分图，CV_32S，(rows+1)x(cols+1)；为空时用colorBits计数
+
+    int rows() const { return size.height; }
+    int cols() const { return size.width; }
+    size_t colorCount() const { return colorBits.size(); }
+    bool empty() const { return colorBits.empty(); }
+
+    /**
+     * 像素(x, y)是否属于某颜色
+     * @param colorIndex 颜色下标（对应colorNames）
+     * @param x 列
+     * @param y 行
+     * @return 是否属于该颜色
+     */
+    bool contains(size_t colorIndex, int x, int y) const {
+        return colorBits[colorIndex].test(x, y);
+    }
+
+    /**
+     * 展开某颜色的8位掩码（调试用）
+     * @param colorIndex 颜色下标（对应colorNames）
+     * @return CV_8UC1掩码
+     */
+    cv::Mat colorMask(size_t colorIndex) const;
+
+    /**
+     * 统计矩形区域内某颜色的像素数，已建立积分图时为O(1)
+     * @param colorIndex 颜色下标（对应colorNames）
+     * @param rect 矩形区域，会被裁剪到图像范围内
+     * @return 像素数
+     */
+    int countInRect(size_t colorIndex, const cv::Rect& rect) const;
+
+    /**
+     * 统计单行区间[x0, x1)内某颜色的像素数，已建立积分图时为O(1)，否则popcount
+     * @param colorIndex 颜色下标（对应colorNames）
+     * @param row 行号
+     * @param x0 起始列（包含）
+     * @param x1 结束列（不包含）
+     * @return 像素数
+     */
+    int countInRowSpan(size_t colorIndex, int row, int x0, int x1) const;
+
+    /**
+     * 统计若干行区间内某颜色的像素数，每行一次积分图查询（未建立积分图时对少量64位字做popcount）
+     * @param colorIndex 颜色下标（对应colorNames）
+     * @param spans 行区间列表（加上offset后需位于图像范围内）
+     * @param offset 行区间的平移量（模板区间为相对坐标时使用）
+     * @return 像素数
+     */
+    int countInSpans(size_t colorIndex, const std::vector<RowSpan>& spans, cv::Point offset = cv::Point()) const;
+};
+
+/**
+ * 由BGR图像构建单帧颜色统计上下文
+ * 按L2大小的水平条带一次完成HSV转换、灰度与阈值化、颜色分割和位打包，
+ * 条带分配到多个线程，HSV与灰度等中间平面只在条带内存在
+ * @param bgr BGR图像
+ * @param colorRanges 颜色范围映射
+ * @param withIntegrals 是否额外建立积分图（默认建立；区域计数O(1)，每种颜色多占32位/像素）
+ * @return 颜色统计上下文
+ */
+ColorFrame buildColorFrame(const cv::Mat& bgr, const std::map<std::string, ColorRange>& colorRanges,
+                           bool withIntegrals = true);
+
+/**
+ * 由已有的HSV图像与颜色掩码构建颜色统计上下文
+ * @param hsv HSV图像
+ * @param colorMasks 颜色掩码（值为0/255）
+ * @param withIntegrals 是否额外建立积分图（默认建立；区域计数O(1)，每种颜色多占32位/像素）
+ * @return 颜色统计上下文
+ */
+ColorFrame buildColorFrameFromMasks(const cv::Mat& hsv, const std::map<std::string, cv::Mat>& colorMasks,
+                                    bool withIntegrals = true);
+
+/**
+ * 将凸多边形按像素中心扫描为行区间
+ * @param polygon 凸多边形顶点
+ * @param clip 裁剪范围
+ * @param spans 输出的行区间（追加）
+ */
+void rasterizeConvexPolygon(const std::vector<cv::Point2f>& polygon,
+                            const cv::Rect& clip,
+                            std::vector<RowSpan>& spans);
+
+/**
+ * 统计行区间覆盖的像素总数
+ * @param spans 行区间列表
+ * @return 像素数
+ */
+int spanArea(const std::vector<RowSpan>& spans);
+
+} // namespace DotCardDetect
+
+#endif // COLOR_FRAME_H
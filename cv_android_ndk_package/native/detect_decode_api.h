@@ -13,8 +13,37 @@ typedef struct {
     int tl_y;         // bounding rect top-left y
     int br_x;         // bounding rect bottom-right x
     int br_y;         // bounding rect bottom-right y
+    int code_corner;  // image-space card corner whose mark the code was read from (0=TL,1=TR,2=BR,3=BL),
+                      // -1 if unknown. Every corner carries the same code, so this is not the card's rotation.
+    float confidence; // decode confidence 0..1 (nearest-codeword posterior), 0 if not decoded
+    int track_id;     // persistent track ID from a detection session, -1 for stateless calls
+    int reused;       // 1 if carried over from an earlier frame without re-detection (motion gating)
 } DetectedCard;
 
+// Delta event types emitted by a detection session
+enum {
+    CARD_EVENT_RESET = 0,         // events were lost (consumer fell behind): drop all state, ADDs follow
+    CARD_EVENT_ADD = 1,           // a new track appeared
+    CARD_EVENT_MOVE = 2,          // a track's box moved by more than the move epsilon
+    CARD_EVENT_REMOVE = 3,        // a track disappeared
+    CARD_EVENT_ID_CONFIRMED = 4   // a track's card ID was confirmed (or re-confirmed with a different ID)
+};
+
+// Delta event for one card track. Pose fields carry the current box; for REMOVE they hold the last box.
+typedef struct {
+    int type;         // CARD_EVENT_*
+    int track_id;     // persistent track ID
+    int card_id;      // current card ID, -1 if not decoded yet
+    int group_type;   // 0=A, 1=B, -1=unknown
+    int tl_x;
+    int tl_y;
+    int br_x;
+    int br_y;
+    int code_corner;  // corner the code was read from (see DetectedCard), -1 if unknown
+    float confidence; // decode confidence 0..1
+    int frame;        // session frame index the event was produced in
+} CardEvent;
+
 /**
  * Detect and decode cards from a BGR8 image buffer.
  * @param bgr Pointer to BGR8 pixel data (width*height*3 bytes)
@@ -39,6 +68,100 @@ int detect_decode_cards_bgr8(const unsigned char* bgr, int width, int height,
 int detect_decode_cards_nv21(const unsigned char* nv21, int width, int height,
                              DetectedCard* out_cards, int max_out_cards);
 
+// Detection session: keeps card tracks across frames so confirmed IDs are reused
+// instead of decoded again on every frame. Calls on one session are serialized internally.
+typedef void* DetectSessionHandle;
+
+DetectSessionHandle detect_session_create(void);
+void detect_session_destroy(DetectSessionHandle session);
+
+/**
+ * Drop all tracks, e.g. when the camera is restarted.
+ */
+void detect_session_reset(DetectSessionHandle session);
+
+/**
+ * Detect cards in a BGR8 frame, decoding only tracks that are new, unconfirmed,
+ * due for periodic re-verification, moved, or changed appearance.
+ * A downsampled luma plane is compared tile-wise (SAD) with the last processed frame:
+ * an unchanged frame returns the cached result with reused=1, and a partly changed frame
+ * re-runs detection only around the changed tiles.
+ * @return Number of cards written (>=0)
+ */
+int detect_session_process_bgr8(DetectSessionHandle session, const unsigned char* bgr, int width, int height,
+                                DetectedCard* out_cards, int max_out_cards);
+
+/**
+ * Same as detect_session_process_bgr8 for an NV21 (YUV420) frame.
+ * The motion gate reads the Y plane directly, so unchanged frames skip color conversion too.
+ * @return Number of cards written (>=0)
+ */
+int detect_session_process_nv21(DetectSessionHandle session, const unsigned char* nv21, int width, int height,
+                                DetectedCard* out_cards, int max_out_cards);
+
+// Session statistics, including the latency governor's current quality level
+typedef struct {
+    int frame_count;           // frames passed to the session since creation/reset
+    int decode_count;          // decodes performed
+    int skipped_decode_count;  // decodes skipped thanks to confirmed tracks
+    int reused_frame_count;    // frames answered from the previous result (no change or between keyframes)
+    int quality_level;         // 0 = full quality; higher levels trade resolution, keyframes, candidates, retries
+    int quality_level_count;   // number of quality levels
+    float budget_ms;           // per-frame latency budget, 0 if the governor is off
+    float average_ms;          // moving average of processed frame cost
+    float convert_ms;          // stage timings of the last processed frame
+    float scale_ms;
+    float color_ms;
+    float detect_ms;
+    float decode_ms;
+    float total_ms;
+} DetectSessionStats;
+
+/**
+ * Set a per-frame latency budget. When processed frames run over it, the session lowers the
+ * working resolution, lengthens the keyframe interval and caps candidate marks and decode retries;
+ * it steps back up once frames are comfortably inside the budget. 0 (default) turns it off.
+ */
+void detect_session_set_latency_budget(DetectSessionHandle session, float budget_ms);
+
+/**
+ * Read session statistics.
+ */
+void detect_session_get_stats(DetectSessionHandle session, DetectSessionStats* out_stats);
+
+/**
+ * Drain pending delta events (ADD / MOVE / REMOVE / ID_CONFIRMED) produced by process calls.
+ * Events are queued in a lock-free single-producer/single-consumer ring, so one thread may
+ * process frames while another (e.g. the UI thread, once per frame) drains events.
+ * A steady table produces no events. If the ring overflowed, the first returned event is
+ * CARD_EVENT_RESET and every live track is re-announced with ADD on the next processed frame;
+ * MOVE/REMOVE for unknown track IDs should be ignored, ADD for a known ID replaces it.
+ * @param out_events Output array
+ * @param max_events Capacity of out_events
+ * @return Number of events written (>=0)
+ */
+int detect_session_poll_events(DetectSessionHandle session, CardEvent* out_events, int max_events);
+
+/**
+ * Minimum change in pixels of any box edge before a MOVE event is emitted (default 4).
+ */
+void detect_session_set_move_epsilon(DetectSessionHandle session, float pixels);
+
+/**
+ * Record every frame passed to the session into a frame stream file (see frame_stream.h)
+ * for offline replay with frame_replay. The file is created on the next frame.
+ * @param path Output file path
+ * @param metadata Free-form metadata stored in the header (e.g. calibration JSON), may be NULL
+ * @param compress Non-zero to LZ4-compress each frame when LZ4 support is compiled in
+ */
+void detect_session_start_recording(DetectSessionHandle session, const char* path,
+                                    const char* metadata, int compress);
+
+/**
+ * Stop recording and finalize the frame stream index.
+ */
+void detect_session_stop_recording(DetectSessionHandle session);
+
 #ifdef __cplusplus
 }
 #endif
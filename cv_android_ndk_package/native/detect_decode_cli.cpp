@@ -5,9 +5,24 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <dirent.h>
+#include <glob.h>
 
 #include "detect_decode_api.h"
 #include "dot_card_detect.h"
+#include "dot_card_debug.h"
+#include "color_frame.h"
+#include "detect_session.h"
+#include "card_encoder_decoder_c_api.h"
+#include "json_writer.h"
 
 static std::string colorIdToName(int id) {
     switch (id) {
@@ -107,12 +122,208 @@ static void ensureOutputDir(const std::string& path) {
 #endif
 }
 
+// ---------------------------------------------------------------------------
+// 批处理模式：--batch <dir|glob|list> [-j N] [--out file]
+// 每张图片输出一行 JSON（JSON Lines），不创建输出目录也不打开窗口
+
+static bool hasImageExtension(const std::string& path) {
+    std::string ext = path.substr(path.find_last_of('.') == std::string::npos ? path.size() : path.find_last_of('.'));
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return (char)std::tolower(ch); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" || ext == ".webp";
+}
+
+// 目录（其中的图片文件）、通配符或列表文件（每行一个路径）展开为图片路径
+static std::vector<std::string> collectBatchInputs(const std::string& spec) {
+    std::vector<std::string> paths;
+    struct stat st{};
+    if (stat(spec.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+        if (DIR* dir = opendir(spec.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                std::string name = entry->d_name;
+                if (name.empty() || name[0] == '.' || !hasImageExtension(name)) continue;
+                paths.push_back(spec + "/" + name);
+            }
+            closedir(dir);
+        }
+        std::sort(paths.begin(), paths.end());
+    } else if (spec.find_first_of("*?[") != std::string::npos) {
+        glob_t g{};
+        if (glob(spec.c_str(), 0, nullptr, &g) == 0) {
+            for (size_t i = 0; i < g.gl_pathc; ++i) paths.push_back(g.gl_pathv[i]);
+        }
+        globfree(&g);
+    } else {
+        std::ifstream list(spec);
+        std::string line;
+        while (std::getline(list, line)) {
+            while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) line.pop_back();
+            if (!line.empty() && line[0] != '#') paths.push_back(line);
+        }
+    }
+    return paths;
+}
+
+struct BatchTimings {
+    double load = 0.0, color = 0.0, detect = 0.0, decode = 0.0, total = 0.0;
+};
+
+static double msSince(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// 处理单张图片，将 JSON 行写入 json（调用方逐图复用）
+static void processBatchImage(const std::string& path, CardDecoderHandle decoder,
+                              BatchTimings& t, bool& ok, JsonOutput::JsonWriter& json) {
+    json.clear();
+    json.beginObject().key("image").value(path);
+    ok = false;
+#if HAVE_OPENCV
+    auto t0 = std::chrono::steady_clock::now();
+    cv::Mat img = cv::imread(path, cv::IMREAD_COLOR);
+    t.load = msSince(t0);
+    if (img.empty()) {
+        json.key("ok").value(false).key("error").value("load failed").endObject();
+        return;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    DotCardDetect::ColorFrame frame = DotCardDetect::buildColorFrame(img, DotCardDetect::getDefaultColorRanges());
+    t.color = msSince(t1);
+
+    auto t2 = std::chrono::steady_clock::now();
+    DotCardDetect::DetectionResult det = DotCardDetect::detectDotCards(img, frame, false);
+    t.detect = msSince(t2);
+
+    auto t3 = std::chrono::steady_clock::now();
+    std::vector<DotCardDetect::CardDecode> decodes;
+    for (const auto& card : det.cards) {
+        decodes.push_back(DotCardDetect::decodeDetectedCard(decoder, frame, det, card));
+    }
+    t.decode = msSince(t3);
+    t.total = msSince(t0);
+    ok = true;
+
+    json.key("ok").value(true).key("width").value(img.cols).key("height").value(img.rows);
+    json.key("cards").beginArray();
+    for (size_t i = 0; i < det.cards.size(); ++i) {
+        const auto& card = det.cards[i];
+        const auto& d = decodes[i];
+        const cv::Rect& r = card.boundingRect;
+        json.beginObject()
+            .key("id").value(d.cardId)
+            .key("group").value(d.groupType)
+            .key("code_corner").value(d.codeCorner)
+            .key("confidence").value(d.confidence, 3)
+            .key("bbox").beginArray().value(r.x).value(r.y).value(r.x + r.width).value(r.y + r.height).endArray()
+            .key("corners").beginArray();
+        for (const auto& corner : card.corners) {
+            json.beginArray().value(corner.x).value(corner.y).endArray();
+        }
+        json.endArray().endObject();
+    }
+    json.endArray();
+    json.key("timings_ms").beginObject()
+        .key("load").value(t.load, 3)
+        .key("color").value(t.color, 3)
+        .key("detect").value(t.detect, 3)
+        .key("decode").value(t.decode, 3)
+        .key("total").value(t.total, 3)
+        .endObject();
+    json.endObject();
+#else
+    (void)decoder; (void)t;
+    json.key("ok").value(false).key("error").value("OpenCV not available").endObject();
+#endif
+}
+
+static int runBatch(const std::string& spec, int jobs, const std::string& outPath) {
+    std::vector<std::string> inputs = collectBatchInputs(spec);
+    if (inputs.empty()) {
+        std::cerr << "No images found for batch input: " << spec << std::endl;
+        return 1;
+    }
+
+    std::ofstream outFile;
+    if (!outPath.empty()) {
+        outFile.open(outPath);
+        if (!outFile) {
+            std::cerr << "Failed to open output: " << outPath << std::endl;
+            return 2;
+        }
+    }
+    std::ostream& out = outPath.empty() ? std::cout : outFile;
+
+    jobs = std::max(1, jobs);
+#if HAVE_OPENCV
+    // 图片级并行时关闭 OpenCV 内部线程，避免线程超额订阅
+    if (jobs > 1) cv::setNumThreads(1);
+#endif
+
+    CardDecoderHandle decoder = card_decoder_create();
+    std::atomic<size_t> next(0);
+    std::atomic<size_t> failures(0);
+    std::mutex outMutex;
+    BatchTimings sum;
+
+    auto wallStart = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        // 每个工作线程一个写入缓冲区，逐图复用
+        JsonOutput::JsonWriter json;
+        for (size_t i = next++; i < inputs.size(); i = next++) {
+            BatchTimings t;
+            bool ok = false;
+            processBatchImage(inputs[i], decoder, t, ok, json);
+            std::lock_guard<std::mutex> lock(outMutex);
+            out.write(json.data(), static_cast<std::streamsize>(json.size()));
+            out << "\n";
+            if (!ok) { ++failures; continue; }
+            sum.load += t.load; sum.color += t.color; sum.detect += t.detect;
+            sum.decode += t.decode; sum.total += t.total;
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int k = 1; k < jobs; ++k) threads.emplace_back(worker);
+    worker();
+    for (auto& th : threads) th.join();
+    out.flush();
+    double wallMs = msSince(wallStart);
+    card_decoder_destroy(decoder);
+
+    // 吞吐量汇总输出到 stderr，不干扰 JSON Lines
+    size_t done = inputs.size() - failures;
+    double n = done > 0 ? (double)done : 1.0;
+    std::fprintf(stderr, "Batch: %zu images (%zu failed), %d jobs, %.1f ms wall, %.1f images/s\n",
+                 inputs.size(), (size_t)failures, jobs, wallMs, wallMs > 0 ? inputs.size() * 1000.0 / wallMs : 0.0);
+    std::fprintf(stderr, "Mean per image: load %.2f ms, color %.2f ms, detect %.2f ms, decode %.2f ms, total %.2f ms\n",
+                 sum.load / n, sum.color / n, sum.detect / n, sum.decode / n, sum.total / n);
+    return failures > 0 ? 3 : 0;
+}
+
 int main(int argc, char** argv) {
     if (argc < 2) {
         std::cerr << "Usage: detect_decode_cli <image_path> [--show|--show_regions] [--print_colors]" << std::endl;
+        std::cerr << "       detect_decode_cli --batch <dir|glob|list> [-j N] [--out results.jsonl]" << std::endl;
         return 1;
     }
 
+    // 批处理模式
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) != "--batch") continue;
+        if (i + 1 >= argc) {
+            std::cerr << "--batch requires a directory, glob or list file" << std::endl;
+            return 1;
+        }
+        std::string spec = argv[i + 1];
+        int jobs = 1;
+        std::string outPath;
+        for (int k = 1; k < argc; ++k) {
+            std::string opt = argv[k];
+            if ((opt == "-j" || opt == "--jobs") && k + 1 < argc) jobs = std::atoi(argv[++k]);
+            else if (opt == "--out" && k + 1 < argc) outPath = argv[++k];
+        }
+        return runBatch(spec, jobs, outPath);
+    }
+
     std::string imagePath = argv[1];
     bool showWindows = false;
     bool printColors = false;
@@ -122,6 +333,9 @@ int main(int argc, char** argv) {
         if (opt == "--print_colors") printColors = true;
     }
     ensureOutputDir("output");
+    if (showWindows) {
+        DotCardDetect::installHighGuiDebugViewer();
+    }
 
     // 加载图像与基础检测（在缺少 OpenCV 头文件时进行保护）
     cv::Mat img; 
@@ -224,17 +438,15 @@ int main(int argc, char** argv) {
                           << colorIdToName(it->second.first) << "(" << it->second.first << "), "
                           << colorIdToName(it->second.second) << "(" << it->second.second << ")" << std::endl;
             }
-            std::string jsonStr = "{";
-            bool first = true;
+            JsonOutput::JsonWriter json(JsonOutput::JsonStyle::SPACED, 128);
+            json.beginObject();
             for (const auto& key : order) {
                 auto it = rc.find(key);
                 if (it == rc.end()) continue;
-                if (!first) jsonStr += ", ";
-                jsonStr += "\"" + key + "\":(" + std::to_string(it->second.first) + "," + std::to_string(it->second.second) + ")";
-                first = false;
+                json.key(key).beginArray().value(it->second.first).value(it->second.second).endArray();
             }
-            jsonStr += "}";
-            std::cout << "JSON: " << jsonStr << std::endl;
+            json.endObject();
+            std::cout << "JSON: " << json.str() << std::endl;
             // 简化4元组：取每个方向的近色ID，若缺失为-1
             int u = rc.count("U") ? rc.at("U").first : -1;
             int r = rc.count("R") ? rc.at("R").first : -1;
@@ -361,7 +573,8 @@ int main(int argc, char** argv) {
 
         // 直接使用配对后的卡片四角（dcards）来输出 JSON，并计算方向角
         std::cout << "Rectangles JSON:" << std::endl;
-        std::cout << "{";
+        JsonOutput::JsonWriter rectJson(JsonOutput::JsonStyle::SPACED);
+        rectJson.beginObject();
         for (size_t k = 0; k < dcards.size(); ++k) {
             const auto& dc = dcards[k];
             
@@ -423,20 +636,23 @@ int main(int argc, char** argv) {
                 continue; // 跳过其他情况
             }
 
-            if (k) std::cout << ", ";
-            std::cout << "\"Rect" << (k+1) << "\": {"
-                      << "\"id\": " << bestCardId << ", "
-                      << "\"posi\": {"
-                      << "\"Corner1\": [" << tl.x << ", " << tl.y << "], "
-                      << "\"Corner2\": [" << tr.x << ", " << tr.y << "], "
-                      << "\"Corner3\": [" << brp.x << ", " << brp.y << "], "
-                      << "\"Corner4\": [" << bl.x << ", " << bl.y << "], "
-                      << "\"center\": [" << center.x << ", " << center.y << "]}, "
-                      << "\"angle\": " << angle << ", "
-                      << "\"direction\": " << angle
-                      << "}";
+            char rectKey[16];
+            std::snprintf(rectKey, sizeof(rectKey), "Rect%zu", k + 1);
+            rectJson.key(rectKey).beginObject()
+                .key("id").value(bestCardId)
+                .key("posi").beginObject()
+                    .key("Corner1").beginArray().value(tl.x).value(tl.y).endArray()
+                    .key("Corner2").beginArray().value(tr.x).value(tr.y).endArray()
+                    .key("Corner3").beginArray().value(brp.x).value(brp.y).endArray()
+                    .key("Corner4").beginArray().value(bl.x).value(bl.y).endArray()
+                    .key("center").beginArray().value(center.x).value(center.y).endArray()
+                .endObject()
+                .key("angle").value(angle, 3)
+                .key("direction").value(angle, 3)
+            .endObject();
         }
-        std::cout << "}" << std::endl;
+        rectJson.endObject();
+        std::cout << rectJson.str() << std::endl;
     }
 #endif
 
@@ -0,0 +1,568 @@
+#include "detect_session.h"
+#include "card_patch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace DotCardDetect {
+
+namespace {
+
+// 轨迹关联所需的最小IoU
+constexpr float MIN_TRACK_IOU = 0.3f;
+
+/**
+ * 由单个角点mark的区域颜色解码（方向按U,R,D,L传给解码器，由其确定读取顺序与朝向）
+ */
+bool decodeFromCorner(CardDecoderHandle decoder,
+                      const std::map<std::string, std::pair<int, int>>& regionColors,
+                      CardDecode& out) {
+    static const char* kDirections[4] = {"U", "R", "D", "L"};
+    int nearColors[4] = {-1, -1, -1, -1};
+    int farColors[4] = {-1, -1, -1, -1};
+    for (int i = 0; i < 4; ++i) {
+        auto it = regionColors.find(kDirections[i]);
+        if (it == regionColors.end()) continue;
+        nearColors[i] = it->second.first;
+        farColors[i] = it->second.second;
+    }
+
+    OrientedDecodeResult dr = card_decode_observation(decoder, nearColors, farColors);
+    if (dr.success != 1 || dr.card_id < 0) return false;
+    out.cardId = dr.card_id;
+    out.groupType = dr.group_type;
+    out.codeCorner = dr.orientation;
+    out.confidence = dr.confidence;
+    return true;
+}
+
+/**
+ * 由透视校正图块解码：四个角点的读数联合解码（接受阈值由解码器统一判定），
+ * 单个角点的不可读数字由其余角点补足，角点读数互相矛盾时判为歧义；
+ * 读码角点取最支持解码结果的角点，并列时按TL, TR, BR, BL的顺序取先者
+ */
+bool decodeFromPatch(CardDecoderHandle decoder, const CardPatchObservation& obs, CardDecode& out) {
+    if (!obs.valid) return false;
+    int codes[4][4];
+    for (int k = 0; k < 4; ++k) {
+        std::copy(obs.cornerCodes[k].begin(), obs.cornerCodes[k].end(), codes[k]);
+    }
+    OrientedDecodeResult dr = card_decode_combined(decoder, codes, 4);
+    if (dr.success != 1 || dr.card_id < 0) return false;
+    out.cardId = dr.card_id;
+    out.groupType = dr.group_type;
+    out.codeCorner = dr.orientation;
+    out.confidence = dr.confidence;
+    return true;
+}
+
+float elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+float rectIoU(const cv::Rect& a, const cv::Rect& b) {
+    const float inter = static_cast<float>((a & b).area());
+    const float uni = static_cast<float>(a.area() + b.area()) - inter;
+    return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+// 卡片区域内各颜色像素占比，作为轻量外观特征
+std::vector<float> cardAppearance(const ColorFrame& frame, const cv::Rect& rect) {
+    std::vector<float> appearance(frame.colorCount(), 0.0f);
+    const cv::Rect r = rect & cv::Rect(0, 0, frame.cols(), frame.rows());
+    if (r.area() <= 0) return appearance;
+    for (size_t i = 0; i < frame.colorCount(); ++i) {
+        appearance[i] = static_cast<float>(frame.countInRect(i, r)) / r.area();
+    }
+    return appearance;
+}
+
+DetectedCard toDetectedCard(const Card& card, const CardDecode& decode) {
+    DetectedCard out{};
+    out.card_id = decode.cardId;
+    out.group_type = decode.decoded() ? decode.groupType : -1;
+    out.tl_x = card.boundingRect.x;
+    out.tl_y = card.boundingRect.y;
+    out.br_x = card.boundingRect.x + card.boundingRect.width;
+    out.br_y = card.boundingRect.y + card.boundingRect.height;
+    out.code_corner = decode.decoded() ? decode.codeCorner : -1;
+    out.confidence = decode.decoded() ? decode.confidence : 0.0f;
+    out.track_id = -1;
+    out.reused = 0;
+    return out;
+}
+
+} // namespace
+
+CardDecode decodeDetectedCard(CardDecoderHandle decoder,
+                              const ColorFrame& frame,
+                              const DetectionResult& det,
+                              const Card& card,
+                              int maxCornerAttempts) {
+    CardDecode decode;
+    if (!decoder) return decode;
+
+    // 四角卡片：在校正图块的固定位置采样
+    if (card.corners.size() == 4) {
+        CardPatchObservation obs = sampleCardPatch(frame, card, det.rectangles);
+        if (decodeFromPatch(decoder, obs, decode)) return decode;
+    }
+
+    // 单角卡片或图块无法读取：逐个角点使用检测阶段已采样的区域颜色
+    int attempts = 0;
+    for (int cornerIdx : card.cornerIndices) {
+        if (maxCornerAttempts >= 0 && attempts >= maxCornerAttempts) break;
+        if (cornerIdx < 0 || cornerIdx >= static_cast<int>(det.markRegionColors.size())) continue;
+        ++attempts;
+        if (decodeFromCorner(decoder, det.markRegionColors[cornerIdx], decode)) break;
+    }
+    return decode;
+}
+
+DetectionSession::DetectionSession(const DetectionSessionConfig& config)
+    : config_(config),
+      decoder_(card_decoder_create()),
+      gate_(config.motion),
+      governor_(config.governor),
+      lastKeyframe_(0),
+      hasResult_(false),
+      frameIndex_(0),
+      nextTrackId_(1),
+      decodeCount_(0),
+      skippedDecodeCount_(0),
+      reusedFrameCount_(0),
+      events_(static_cast<size_t>(std::max(1, config.eventCapacity))),
+      resyncRequested_(false),
+      recordCompress_(false),
+      recordPending_(false) {}
+
+DetectionSession::~DetectionSession() {
+    stopRecording();
+    card_decoder_destroy(decoder_);
+}
+
+void DetectionSession::startRecording(const std::string& path, const std::string& metadata, bool compress) {
+    std::lock_guard<std::mutex> lock(recordMutex_);
+    if (recorder_) {
+        recorder_->close();
+        recorder_.reset();
+    }
+    recordPath_ = path;
+    recordMetadata_ = metadata;
+    recordCompress_ = compress;
+    recordPending_ = !path.empty();
+}
+
+void DetectionSession::stopRecording() {
+    std::lock_guard<std::mutex> lock(recordMutex_);
+    recordPending_ = false;
+    if (recorder_) {
+        recorder_->close();
+        recorder_.reset();
+    }
+}
+
+void DetectionSession::recordFrame(FrameStream::PixelFormat format, const unsigned char* data, int width, int height) {
+    std::lock_guard<std::mutex> lock(recordMutex_);
+    if (recordPending_) {
+        FrameStream::StreamInfo info;
+        info.format = format;
+        info.width = width;
+        info.height = height;
+        info.metadata = recordMetadata_;
+        recorder_.reset(new FrameStream::Writer());
+        if (!recorder_->open(recordPath_, info, recordCompress_)) {
+            recorder_.reset();
+        }
+        recordPending_ = false;
+    }
+    if (!recorder_) return;
+
+    // 录制期间帧尺寸或格式变化的帧不写入
+    const FrameStream::StreamInfo& info = recorder_->info();
+    if (info.format != format || info.width != width || info.height != height) return;
+
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    recorder_->write(data, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count()));
+}
+
+void DetectionSession::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& track : tracks_) {
+        if (track.published) pushEvent(CARD_EVENT_REMOVE, track, track.publishedCard);
+    }
+    tracks_.clear();
+    lastCards_.clear();
+    hasResult_ = false;
+    gate_.reset();
+    governor_.reset();
+    lastKeyframe_ = 0;
+    frameIndex_ = 0;
+}
+
+CardTrack* DetectionSession::findTrack(int trackId) {
+    for (auto& track : tracks_) {
+        if (track.trackId == trackId) return &track;
+    }
+    return nullptr;
+}
+
+void DetectionSession::touchTrack(int trackId) {
+    if (CardTrack* track = findTrack(trackId)) {
+        track->lastSeenFrame = frameIndex_;
+    }
+}
+
+void DetectionSession::pruneTracks() {
+    // 删除长时间未出现的轨迹，已发布的轨迹发出REMOVE
+    auto stale = [this](const CardTrack& t) {
+        return frameIndex_ - t.lastSeenFrame > config_.maxMissedFrames;
+    };
+    for (const auto& track : tracks_) {
+        if (stale(track) && track.published) pushEvent(CARD_EVENT_REMOVE, track, track.publishedCard);
+    }
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), stale), tracks_.end());
+}
+
+void DetectionSession::pushEvent(int type, const CardTrack& track, const DetectedCard& card) {
+    CardEvent event{};
+    event.type = type;
+    event.track_id = track.trackId;
+    event.card_id = card.card_id;
+    event.group_type = card.group_type;
+    event.tl_x = card.tl_x;
+    event.tl_y = card.tl_y;
+    event.br_x = card.br_x;
+    event.br_y = card.br_y;
+    event.code_corner = card.code_corner;
+    event.confidence = card.confidence;
+    event.frame = frameIndex_;
+    events_.push(event);
+}
+
+void DetectionSession::publishEvents() {
+    // 消费端丢失过事件：全部轨迹重新发布
+    if (resyncRequested_.exchange(false, std::memory_order_acq_rel)) {
+        for (auto& track : tracks_) {
+            track.published = false;
+            track.publishedCardId = -1;
+        }
+    }
+
+    const float eps = config_.moveEpsilon;
+    for (const auto& card : lastCards_) {
+        CardTrack* track = findTrack(card.track_id);
+        if (!track) continue;
+
+        if (!track->published) {
+            pushEvent(CARD_EVENT_ADD, *track, card);
+            track->published = true;
+            track->publishedCard = card;
+        } else {
+            const DetectedCard& prev = track->publishedCard;
+            if (std::abs(card.tl_x - prev.tl_x) > eps || std::abs(card.tl_y - prev.tl_y) > eps ||
+                std::abs(card.br_x - prev.br_x) > eps || std::abs(card.br_y - prev.br_y) > eps) {
+                pushEvent(CARD_EVENT_MOVE, *track, card);
+                track->publishedCard = card;
+            }
+        }
+
+        if (track->decode.decoded() && track->confirmations >= config_.confirmCount &&
+            track->publishedCardId != track->decode.cardId) {
+            pushEvent(CARD_EVENT_ID_CONFIRMED, *track, card);
+            track->publishedCardId = track->decode.cardId;
+        }
+    }
+}
+
+int DetectionSession::pollEvents(CardEvent* outEvents, int maxEvents) {
+    if (!outEvents || maxEvents <= 0) return 0;
+    int n = 0;
+    if (events_.takeLost()) {
+        // 缓冲区溢出：丢弃积压事件，通知消费端清空状态，由处理线程在下一帧重新发出ADD
+        events_.discard();
+        CardEvent reset{};
+        reset.type = CARD_EVENT_RESET;
+        reset.track_id = -1;
+        reset.card_id = -1;
+        reset.group_type = -1;
+        reset.code_corner = -1;
+        reset.frame = -1;
+        outEvents[n++] = reset;
+        resyncRequested_.store(true, std::memory_order_release);
+    }
+    return n + events_.pop(outEvents + n, maxEvents - n);
+}
+
+void DetectionSession::setLatencyBudget(float budgetMs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    governor_.setBudget(budgetMs);
+}
+
+void DetectionSession::getStats(DetectSessionStats& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const StageTimings& t = governor_.lastTimings();
+    out.frame_count = frameIndex_;
+    out.decode_count = decodeCount_;
+    out.skipped_decode_count = skippedDecodeCount_;
+    out.reused_frame_count = reusedFrameCount_;
+    out.quality_level = governor_.levelIndex();
+    out.quality_level_count = governor_.levelCount();
+    out.budget_ms = std::max(0.0f, governor_.budget());
+    out.average_ms = governor_.averageMs();
+    out.convert_ms = t.convertMs;
+    out.scale_ms = t.scaleMs;
+    out.color_ms = t.colorMs;
+    out.detect_ms = t.detectMs;
+    out.decode_ms = t.decodeMs;
+    out.total_ms = t.totalMs;
+}
+
+void DetectionSession::setMoveEpsilon(float pixels) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_.moveEpsilon = std::max(0.0f, pixels);
+}
+
+CardTrack* DetectionSession::matchTrack(const cv::Rect& rect, std::vector<bool>& matched) {
+    CardTrack* best = nullptr;
+    float bestIoU = MIN_TRACK_IOU;
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        if (matched[i]) continue;
+        float iou = rectIoU(rect, tracks_[i].boundingRect);
+        if (iou >= bestIoU) {
+            bestIoU = iou;
+            best = &tracks_[i];
+        }
+    }
+    if (best) {
+        matched[best - tracks_.data()] = true;
+    }
+    return best;
+}
+
+bool DetectionSession::needsDecode(const CardTrack& track, const cv::Rect& rect,
+                                   const std::vector<float>& appearance) const {
+    if (!track.decode.decoded() || track.confirmations < config_.confirmCount) return true;
+    if (frameIndex_ - track.lastDecodeFrame >= config_.reverifyInterval) return true;
+
+    // 大幅移动：相对最近一次解码时的中心位移或尺寸变化（boundingRect每帧更新，不能用来累计漂移）
+    const cv::Rect& prev = track.lastDecodeRect;
+    const float dx = (rect.x + rect.width * 0.5f) - (prev.x + prev.width * 0.5f);
+    const float dy = (rect.y + rect.height * 0.5f) - (prev.y + prev.height * 0.5f);
+    const float diag = std::sqrt(static_cast<float>(prev.width * prev.width + prev.height * prev.height));
+    if (std::sqrt(dx * dx + dy * dy) > config_.motionThreshold * diag) return true;
+    if (prev.area() > 0 && std::abs(static_cast<float>(rect.area()) / prev.area() - 1.0f) > config_.motionThreshold) {
+        return true;
+    }
+
+    // 外观变化：卡片区域颜色占比
+    if (appearance.size() == track.appearance.size()) {
+        float diff = 0.0f;
+        for (size_t i = 0; i < appearance.size(); ++i) {
+            diff += std::abs(appearance[i] - track.appearance[i]);
+        }
+        if (diff > config_.appearanceThreshold) return true;
+    }
+    return false;
+}
+
+cv::Rect DetectionSession::partialRegion(const cv::Rect& dirty, const cv::Rect& full) const {
+    const int margin = config_.dirtyMargin;
+    cv::Rect roi = cv::Rect(dirty.x - margin, dirty.y - margin,
+                            dirty.width + 2 * margin, dirty.height + 2 * margin) & full;
+
+    // 与区域相交的缓存卡片整体纳入，避免卡片被区域边界截断
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (const auto& c : lastCards_) {
+            cv::Rect r(c.tl_x - margin, c.tl_y - margin,
+                       c.br_x - c.tl_x + 2 * margin, c.br_y - c.tl_y + 2 * margin);
+            r &= full;
+            if ((r & roi).area() > 0 && (r | roi) != roi) {
+                roi |= r;
+                grown = true;
+            }
+        }
+    }
+
+    if (roi.area() > config_.motion.fullFrameRatio * full.area()) {
+        return full;
+    }
+    return roi;
+}
+
+void DetectionSession::detectRegion(const cv::Mat& bgr, const cv::Rect& roi, std::vector<DetectedCard>& cards,
+                                    StageTimings& timings) {
+    const QualityLevel& quality = governor_.level();
+
+    // roi为整帧时直接使用原图，否则在子图上检测，结果平移回原图坐标
+    cv::Mat image = (roi.x == 0 && roi.y == 0 && roi.width == bgr.cols && roi.height == bgr.rows) ? bgr : bgr(roi);
+
+    // 降档时在缩小的工作分辨率上检测，结果再换算回原图坐标
+    auto start = std::chrono::steady_clock::now();
+    float workScale = 1.0f;
+    if (quality.scale < 1.0f) {
+        cv::Mat scaled;
+        cv::resize(image, scaled, cv::Size(), quality.scale, quality.scale, cv::INTER_AREA);
+        if (!scaled.empty()) {
+            image = scaled;
+            workScale = quality.scale;
+        }
+    }
+    const float sx = static_cast<float>(roi.width) / image.cols;
+    const float sy = static_cast<float>(roi.height) / image.rows;
+    timings.scaleMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    ColorFrame frame = buildColorFrame(image, getDefaultColorRanges());
+    timings.colorMs += elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    DetectionResult det = detectDotCards(image, frame, false, quality.maxMarks, workScale);
+    timings.detectMs += elapsedMs(start);
+    if (!det.success) return;
+
+    auto toGlobal = [&roi, sx, sy](const cv::Rect& r) {
+        return cv::Rect(cvRound(r.x * sx) + roi.x, cvRound(r.y * sy) + roi.y,
+                        cvRound(r.width * sx), cvRound(r.height * sy));
+    };
+
+    std::vector<bool> matched(tracks_.size(), false);
+    std::vector<CardTrack> created;
+    for (const Card& card : det.cards) {
+        const cv::Rect globalRect = toGlobal(card.boundingRect);
+        std::vector<float> appearance = cardAppearance(frame, card.boundingRect);
+
+        CardTrack* track = matchTrack(globalRect, matched);
+        CardTrack fresh;
+        if (!track) {
+            fresh.trackId = nextTrackId_++;
+            track = &fresh;
+        }
+
+        if (needsDecode(*track, globalRect, appearance)) {
+            start = std::chrono::steady_clock::now();
+            CardDecode decode = decodeDetectedCard(decoder_, frame, det, card, quality.maxCornerAttempts);
+            timings.decodeMs += elapsedMs(start);
+            ++decodeCount_;
+            if (decode.decoded()) {
+                track->confirmations = (decode.cardId == track->decode.cardId) ? track->confirmations + 1 : 1;
+                track->decode = decode;
+            } else if (track->confirmations < config_.confirmCount) {
+                // 未确认的轨迹解码失败时不保留旧ID
+                track->decode = CardDecode();
+                track->confirmations = 0;
+            }
+            track->lastDecodeFrame = frameIndex_;
+            track->lastDecodeRect = globalRect;
+            track->appearance = appearance;
+        } else {
+            ++skippedDecodeCount_;
+        }
+        track->boundingRect = globalRect;
+        track->lastSeenFrame = frameIndex_;
+
+        DetectedCard out = toDetectedCard(card, track->decode);
+        out.tl_x = globalRect.x;
+        out.tl_y = globalRect.y;
+        out.br_x = globalRect.x + globalRect.width;
+        out.br_y = globalRect.y + globalRect.height;
+        out.track_id = track->trackId;
+        cards.push_back(out);
+
+        if (track == &fresh) {
+            created.push_back(fresh);
+        }
+    }
+    tracks_.insert(tracks_.end(), created.begin(), created.end());
+}
+
+int DetectionSession::processGated(const cv::Mat& small, cv::Size size, const std::function<cv::Mat()>& loadBgr,
+                                   DetectedCard* outCards, int maxOutCards) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++frameIndex_;
+
+    const bool gated = config_.motionGating && hasResult_ && !small.empty();
+    MotionState motion = gated ? gate_.evaluate(small, size) : MotionState();
+
+    // 延迟调节器拉长关键帧间隔时，两次检测之间复用上一帧结果
+    const int keyframeInterval = governor_.level().keyframeInterval;
+    const bool betweenKeyframes = hasResult_ && keyframeInterval > 1 && frameIndex_ - lastKeyframe_ < keyframeInterval;
+
+    if ((gated && motion.unchanged()) || betweenKeyframes) {
+        // 画面无变化或处于两个关键帧之间：直接复用上一帧结果
+        ++reusedFrameCount_;
+        for (auto& c : lastCards_) {
+            c.reused = 1;
+            touchTrack(c.track_id);
+        }
+    } else {
+        StageTimings timings;
+        const auto start = std::chrono::steady_clock::now();
+        cv::Mat bgr = loadBgr();
+        if (bgr.empty()) return 0;
+        timings.convertMs = elapsedMs(start);
+
+        const cv::Rect full(0, 0, bgr.cols, bgr.rows);
+        const cv::Rect roi = (gated && motion.reference) ? partialRegion(motion.dirtyRect, full) : full;
+
+        std::vector<DetectedCard> cards;
+        if (roi != full) {
+            // 局部变化：区域外的缓存卡片原样保留，只在区域内重新检测
+            for (const auto& c : lastCards_) {
+                cv::Rect r(c.tl_x, c.tl_y, c.br_x - c.tl_x, c.br_y - c.tl_y);
+                if ((r & roi).area() > 0) continue;
+                DetectedCard kept = c;
+                kept.reused = 1;
+                touchTrack(kept.track_id);
+                cards.push_back(kept);
+            }
+        }
+        detectRegion(bgr, roi, cards, timings);
+        lastKeyframe_ = frameIndex_;
+
+        if (config_.motionGating && !small.empty()) {
+            gate_.commit(small);
+        }
+        lastCards_.swap(cards);
+        hasResult_ = true;
+
+        timings.totalMs = elapsedMs(start);
+        governor_.report(timings);
+    }
+    // 复用帧同样老化轨迹：卡片拿走后桌面静止（或处于关键帧之间）时也能按时发出REMOVE
+    pruneTracks();
+    publishEvents();
+
+    const int written = std::min(maxOutCards, static_cast<int>(lastCards_.size()));
+    std::copy(lastCards_.begin(), lastCards_.begin() + written, outCards);
+    return written;
+}
+
+int DetectionSession::process(const cv::Mat& bgr, DetectedCard* outCards, int maxOutCards) {
+    if (!outCards || maxOutCards <= 0 || bgr.empty()) return 0;
+    if (bgr.type() == CV_8UC3 && bgr.isContinuous()) {
+        recordFrame(FrameStream::PIXEL_FORMAT_BGR8, bgr.data, bgr.cols, bgr.rows);
+    }
+    cv::Mat small = config_.motionGating ? gate_.downsample(bgr) : cv::Mat();
+    return processGated(small, bgr.size(), [&bgr]() { return bgr; }, outCards, maxOutCards);
+}
+
+int DetectionSession::processNv21(const unsigned char* nv21, int width, int height,
+                                  DetectedCard* outCards, int maxOutCards) {
+    if (!outCards || maxOutCards <= 0 || !nv21 || width <= 0 || height <= 0) return 0;
+    recordFrame(FrameStream::PIXEL_FORMAT_NV21, nv21, width, height);
+    // Y平面即为亮度，门控无需颜色转换
+    cv::Mat luma(height, width, CV_8UC1, const_cast<unsigned char*>(nv21));
+    cv::Mat small = config_.motionGating ? gate_.downsample(luma) : cv::Mat();
+    auto loadBgr = [nv21, width, height]() {
+        cv::Mat yuv(height + height / 2, width, CV_8UC1, const_cast<unsigned char*>(nv21));
+        cv::Mat bgr;
+        cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_NV21);
+        return bgr;
+    };
+    return processGated(small, cv::Size(width, height), loadBgr, outCards, maxOutCards);
+}
+
+} // namespace DotCardDetect
@@ -0,0 +1,209 @@
+#ifndef DETECT_SESSION_H
+#define DETECT_SESSION_H
+
+#include "dot_card_detect.h"
+#include "color_frame.h"
+#include "detect_decode_api.h"
+#include "card_encoder_decoder_c_api.h"
+#include "motion_gate.h"
+#include "frame_stream.h"
+#include "card_event_ring.h"
+#include "latency_governor.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <vector>
+
+namespace DotCardDetect {
+
+// 单张卡片的解码结果
+struct CardDecode {
+    int cardId;
+    int groupType;
+    int codeCorner;     // 读码所用mark在图像中的卡片角（0=TL,1=TR,2=BR,3=BL）；四角编码相同，并非卡片旋转方向
+    float confidence;
+
+    CardDecode() : cardId(-1), groupType(-1), codeCorner(-1), confidence(0.0f) {}
+    bool decoded() const { return cardId >= 0; }
+};
+
+/**
+ * 解码单张卡片：四角卡片优先使用透视校正图块，否则逐个角点使用检测阶段的区域颜色
+ * @param decoder 解码器句柄
+ * @param frame 单帧颜色统计上下文
+ * @param det 检测结果
+ * @param card 待解码卡片
+ * @param maxCornerAttempts 逐角点解码的尝试次数上限，-1表示不限制
+ * @return 解码结果
+ */
+CardDecode decodeDetectedCard(CardDecoderHandle decoder,
+                              const ColorFrame& frame,
+                              const DetectionResult& det,
+                              const Card& card,
+                              int maxCornerAttempts = -1);
+
+// 会话配置
+struct DetectionSessionConfig {
+    int confirmCount;           // ID被连续确认多少次后跳过解码
+    int reverifyInterval;       // 已确认轨迹每隔多少帧重新解码一次
+    float motionThreshold;      // 相对最近一次解码时的位置，中心位移超过卡片对角线的该比例（或面积变化超过该比例）时视为大幅移动
+    float appearanceThreshold;  // 卡片区域颜色占比变化（L1）超过该值时视为外观变化
+    int maxMissedFrames;        // 轨迹连续丢失超过该帧数后删除（门控复用帧同样计数）
+    bool motionGating;          // 是否启用运动门控（画面无变化时复用上一帧结果）
+    int dirtyMargin;            // 局部重检测时变化区域向外扩展的像素数（覆盖mark延伸区域）
+    MotionGateConfig motion;    // 运动门控参数
+    float moveEpsilon;          // 包围盒任一边变化超过该像素数时才发出MOVE事件
+    int eventCapacity;          // 增量事件环形缓冲区容量
+    LatencyGovernorConfig governor;  // 单帧延迟预算（默认不限制）
+
+    DetectionSessionConfig()
+        : confirmCount(3), reverifyInterval(30), motionThreshold(0.25f),
+          appearanceThreshold(0.15f), maxMissedFrames(5), motionGating(true), dirtyMargin(32),
+          moveEpsilon(4.0f), eventCapacity(256) {}
+};
+
+// 卡片轨迹：跨帧保持的卡片位置与已解码ID
+struct CardTrack {
+    int trackId;
+    cv::Rect boundingRect;
+    CardDecode decode;
+    int confirmations;          // 同一ID被连续解码确认的次数
+    int lastDecodeFrame;        // 最近一次解码所在帧
+    cv::Rect lastDecodeRect;    // 最近一次解码时的外接矩形，大幅移动相对它判断，缓慢漂移也会累计触发
+    int lastSeenFrame;          // 最近一次被检测到所在帧
+    std::vector<float> appearance;  // 卡片区域内各颜色像素占比
+
+    // 已通过增量事件发布的状态
+    bool published;             // 是否已发出ADD
+    DetectedCard publishedCard; // 最近一次发布的位姿
+    int publishedCardId;        // 最近一次发出ID_CONFIRMED的ID
+
+    CardTrack()
+        : trackId(-1), confirmations(0), lastDecodeFrame(-1), lastSeenFrame(-1),
+          published(false), publishedCard(), publishedCardId(-1) {}
+};
+
+// 检测会话：在连续帧之间维护卡片轨迹，已确认的轨迹复用缓存ID，
+// 只在周期复核、大幅移动或外观变化时重新解码
+class DetectionSession {
+public:
+    explicit DetectionSession(const DetectionSessionConfig& config = DetectionSessionConfig());
+    ~DetectionSession();
+
+    DetectionSession(const DetectionSession&) = delete;
+    DetectionSession& operator=(const DetectionSession&) = delete;
+
+    /**
+     * 处理一帧BGR图像
+     * @param bgr BGR图像
+     * @param outCards 输出卡片数组
+     * @param maxOutCards 输出数组容量
+     * @return 写入的卡片数
+     */
+    int process(const cv::Mat& bgr, DetectedCard* outCards, int maxOutCards);
+
+    /**
+     * 处理一帧NV21图像；运动门控直接使用Y平面，画面无变化时不做颜色转换
+     * @param nv21 NV21数据
+     * @param width 图像宽度
+     * @param height 图像高度
+     * @param outCards 输出卡片数组
+     * @param maxOutCards 输出数组容量
+     * @return 写入的卡片数
+     */
+    int processNv21(const unsigned char* nv21, int width, int height, DetectedCard* outCards, int maxOutCards);
+
+    // 清空全部轨迹（已发布的轨迹发出REMOVE事件）
+    void reset();
+
+    /**
+     * 取出待处理的增量事件（可与process在不同线程调用，不阻塞处理线程）
+     * @param outEvents 输出事件数组
+     * @param maxEvents 输出数组容量
+     * @return 写入的事件数
+     */
+    int pollEvents(CardEvent* outEvents, int maxEvents);
+
+    /**
+     * 设置MOVE事件的位移阈值
+     * @param pixels 包围盒任一边的最小变化像素数
+     */
+    void setMoveEpsilon(float pixels);
+
+    /**
+     * 开始录制送入会话的原始帧（帧流格式见frame_stream.h），文件在收到第一帧、确定尺寸与格式后创建
+     * @param path 帧流文件路径
+     * @param metadata 元数据（例如标定参数JSON）
+     * @param compress 是否按帧LZ4压缩
+     */
+    void startRecording(const std::string& path, const std::string& metadata, bool compress);
+
+    // 停止录制并写入索引
+    void stopRecording();
+
+    /**
+     * 设置单帧延迟预算，超出时逐级降低工作分辨率、拉长关键帧间隔、限制候选mark数与解码重试
+     * @param budgetMs 预算毫秒数，<=0 关闭调节
+     */
+    void setLatencyBudget(float budgetMs);
+
+    /**
+     * 读取统计信息（含当前质量档位与各阶段耗时）
+     * @param out 输出统计
+     */
+    void getStats(DetectSessionStats& out);
+
+    // 统计：累计解码次数与跳过次数
+    int decodeCount() const { return decodeCount_; }
+    int skippedDecodeCount() const { return skippedDecodeCount_; }
+    // 统计：整帧复用上一帧结果的次数
+    int reusedFrameCount() const { return reusedFrameCount_; }
+
+private:
+    int processGated(const cv::Mat& small, cv::Size size, const std::function<cv::Mat()>& loadBgr,
+                     DetectedCard* outCards, int maxOutCards);
+    void detectRegion(const cv::Mat& bgr, const cv::Rect& roi, std::vector<DetectedCard>& cards,
+                      StageTimings& timings);
+    cv::Rect partialRegion(const cv::Rect& dirty, const cv::Rect& full) const;
+    CardTrack* findTrack(int trackId);
+    void touchTrack(int trackId);
+    void pruneTracks();
+    void publishEvents();
+    void pushEvent(int type, const CardTrack& track, const DetectedCard& card);
+    void recordFrame(FrameStream::PixelFormat format, const unsigned char* data, int width, int height);
+    CardTrack* matchTrack(const cv::Rect& rect, std::vector<bool>& matched);
+    bool needsDecode(const CardTrack& track, const cv::Rect& rect, const std::vector<float>& appearance) const;
+
+    DetectionSessionConfig config_;
+    CardDecoderHandle decoder_;
+    std::vector<CardTrack> tracks_;
+    MotionGate gate_;
+    LatencyGovernor governor_;
+    int lastKeyframe_;                      // 最近一次实际检测所在帧
+    std::vector<DetectedCard> lastCards_;   // 上一处理帧的输出（原图坐标）
+    bool hasResult_;
+    int frameIndex_;
+    int nextTrackId_;
+    int decodeCount_;
+    int skippedDecodeCount_;
+    int reusedFrameCount_;
+    std::mutex mutex_;
+
+    // 增量事件：处理线程写入，消费线程取出
+    CardEventRing events_;
+    std::atomic<bool> resyncRequested_;
+
+    // 录制状态
+    std::unique_ptr<FrameStream::Writer> recorder_;
+    std::string recordPath_;
+    std::string recordMetadata_;
+    bool recordCompress_;
+    bool recordPending_;
+    std::mutex recordMutex_;
+};
+
+} // namespace DotCardDetect
+
+#endif // DETECT_SESSION_H
@@ -0,0 +1,70 @@
+#include "dot_card_debug.h"
+#include "image_processing.h"
+#include <stdexcept>
+
+namespace DotCardDetect {
+
+cv::Mat loadImage(const std::string& path) {
+    return cv::imread(path);
+}
+
+void showColorMasks(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges) {
+    for (const auto& colorPair : colorRanges) {
+        const std::string& colorName = colorPair.first;
+        const ColorRange& colorRange = colorPair.second;
+        
+        cv::Mat mask;
+        if (colorName == "Red2") {
+            mask = createRedMask(hsv, colorRanges);
+#ifndef __ANDROID__
+            if (!mask.empty()) cv::imshow("Red mask", mask);
+#endif
+        } else if (colorName == "Red") {
+            continue;
+        } else {
+            cv::inRange(hsv, colorRange.lower, colorRange.upper, mask);
+#ifndef __ANDROID__
+            cv::imshow(colorName + " mask", mask);
+#endif
+        }
+    }
+}
+
+#ifndef __ANDROID__
+static void highGuiShow(const std::string& name, const cv::Mat& image) {
+    if (!image.empty()) cv::imshow(name, image);
+}
+
+static void highGuiWait() {
+    cv::waitKey(0);
+    cv::destroyAllWindows();
+}
+#endif
+
+void installHighGuiDebugViewer() {
+#ifndef __ANDROID__
+    setDebugViewer(highGuiShow, highGuiWait);
+#endif
+}
+
+} // namespace DotCardDetect
+
+namespace ImageProcessing {
+
+std::tuple<cv::Mat, cv::Mat, cv::Mat> loadAndPreprocess(const std::string& imagePath,
+                                                       bool applyGrayscale,
+                                                       bool applyThreshold,
+                                                       const std::string& thresholdMethod,
+                                                       const std::map<std::string, int>& thresholdParams) {
+    cv::Mat originalImage = cv::imread(imagePath);
+    if (originalImage.empty()) {
+        throw std::runtime_error("无法加载图像: " + imagePath);
+    }
+    
+    auto result = preprocessImage(originalImage, applyGrayscale, applyThreshold, 
+                                 thresholdMethod, thresholdParams);
+    
+    return std::make_tuple(originalImage, result.first, result.second);
+}
+
+} // namespace ImageProcessing
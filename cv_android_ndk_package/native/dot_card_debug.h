@@ -0,0 +1,50 @@
+#ifndef DOT_CARD_DEBUG_H
+#define DOT_CARD_DEBUG_H
+
+// projectioncards_debug：图像文件读写与 HighGUI 可视化。
+// 核心库 projectioncards_core 只依赖 OpenCV core/imgproc，需要加载图片或显示调试窗口的
+// 桌面工具额外链接本库。
+#include "dot_card_detect.h"
+#include <opencv2/imgcodecs.hpp>
+#ifndef __ANDROID__
+#  include <opencv2/highgui.hpp>
+#endif
+#include <map>
+#include <string>
+#include <tuple>
+
+namespace DotCardDetect {
+
+/**
+ * 加载图像
+ * @param path 图像路径
+ * @return 加载的图像，如果失败返回空Mat
+ */
+cv::Mat loadImage(const std::string& path);
+
+/**
+ * 显示颜色掩码（调试用）
+ * @param hsv HSV图像
+ * @param colorRanges 颜色范围
+ */
+void showColorMasks(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges);
+
+/**
+ * 将核心库的调试图像输出接到 HighGUI 窗口（Android 上无 HighGUI，调用无效果）
+ * 之后以 debug=true 调用 detectDotCards 等函数时会弹出中间结果窗口
+ */
+void installHighGuiDebugViewer();
+
+} // namespace DotCardDetect
+
+namespace ImageProcessing {
+
+std::tuple<cv::Mat, cv::Mat, cv::Mat> loadAndPreprocess(const std::string& imagePath,
+                                                       bool applyGrayscale = true,
+                                                       bool applyThreshold = true,
+                                                       const std::string& thresholdMethod = "otsu",
+                                                       const std::map<std::string, int>& thresholdParams = {});
+
+} // namespace ImageProcessing
+
+#endif // DOT_CARD_DEBUG_H
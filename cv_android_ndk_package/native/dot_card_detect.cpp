@@ -1,6 +1,10 @@
 #include "dot_card_detect.h"
 #include "image_processing.h"
+#include "color_frame.h"
+#include "region_template_cache.h"
+#include "json_writer.h"
 #include <cmath>
+#include <cstdio>
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
@@ -14,8 +18,49 @@
 
 namespace DotCardDetect {
 
-cv::Mat loadImage(const std::string& path) {
-    return cv::imread(path);
+namespace {
+
+// 原图分辨率下的mark尺寸门限（像素）。在缩小的工作分辨率上检测时，
+// 长度门限按scale、面积门限按scale²缩放，使同一张卡片在各质量档位下通过相同的筛选
+constexpr double MARK_MIN_AREA = 36.0;
+constexpr double MARK_MAX_AREA = 50000.0;
+constexpr double MARK_MIN_SIDE = 10.0;          // 外接矩形宽、高须大于该值
+constexpr double MARK_MIN_PERIMETER = 16.0;
+constexpr double MARK_MAX_PERIMETER = 1000.0;
+
+DebugShowFn g_debugShow = nullptr;
+DebugWaitFn g_debugWait = nullptr;
+
+void debugShow(const std::string& name, const cv::Mat& image) {
+    if (g_debugShow) g_debugShow(name, image);
+}
+
+void debugWait() {
+    if (g_debugWait) g_debugWait();
+}
+
+// 将各颜色掩码输出到调试接口（Red与Red2合并显示）
+void debugShowColorMasks(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges) {
+    if (!g_debugShow) return;
+    for (const auto& colorPair : colorRanges) {
+        const std::string& colorName = colorPair.first;
+        if (colorName == "Red") continue;
+        cv::Mat mask;
+        if (colorName == "Red2") {
+            mask = createRedMask(hsv, colorRanges);
+            debugShow("Red mask", mask);
+        } else {
+            cv::inRange(hsv, colorPair.second.lower, colorPair.second.upper, mask);
+            debugShow(colorName + " mask", mask);
+        }
+    }
+}
+
+} // namespace
+
+void setDebugViewer(DebugShowFn show, DebugWaitFn wait) {
+    g_debugShow = show;
+    g_debugWait = wait;
 }
 
 cv::Mat dotPreprocess(const cv::Mat& img, bool debug) {
@@ -24,13 +69,10 @@ cv::Mat dotPreprocess(const cv::Mat& img, bool debug) {
     cv::Mat threshold = result.second;
     
     if (debug) {
-#ifndef __ANDROID__
-        cv::imshow("original", img);
-        cv::imshow("grayscale", grayscale);
-        cv::imshow("threshold", threshold);
-        cv::waitKey(0);
-        cv::destroyAllWindows();
-#endif
+        debugShow("original", img);
+        debugShow("grayscale", grayscale);
+        debugShow("threshold", threshold);
+        debugWait();
     }
     
     return threshold;
@@ -89,12 +131,18 @@ bool checkSquareEdges(const std::vector<cv::Point>& approx) {
 bool verifyWhitePixelRatio(const std::vector<cv::Point>& approx, 
                           const cv::Mat& thresholdImg, 
                           double minRatio) {
-    cv::Mat mask = cv::Mat::zeros(thresholdImg.size(), CV_8UC1);
+    // 只在多边形的外接矩形内统计，避免为每个候选分配并扫描整帧掩码
+    cv::Rect roi = cv::boundingRect(approx) & cv::Rect(0, 0, thresholdImg.cols, thresholdImg.rows);
+    if (roi.width <= 0 || roi.height <= 0) {
+        return false;
+    }
+    
+    cv::Mat mask = cv::Mat::zeros(roi.size(), CV_8UC1);
     std::vector<std::vector<cv::Point>> contours = {approx};
-    cv::fillPoly(mask, contours, cv::Scalar(255));
+    cv::fillPoly(mask, contours, cv::Scalar(255), cv::LINE_8, 0, -roi.tl());
     
     cv::Mat maskedRegion;
-    cv::bitwise_and(thresholdImg, mask, maskedRegion);
+    cv::bitwise_and(thresholdImg(roi), mask, maskedRegion);
     
     int totalPixels = cv::countNonZero(mask);
     int whitePixels = cv::countNonZero(maskedRegion);
@@ -107,30 +155,174 @@ bool verifyWhitePixelRatio(const std::vector<cv::Point>& approx,
     return whiteRatio >= minRatio;
 }
 
-std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExtendedRegionsForColorsOptimized(
-    cv::Mat& img,
-    const std::vector<cv::Point>& approx,
-    const cv::Mat& hsv,
-    const std::map<std::string, ColorRange>& colorRanges,
-    const std::map<std::string, cv::Mat>& precomputedColorMasks) {
+std::vector<MarkCandidate> extractMarkCandidates(const cv::Mat& thresholdImg, cv::Mat& labels, float scale) {
+    std::vector<MarkCandidate> candidates;
+    const double minArea = MARK_MIN_AREA * scale * scale;
+    const double minSide = MARK_MIN_SIDE * scale;
+    const double maxPerimeter = MARK_MAX_PERIMETER * scale;
     
-    cv::Mat dotMask = cv::Mat::zeros(img.rows, img.cols, CV_8UC1);
+    cv::Mat stats, centroids;
+    int numLabels = cv::connectedComponentsWithStats(thresholdImg, labels, stats, centroids, 8, CV_32S);
+    
+    candidates.reserve(64);
+    // 标签0为背景
+    for (int i = 1; i < numLabels; ++i) {
+        const int* st = stats.ptr<int>(i);
+        int area = st[cv::CC_STAT_AREA];
+        int w = st[cv::CC_STAT_WIDTH];
+        int h = st[cv::CC_STAT_HEIGHT];
+        
+        // 像素面积不小于轮廓面积，下限可直接沿用轮廓阶段的阈值
+        if (area < minArea) {
+            continue;
+        }
+        
+        // 连通域外接矩形与外轮廓的外接矩形一致，尺寸与长宽比判断与轮廓阶段等价
+        if (w <= minSide || h <= minSide) {
+            continue;
+        }
+        double aspectRatio = static_cast<double>(w) / h;
+        if (aspectRatio < 0.5 || aspectRatio > 2.0) {
+            continue;
+        }
+        
+        // 跨越整个外接矩形的闭合轮廓周长不小于两倍对角线长度
+        if (2.0 * std::hypot(w - 1, h - 1) > maxPerimeter) {
+            continue;
+        }
+        
+        // 任意角度的正方形至少占外接矩形的一半，留出余量以过滤细线与空心结构
+        double fillRatio = static_cast<double>(area) / (static_cast<double>(w) * h);
+        if (fillRatio < 0.25) {
+            continue;
+        }
+        
+        const double* ct = centroids.ptr<double>(i);
+        
+        MarkCandidate candidate;
+        candidate.label = i;
+        candidate.area = area;
+        candidate.boundingRect = cv::Rect(st[cv::CC_STAT_LEFT], st[cv::CC_STAT_TOP], w, h);
+        candidate.centroid = cv::Point2f(static_cast<float>(ct[0]), static_cast<float>(ct[1]));
+        candidate.fillRatio = fillRatio;
+        candidates.push_back(candidate);
+    }
+    
+    return candidates;
+}
+
+bool approximateMarkCandidate(const MarkCandidate& candidate,
+                              const cv::Mat& labels,
+                              const cv::Mat& thresholdImg,
+                              std::vector<cv::Point>& approx,
+                              float scale) {
+    const cv::Rect& roi = candidate.boundingRect;
+    
+    // 仅在候选的外接矩形内提取该连通域的外轮廓
+    cv::Mat componentMask = (labels(roi) == candidate.label);
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(componentMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, roi.tl());
+    if (contours.empty()) {
+        return false;
+    }
+    
+    // 单个8连通域只有一条外轮廓
+    const auto& contour = contours.front();
+    double area = cv::contourArea(contour);
+    
+    const double areaScale = static_cast<double>(scale) * scale;
+    if (area < MARK_MIN_AREA * areaScale || area > MARK_MAX_AREA * areaScale) {
+        return false;
+    }
+    
+    double perimeter = cv::arcLength(contour, true);
+    
+    if (perimeter < MARK_MIN_PERIMETER * scale || perimeter > MARK_MAX_PERIMETER * scale) {
+        return false;
+    }
+    
+    double compactness = 4 * M_PI * area / (perimeter * perimeter);
+    if (compactness < 0.3) {
+        return false;
+    }
+    
+    std::vector<cv::Point> hull;
+    cv::convexHull(contour, hull);
+    double hullArea = cv::contourArea(hull);
+    double convexityRatio = area / hullArea;
+    if (convexityRatio < 0.85) {
+        return false;
+    }
+    
+    cv::approxPolyDP(contour, approx, 0.01 * perimeter, true);
     
-    std::map<std::string, int> colorNameToId = {
-        {"Red", 0}, {"Red2", 0},
-        {"Yellow", 1},
-        {"Green", 2},
-        {"Cyan", 3},
-        {"Blue", 4},
-        {"Indigo", 5}
+    if (approx.size() < 4 || approx.size() > 6) {
+        return false;
+    }
+    
+    if (!checkSquareEdges(approx)) {
+        return false;
+    }
+    
+    return verifyWhitePixelRatio(approx, thresholdImg, 0.6);
+}
+
+std::vector<std::vector<cv::Point>> detectMarks(const cv::Mat& thresholdImg, float scale) {
+    cv::Mat labels;
+    std::vector<MarkCandidate> candidates = extractMarkCandidates(thresholdImg, labels, scale);
+    
+    std::vector<std::vector<cv::Point>> rectangles;
+    rectangles.reserve(50);
+    
+    auto processCandidateBatch = [&](size_t start, size_t end) -> std::vector<std::vector<cv::Point>> {
+        std::vector<std::vector<cv::Point>> localRectangles;
+        
+        for (size_t i = start; i < end; ++i) {
+            std::vector<cv::Point> approx;
+            if (approximateMarkCandidate(candidates[i], labels, thresholdImg, approx, scale)) {
+                localRectangles.push_back(approx);
+            }
+        }
+        return localRectangles;
     };
     
-    std::map<std::string, std::string> directionToCode = {
+    const size_t numThreads = std::min(static_cast<size_t>(std::thread::hardware_concurrency()), candidates.size());
+    
+    if (numThreads > 1 && candidates.size() > 100) {
+        std::vector<std::future<std::vector<std::vector<cv::Point>>>> futures;
+        const size_t batchSize = candidates.size() / numThreads;
+        
+        for (size_t t = 0; t < numThreads; ++t) {
+            size_t start = t * batchSize;
+            size_t end = (t == numThreads - 1) ? candidates.size() : (t + 1) * batchSize;
+            
+            futures.push_back(std::async(std::launch::async, processCandidateBatch, start, end));
+        }
+        
+        // 按批次顺序合并，结果顺序与单线程一致
+        for (auto& future : futures) {
+            auto localRectangles = future.get();
+            rectangles.insert(rectangles.end(), localRectangles.begin(), localRectangles.end());
+        }
+    } else {
+        rectangles = processCandidateBatch(0, candidates.size());
+    }
+    
+    return rectangles;
+}
+
+RegionColorResult analyzeExtendedRegions(
+    const std::vector<cv::Point>& approx,
+    const ColorFrame& frame,
+    cv::Mat* dotMask,
+    cv::Mat* canvas) {
+    
+    RegionColorResult result;
+    
+    static const std::map<std::string, std::string> directionToCode = {
         {"up", "U"}, {"down", "D"}, {"left", "L"}, {"right", "R"}
     };
     
-    std::map<std::string, std::pair<int, int>> regionColors;
-    
     cv::Rect boundingRect = cv::boundingRect(approx);
     int x = boundingRect.x;
     int y = boundingRect.y;
@@ -143,50 +335,14 @@ std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExt
     
     bool isRotated = maskRatio < 0.9;
     
-    int imgHeight = img.rows;
-    int imgWidth = img.cols;
+    int imgHeight = frame.rows();
+    int imgWidth = frame.cols();
+    const cv::Rect imageRect(0, 0, imgWidth, imgHeight);
     
     int extendW = static_cast<int>(w * 2);
     int extendH = static_cast<int>(h * 2);
     
     std::map<std::string, cv::Rect> regions;
-    std::map<std::string, cv::Mat> triangularMasks;
-    
-    auto createTriangularMask = [&](const cv::Rect& rect, const std::string& direction) -> cv::Mat {
-        cv::Mat mask = cv::Mat::zeros(rect.height, rect.width, CV_8UC1);
-        
-        if (direction == "up") {
-            std::vector<cv::Point> triangle = {
-                cv::Point(0, rect.height - 1),
-                cv::Point(rect.width - 1, rect.height - 1),
-                cv::Point(rect.width / 2, 0)
-            };
-            cv::fillPoly(mask, triangle, cv::Scalar(255));
-        } else if (direction == "down") {
-            std::vector<cv::Point> triangle = {
-                cv::Point(0, 0),
-                cv::Point(rect.width - 1, 0),
-                cv::Point(rect.width / 2, rect.height - 1)
-            };
-            cv::fillPoly(mask, triangle, cv::Scalar(255));
-        } else if (direction == "left") {
-            std::vector<cv::Point> triangle = {
-                cv::Point(rect.width - 1, 0),
-                cv::Point(rect.width - 1, rect.height - 1),
-                cv::Point(0, rect.height / 2)
-            };
-            cv::fillPoly(mask, triangle, cv::Scalar(255));
-        } else if (direction == "right") {
-            std::vector<cv::Point> triangle = {
-                cv::Point(0, 0),
-                cv::Point(0, rect.height - 1),
-                cv::Point(rect.width - 1, rect.height / 2)
-            };
-            cv::fillPoly(mask, triangle, cv::Scalar(255));
-        }
-        
-        return mask;
-    };
     
     regions["up"] = cv::Rect(std::max(0, x), std::max(0, y - extendH), 
                             std::min(imgWidth - std::max(0, x), w), 
@@ -201,15 +357,8 @@ std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExt
                                std::min(imgWidth - std::min(imgWidth, x + w), extendW), 
                                std::min(imgHeight - std::max(0, y), h));
     
-    for (const auto& regionPair : regions) {
-        const std::string& direction = regionPair.first;
-        const cv::Rect& rect = regionPair.second;
-        if (rect.width > 0 && rect.height > 0) {
-            triangularMasks[direction] = createTriangularMask(rect, direction);
-        }
-    }
-    
     double angle = 0;
+    cv::Mat rotationMatrix;
     
     if (isRotated) {
         cv::RotatedRect rotatedRect = cv::minAreaRect(approx);
@@ -221,27 +370,49 @@ std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExt
         }
         if (normalizedAngle < 1.0) {
             angle = 0;
-            isRotated = false;
         }
         
-        std::cout << "Rectangle angle: " << angle << std::endl;
+        // 仅在调试绘制时输出；写到stderr，不干扰批处理模式stdout上的JSON Lines
+        if (canvas) {
+            std::fprintf(stderr, "Rectangle angle: %g\n", angle);
+        }
         
         cv::Point2f boundingCenter(x + w / 2.0f, y + h / 2.0f);
+        rotationMatrix = cv::getRotationMatrix2D(boundingCenter, -angle, 1.0);
+    }
+    
+    result.angle = angle;
+    result.rotated = isRotated;
+    
+    // 未被图像边界裁剪时的扩展区域，用于判断能否套用缓存模板
+    std::map<std::string, cv::Rect> unclippedRegions = {
+        {"up", cv::Rect(x, y - extendH, w, extendH)},
+        {"down", cv::Rect(x, y + h, w, extendH)},
+        {"left", cv::Rect(x - extendW, y, extendW, h)},
+        {"right", cv::Rect(x + w, y, extendW, h)}
+    };
+    
+    RegionTemplateCache& templateCache = defaultRegionTemplateCache();
+    
+    std::vector<RowSpan> spans;
+    std::vector<std::pair<size_t, double>> detectedColors;
+    
+    for (const auto& regionPair : regions) {
+        const std::string& direction = regionPair.first;
+        const cv::Rect& rect = regionPair.second;
         
-        for (const auto& regionPair : regions) {
-            const std::string& direction = regionPair.first;
-            const cv::Rect& rect = regionPair.second;
-            
-            if (rect.width <= 0 || rect.height <= 0) continue;
-
+        if (rect.width <= 0 || rect.height <= 0) continue;
+        
+        RegionDirection regionDirection = regionDirectionFromName(direction);
+        std::vector<std::vector<cv::Point>> outline;
+        
+        if (isRotated && canvas) {
             std::vector<cv::Point2f> corners = {
                 cv::Point2f(rect.x, rect.y),
                 cv::Point2f(rect.x + rect.width, rect.y),
                 cv::Point2f(rect.x + rect.width, rect.y + rect.height),
                 cv::Point2f(rect.x, rect.y + rect.height)
             };
-            
-            cv::Mat rotationMatrix = cv::getRotationMatrix2D(boundingCenter, -angle, 1.0);
             std::vector<cv::Point2f> rotatedCorners;
             cv::transform(corners, rotatedCorners, rotationMatrix);
             
@@ -249,167 +420,135 @@ std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExt
             for (const auto& corner : rotatedCorners) {
                 rotatedCornersInt.push_back(cv::Point(static_cast<int>(corner.x), static_cast<int>(corner.y)));
             }
-
-            cv::Mat mask = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-
-            std::vector<std::vector<cv::Point>> contours = {rotatedCornersInt};
-            cv::Mat rectMask = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-            cv::fillPoly(rectMask, contours, cv::Scalar(255));
-
-            if (triangularMasks.find(direction) != triangularMasks.end()) {
-                cv::Mat triangleMask = triangularMasks[direction];
-
-                cv::Mat transformedTriangleMask = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-                cv::Mat triangleFullSize = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-                triangleMask.copyTo(triangleFullSize(rect));
-                
-                cv::warpAffine(triangleFullSize, transformedTriangleMask, rotationMatrix, cv::Size(imgWidth, imgHeight));
-
-                cv::bitwise_and(rectMask, transformedTriangleMask, mask);
-            } else {
-                mask = rectMask;
-            }
-            
-            cv::polylines(img, contours, true, cv::Scalar(255, 0, 0), 2);
-            
-            int regionArea = cv::countNonZero(mask);
-            if (regionArea == 0) continue;
-            
-            bool colorDetected = false;
-            std::vector<std::pair<std::string, double>> detectedColors;
-
-            for (const auto& maskPair : precomputedColorMasks) {
-                const std::string& colorName = maskPair.first;
-                const cv::Mat& colorMask = maskPair.second;
-                
-                cv::Mat regionColorMask;
-                cv::bitwise_and(colorMask, mask, regionColorMask);
-                
-                int maskPixels = cv::countNonZero(regionColorMask);
-                double maskRatioColor = regionArea > 0 ? static_cast<double>(maskPixels) / regionArea : 0;
-                
-                if (maskRatioColor > 0.1) {
-                    colorDetected = true;
-                    detectedColors.push_back({colorName, maskRatioColor});
-                    std::cout << "Detected " << colorName << " in " << direction 
-                             << " region with ratio: " << std::fixed << std::setprecision(3) 
-                             << maskRatioColor << std::endl;
+            outline.push_back(rotatedCornersInt);
+            cv::polylines(*canvas, outline, true, cv::Scalar(255, 0, 0), 2);
+        } else if (canvas) {
+            cv::rectangle(*canvas, rect, cv::Scalar(255, 0, 0), 2);
+        }
+        
+        // 区域完整落在图像内时直接套用按(宽, 高, 方向, 角度桶)缓存的行区间模板
+        const std::vector<RowSpan>* regionSpans = nullptr;
+        cv::Point spanOffset;
+        int regionArea = 0;
+        RegionTemplateHandle regionTemplate;
+        
+        if (rect == unclippedRegions[direction]) {
+            regionTemplate = templateCache.acquire(w, h, regionDirection, isRotated ? angle : 0.0);
+            if (regionTemplate && !regionTemplate->spans.empty()) {
+                cv::Rect placed = regionTemplate->bounds + cv::Point(x, y);
+                if ((placed & imageRect) == placed) {
+                    regionSpans = &regionTemplate->spans;
+                    spanOffset = cv::Point(x, y);
+                    regionArea = regionTemplate->area;
                 }
             }
-
-            if (detectedColors.size() >= 2) {
-                std::sort(detectedColors.begin(), detectedColors.end(), 
-                         [](const auto& a, const auto& b) { return a.second > b.second; });
-                
-                std::string regionCode = directionToCode[direction];
-                int nearColorId = colorNameToId[detectedColors[0].first];
-                int farColorId = colorNameToId[detectedColors[1].first];
-                regionColors[regionCode] = {nearColorId, farColorId};
-            } else if (detectedColors.size() == 1) {
-                std::string regionCode = directionToCode[direction];
-                int colorId = colorNameToId[detectedColors[0].first];
-                // 若仅检测到一种颜色，则近/远都使用该颜色以符合简化4元组语义
-                regionColors[regionCode] = {colorId, colorId};
+        }
+        
+        // 区域被图像边界裁剪：直接栅格化
+        if (!regionSpans) {
+            std::vector<cv::Point2f> triangle = extendedRegionTriangle(rect, regionDirection);
+            if (isRotated) {
+                // 旋转区域：直接变换三角形顶点，无需整帧warpAffine
+                std::vector<cv::Point2f> rotatedTriangle;
+                cv::transform(triangle, rotatedTriangle, rotationMatrix);
+                triangle.swap(rotatedTriangle);
             }
             
-            if (colorDetected) {
-                cv::polylines(img, contours, true, cv::Scalar(0, 0, 255), 2);
-
-                cv::bitwise_or(dotMask, mask, dotMask);
-            }
+            spans.clear();
+            rasterizeConvexPolygon(triangle, imageRect, spans);
+            regionSpans = &spans;
+            regionArea = spanArea(spans);
         }
         
-        return std::make_tuple(dotMask, angle, regionColors);
-    }
-
-    for (const auto& regionPair : regions) {
-        const std::string& direction = regionPair.first;
-        const cv::Rect& rect = regionPair.second;
+        if (regionArea == 0) continue;
         
-        if (rect.width <= 0 || rect.height <= 0) continue;
+        detectedColors.clear();
         
-        cv::rectangle(img, rect, cv::Scalar(255, 0, 0), 2);
-
-        cv::Mat regionMask = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-        cv::Mat rectMask = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-        rectMask(rect) = cv::Scalar(255);
-
-        if (triangularMasks.find(direction) != triangularMasks.end()) {
-            cv::Mat triangleMask = triangularMasks[direction];
-            cv::Mat triangleFullSize = cv::Mat::zeros(imgHeight, imgWidth, CV_8UC1);
-            triangleMask.copyTo(triangleFullSize(rect));
-            cv::bitwise_and(rectMask, triangleFullSize, regionMask);
-        } else {
-            regionMask = rectMask;
-        }
-        
-        int regionArea = cv::countNonZero(regionMask);
-        bool colorDetected = false;
-        std::vector<std::pair<std::string, double>> detectedColors;
-
-        for (const auto& maskPair : precomputedColorMasks) {
-            const std::string& colorName = maskPair.first;
-            const cv::Mat& colorMask = maskPair.second;
-            
-            cv::Mat regionColorMask;
-            cv::bitwise_and(colorMask, regionMask, regionColorMask);
-            
-            int maskPixels = cv::countNonZero(regionColorMask);
-            double maskRatioColor = regionArea > 0 ? static_cast<double>(maskPixels) / regionArea : 0;
+        // 每种颜色的计数只需逐行查询积分图，与区域面积无关
+        for (size_t colorIndex = 0; colorIndex < frame.colorCount(); ++colorIndex) {
+            int maskPixels = frame.countInSpans(colorIndex, *regionSpans, spanOffset);
+            double maskRatioColor = static_cast<double>(maskPixels) / regionArea;
             
             if (maskRatioColor > 0.1) {
-                colorDetected = true;
-                detectedColors.push_back({colorName, maskRatioColor});
-                std::cout << "Detected " << colorName << " in " << direction 
-                         << " region with ratio: " << std::fixed << std::setprecision(3) 
-                         << maskRatioColor << std::endl;
+                detectedColors.push_back({colorIndex, maskRatioColor});
+                if (canvas) {
+                    std::fprintf(stderr, "Detected %s in %s region with ratio: %.3f\n",
+                                 frame.colorNames[colorIndex].c_str(), direction.c_str(), maskRatioColor);
+                }
             }
         }
-
+        
+        if (detectedColors.empty()) continue;
+        
+        std::string regionCode = directionToCode.at(direction);
         if (detectedColors.size() >= 2) {
             std::sort(detectedColors.begin(), detectedColors.end(), 
                      [](const auto& a, const auto& b) { return a.second > b.second; });
             
-            std::string regionCode = directionToCode[direction];
-            int nearColorId = colorNameToId[detectedColors[0].first];
-            int farColorId = colorNameToId[detectedColors[1].first];
-            regionColors[regionCode] = {nearColorId, farColorId};
-        } else if (detectedColors.size() == 1) {
-            std::string regionCode = directionToCode[direction];
-            int colorId = colorNameToId[detectedColors[0].first];
-            regionColors[regionCode] = {colorId, colorId};
+            int nearColorId = frame.colorIds[detectedColors[0].first];
+            int farColorId = frame.colorIds[detectedColors[1].first];
+            result.regionColors[regionCode] = {nearColorId, farColorId};
+        } else {
+            int colorId = frame.colorIds[detectedColors[0].first];
+            // 若仅检测到一种颜色，则近/远都使用该颜色以符合简化4元组语义
+            result.regionColors[regionCode] = {colorId, colorId};
         }
         
-        if (colorDetected) {
-            cv::rectangle(img, rect, cv::Scalar(0, 0, 255), 2);
-            cv::bitwise_or(dotMask, regionMask, dotMask);
+        if (canvas) {
+            if (isRotated) {
+                cv::polylines(*canvas, outline, true, cv::Scalar(0, 0, 255), 2);
+            } else {
+                cv::rectangle(*canvas, rect, cv::Scalar(0, 0, 255), 2);
+            }
+        }
+        
+        if (dotMask) {
+            for (const auto& span : *regionSpans) {
+                uchar* row = dotMask->ptr<uchar>(span.y + spanOffset.y);
+                std::fill(row + span.x0 + spanOffset.x, row + span.x1 + spanOffset.x, static_cast<uchar>(255));
+            }
         }
     }
     
+    return result;
+}
 
-    if (!regionColors.empty()) {
-        // 按固定顺序输出 U, R, D, L
-        std::string jsonStr = "{";
-        bool first = true;
-        std::vector<std::string> orderedRegions = {"U", "R", "D", "L"};
-        for (const auto& key : orderedRegions) {
+std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExtendedRegionsForColorsOptimized(
+    cv::Mat& img,
+    const std::vector<cv::Point>& approx,
+    const cv::Mat& hsv,
+    const std::map<std::string, ColorRange>& colorRanges,
+    const std::map<std::string, cv::Mat>& precomputedColorMasks) {
+    
+    (void)colorRanges;
+    
+    cv::Mat dotMask = cv::Mat::zeros(img.rows, img.cols, CV_8UC1);
+    
+    ColorFrame frame = buildColorFrameFromMasks(hsv, precomputedColorMasks);
+    RegionColorResult regionResult = analyzeExtendedRegions(approx, frame, &dotMask, &img);
+    const auto& regionColors = regionResult.regionColors;
+    
+    if (!regionResult.rotated && !regionColors.empty()) {
+        // 按固定顺序输出 U, R, D, L：{"U": [近色, 远色], ...}
+        static thread_local JsonOutput::JsonWriter json(JsonOutput::JsonStyle::SPACED, 128);
+        json.clear();
+        json.beginObject();
+        for (const char* key : {"U", "R", "D", "L"}) {
             auto it = regionColors.find(key);
             if (it == regionColors.end()) continue;
-            if (!first) jsonStr += ", ";
-            jsonStr += "\"" + key + "\":(" + std::to_string(it->second.first) + "," + std::to_string(it->second.second) + ")";
-            first = false;
+            json.key(key).beginArray().value(it->second.first).value(it->second.second).endArray();
         }
-        jsonStr += "}";
+        json.endObject();
 
         cv::Rect boundingRect = cv::boundingRect(approx);
         cv::Point textPos(boundingRect.x + boundingRect.width/2 - 50, 
                          boundingRect.y + boundingRect.height/2);
 
-        cv::putText(img, jsonStr, textPos, cv::FONT_HERSHEY_SIMPLEX, 0.5, 
+        cv::putText(img, json.str(), textPos, cv::FONT_HERSHEY_SIMPLEX, 0.5, 
                    cv::Scalar(64, 64, 64), 2, cv::LINE_AA);
     }
     
-    return std::make_tuple(dotMask, angle, regionColors);
+    return std::make_tuple(dotMask, regionResult.angle, regionColors);
 }
 
 std::pair<cv::Mat, double> checkExtendedRegionsForColors(
@@ -457,7 +596,7 @@ std::pair<cv::Mat, double> checkExtendedRegionsForColors(
     if (isRotated) {
         cv::RotatedRect rotatedRect = cv::minAreaRect(approx);
         angle = rotatedRect.angle;
-        std::cout << "Rectangle angle: " << angle << std::endl;
+        std::fprintf(stderr, "Rectangle angle: %g\n", angle);
         
         cv::Point2f boundingCenter(x + w / 2.0f, y + h / 2.0f);
         
@@ -522,9 +661,8 @@ std::pair<cv::Mat, double> checkExtendedRegionsForColors(
                 
                 if (maskRatioColor > 0.1) {
                     colorDetected = true;
-                    std::cout << "Detected " << colorName << " in " << direction 
-                             << " region with ratio: " << std::fixed << std::setprecision(3) 
-                             << maskRatioColor << std::endl;
+                    std::fprintf(stderr, "Detected %s in %s region with ratio: %.3f\n",
+                                 colorName.c_str(), direction.c_str(), maskRatioColor);
                     break;
                 }
             }
@@ -575,9 +713,8 @@ std::pair<cv::Mat, double> checkExtendedRegionsForColors(
             
             if (maskRatioColor > 0.1) {
                 colorDetected = true;
-                std::cout << "Detected " << colorName << " in " << direction 
-                         << " region with ratio: " << std::fixed << std::setprecision(3) 
-                         << maskRatioColor << std::endl;
+                std::fprintf(stderr, "Detected %s in %s region with ratio: %.3f\n",
+                             colorName.c_str(), direction.c_str(), maskRatioColor);
                 break;
             }
         }
@@ -606,34 +743,6 @@ std::map<std::string, ColorRange> getDefaultColorRanges() {
     return colorRanges;
 }
 
-void showColorMasks(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges) {
-    for (const auto& colorPair : colorRanges) {
-        const std::string& colorName = colorPair.first;
-        const ColorRange& colorRange = colorPair.second;
-        
-        cv::Mat mask;
-        if (colorName == "Red2") {
-            auto redIt = colorRanges.find("Red");
-            if (redIt != colorRanges.end()) {
-                cv::Mat redMask1, redMask2;
-                cv::inRange(hsv, redIt->second.lower, redIt->second.upper, redMask1);
-                cv::inRange(hsv, colorRange.lower, colorRange.upper, redMask2);
-                cv::bitwise_or(redMask1, redMask2, mask);
-#ifndef __ANDROID__
-                cv::imshow("Red mask", mask);
-#endif
-            }
-        } else if (colorName == "Red") {
-            continue;
-        } else {
-            cv::inRange(hsv, colorRange.lower, colorRange.upper, mask);
-#ifndef __ANDROID__
-            cv::imshow(colorName + " mask", mask);
-#endif
-        }
-    }
-}
-
 cv::Mat createRedMask(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges) {
     cv::Mat redMask;
     auto redIt = colorRanges.find("Red");
@@ -892,275 +1001,123 @@ std::vector<Card> pairRectanglesIntoCards(const std::vector<std::vector<cv::Poin
 }
 
 DetectionResult detectDotCards(const cv::Mat& img, bool debug) {
-    DetectionResult result;
-    
     if (img.empty()) {
         std::cerr << "Error: Input image is empty" << std::endl;
-        return result;
+        return DetectionResult();
     }
     
-    cv::Mat hsv, gray;
-    cv::cvtColor(img, hsv, cv::COLOR_BGR2HSV);
-    cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
-    
-    std::map<std::string, ColorRange> colorRanges = getDefaultColorRanges();
-    
+    return detectDotCards(img, buildColorFrame(img, getDefaultColorRanges()), debug);
+}
 
-    std::map<std::string, cv::Mat> precomputedColorMasks;
-    for (const auto& colorPair : colorRanges) {
-        const std::string& colorName = colorPair.first;
-        const ColorRange& colorRange = colorPair.second;
-        
-        cv::Mat colorMask;
-        if (colorName == "Red") {
-            cv::Mat mask1, mask2;
-            cv::inRange(hsv, colorRange.lower, colorRange.upper, mask1);
-            auto red2It = colorRanges.find("Red2");
-            if (red2It != colorRanges.end()) {
-                cv::inRange(hsv, red2It->second.lower, red2It->second.upper, mask2);
-                cv::bitwise_or(mask1, mask2, colorMask);
-            } else {
-                colorMask = mask1;
-            }
-        } else if (colorName != "Red2") {
-            cv::inRange(hsv, colorRange.lower, colorRange.upper, colorMask);
-        }
-        
-        if (!colorMask.empty()) {
-            precomputedColorMasks[colorName] = colorMask;
-        }
+DetectionResult detectDotCards(const cv::Mat& img, const ColorFrame& frame, bool debug, int maxMarks, float scale) {
+    DetectionResult result;
+    
+    if (img.empty()) {
+        std::cerr << "Error: Input image is empty" << std::endl;
+        return result;
     }
     
     if (debug) {
-        showColorMasks(hsv, colorRanges);
-#ifndef __ANDROID__
-        cv::imshow("original", img);
-        cv::waitKey(0);
-        cv::destroyAllWindows();
-#endif
+        cv::Mat hsv = frame.hsv;
+        if (hsv.empty()) {
+            cv::cvtColor(img, hsv, cv::COLOR_BGR2HSV);
+        }
+        debugShowColorMasks(hsv, getDefaultColorRanges());
+        debugShow("original", img);
+        debugWait();
     }
     
-    cv::Mat imgThreshold = dotPreprocess(img, debug);
+    // 颜色统计上下文已在条带前端中顺带生成了二值图，调试模式下仍走dotPreprocess以显示中间结果
+    cv::Mat imgThreshold = (debug || frame.threshold.empty()) ? dotPreprocess(img, debug) : frame.threshold;
     
     result.rectMask = cv::Mat::zeros(img.rows, img.cols, CV_8UC1);
     result.dotMask = cv::Mat::zeros(img.rows, img.cols, CV_8UC1);
     
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy;
-    cv::findContours(imgThreshold, contours, hierarchy, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-    
-    cv::Mat imgCopy = img.clone();
-    
+    // 绘制只用于调试显示，非调试模式下不复制整帧
+    cv::Mat imgCopy;
+    if (debug) {
+        imgCopy = img.clone();
+    }
+    cv::Mat* canvas = debug ? &imgCopy : nullptr;
 
     result.rectangles.reserve(50);
-
-    const size_t numThreads = std::min(static_cast<size_t>(std::thread::hardware_concurrency()), contours.size());
-    std::vector<std::future<std::vector<std::vector<cv::Point>>>> futures;
-    std::mutex resultMutex;
-    
-    auto processContourBatch = [&](size_t start, size_t end) -> std::vector<std::vector<cv::Point>> {
-        std::vector<std::vector<cv::Point>> localRectangles;
-        
-        for (size_t i = start; i < end; ++i) {
-            const auto& contour = contours[i];
-            double area = cv::contourArea(contour);
-
-            if (area < 36) {
-                continue;
-            }
-            
-
-            if (area > 50000) {
-                continue;
-            }
-            
-
-            cv::Rect boundingRect = cv::boundingRect(contour);
-            double aspectRatio = static_cast<double>(boundingRect.width) / boundingRect.height;
-            if (aspectRatio < 0.5 || aspectRatio > 2.0) {
-                continue;
-            }
-            
-            double perimeter = cv::arcLength(contour, true);
-            
-
-            if (perimeter < 16 || perimeter > 1000) {
-                continue;
-            }
-            
-
-            double compactness = 4 * M_PI * area / (perimeter * perimeter);
-            if (compactness < 0.3) {
-                continue;
-            }
-            
-
-            std::vector<cv::Point> hull;
-            cv::convexHull(contour, hull);
-            double hullArea = cv::contourArea(hull);
-            double convexityRatio = area / hullArea;
-            if (convexityRatio < 0.85) {
-                continue;
-            }
-            
-            std::vector<cv::Point> approx;
-            cv::approxPolyDP(contour, approx, 0.01 * perimeter, true);
-            
-            if (approx.size() >= 4 && approx.size() <= 6) {
-                if (checkSquareEdges(approx)) {
-                    int x = boundingRect.x;
-                    int y = boundingRect.y;
-                    int w = boundingRect.width;
-                    int h = boundingRect.height;
-
-                    if (w > 10 && h > 10) {
-                        if (verifyWhitePixelRatio(approx, imgThreshold, 0.6)) {
-                            localRectangles.push_back(approx);
-                        }
-                    }
-                }
-            }
+    result.markRegionColors.reserve(50);
+
+    std::vector<std::vector<cv::Point>> marks = detectMarks(imgThreshold, scale);
+    if (maxMarks > 0 && static_cast<int>(marks.size()) > maxMarks) {
+        // 限制候选数：保留面积最大的mark，并保持原有顺序
+        std::vector<double> areas(marks.size());
+        std::vector<size_t> order(marks.size());
+        for (size_t i = 0; i < marks.size(); ++i) {
+            areas[i] = cv::contourArea(marks[i]);
+            order[i] = i;
         }
-        return localRectangles;
-    };
-    
+        std::stable_sort(order.begin(), order.end(), [&areas](size_t a, size_t b) { return areas[a] > areas[b]; });
+        order.resize(maxMarks);
+        std::sort(order.begin(), order.end());
+        std::vector<std::vector<cv::Point>> kept;
+        kept.reserve(order.size());
+        for (size_t i : order) kept.push_back(std::move(marks[i]));
+        marks.swap(kept);
+    }
 
-    if (numThreads > 1 && contours.size() > 100) {
-        const size_t batchSize = contours.size() / numThreads;
+    for (const auto& approx : marks) {
+        cv::Rect boundingRect = cv::boundingRect(approx);
+        int x = boundingRect.x;
+        int y = boundingRect.y;
+        int w = boundingRect.width;
+        int h = boundingRect.height;
         
-        for (size_t t = 0; t < numThreads; ++t) {
-            size_t start = t * batchSize;
-            size_t end = (t == numThreads - 1) ? contours.size() : (t + 1) * batchSize;
-            
-            futures.push_back(std::async(std::launch::async, processContourBatch, start, end));
+        std::vector<std::vector<cv::Point>> contours_fill = {approx};
+        cv::fillPoly(result.rectMask, contours_fill, cv::Scalar(255));
+        if (canvas) {
+            cv::rectangle(imgCopy, cv::Point(x, y), cv::Point(x + w, y + h), cv::Scalar(0, 255, 0), 2);
         }
         
+        result.rectangles.push_back(approx);
 
-        for (auto& future : futures) {
-            auto localRectangles = future.get();
-            for (const auto& approx : localRectangles) {
-                cv::Rect boundingRect = cv::boundingRect(approx);
-                int x = boundingRect.x;
-                int y = boundingRect.y;
-                int w = boundingRect.width;
-                int h = boundingRect.height;
-                
+        RegionColorResult regionResult = analyzeExtendedRegions(approx, frame, &result.dotMask, canvas);
+        result.angle = regionResult.angle;
+        const auto& regionColors = regionResult.regionColors;
 
-                std::vector<std::vector<cv::Point>> contours_fill = {approx};
-                cv::fillPoly(result.rectMask, contours_fill, cv::Scalar(255));
-                cv::rectangle(imgCopy, cv::Point(x, y), cv::Point(x + w, y + h), cv::Scalar(0, 255, 0), 2);
-                
-                result.rectangles.push_back(approx);
-                
-
-                auto dotResult = checkExtendedRegionsForColorsOptimized(imgCopy, approx, hsv, colorRanges, precomputedColorMasks);
-                cv::Mat dotMask = std::get<0>(dotResult);
-                result.angle = std::get<1>(dotResult);
-                auto regionColors = std::get<2>(dotResult);
-                
-
-                for (const auto& regionColor : regionColors) {
-                    result.regionColors[regionColor.first] = regionColor.second;
-                }
-                
-
-                if (!regionColors.empty()) {
-                    std::string jsonStr = "{";
-                    bool first = true;
-                    
-                    for (const auto& regionColor : regionColors) {
-                        const std::string& region = regionColor.first;
-                        int nearColor = regionColor.second.first;
-                        int farColor = regionColor.second.second;
-                        
-                        if (!first) {
-                            jsonStr += ", ";
-                        }
-                        jsonStr += "\"" + region + "\":(" + std::to_string(nearColor);
-                        if (farColor >= 0) {
-                            jsonStr += "," + std::to_string(farColor);
-                        }
-                        jsonStr += ")";
-                        first = false;
-                    }
-                    jsonStr += "}";
-                    
-                    cv::Point textPos(x, y + h + 15);
-                    
-                    if (textPos.y > imgCopy.rows - 10) {
-                        textPos.y = y - 5;
-                    }
-                    
-                    cv::putText(imgCopy, jsonStr, textPos, cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(64, 64, 64), 2);
-                }
-                
-                cv::bitwise_or(result.dotMask, dotMask, result.dotMask);
-            }
+        for (const auto& regionColor : regionColors) {
+            result.regionColors[regionColor.first] = regionColor.second;
         }
-    } else {
-        auto rectangles = processContourBatch(0, contours.size());
-        for (const auto& approx : rectangles) {
-            cv::Rect boundingRect = cv::boundingRect(approx);
-            int x = boundingRect.x;
-            int y = boundingRect.y;
-            int w = boundingRect.width;
-            int h = boundingRect.height;
-            
-            std::vector<std::vector<cv::Point>> contours_fill = {approx};
-            cv::fillPoly(result.rectMask, contours_fill, cv::Scalar(255));
-            cv::rectangle(imgCopy, cv::Point(x, y), cv::Point(x + w, y + h), cv::Scalar(0, 255, 0), 2);
-            
-            result.rectangles.push_back(approx);
-
-            auto dotResult = checkExtendedRegionsForColorsOptimized(imgCopy, approx, hsv, colorRanges, precomputedColorMasks);
-            cv::Mat dotMask = std::get<0>(dotResult);
-            result.angle = std::get<1>(dotResult);
-            auto regionColors = std::get<2>(dotResult);
-
+        result.markRegionColors.push_back(regionColors);
+        
+        if (canvas && !regionColors.empty()) {
+            // {"区域": [近色(, 远色)], ...}，远色缺失时只输出近色
+            static thread_local JsonOutput::JsonWriter json(JsonOutput::JsonStyle::SPACED, 128);
+            json.clear();
+            json.beginObject();
             for (const auto& regionColor : regionColors) {
-                result.regionColors[regionColor.first] = regionColor.second;
+                int nearColor = regionColor.second.first;
+                int farColor = regionColor.second.second;
+                json.key(regionColor.first).beginArray().value(nearColor);
+                if (farColor >= 0) {
+                    json.value(farColor);
+                }
+                json.endArray();
             }
+            json.endObject();
             
-            if (!regionColors.empty()) {
-                std::string jsonStr = "{";
-                bool first = true;
-                
-                for (const auto& regionColor : regionColors) {
-                    const std::string& region = regionColor.first;
-                    int nearColor = regionColor.second.first;
-                    int farColor = regionColor.second.second;
-                    
-                    if (!first) {
-                        jsonStr += ", ";
-                    }
-                    jsonStr += "\"" + region + "\":(" + std::to_string(nearColor);
-                    if (farColor >= 0) {
-                        jsonStr += "," + std::to_string(farColor);
-                    }
-                    jsonStr += ")";
-                    first = false;
-                }
-                jsonStr += "}";
-                
-
-                cv::Point textPos(x, y + h + 15);
-                
 
-                if (textPos.y > imgCopy.rows - 10) {
-                    textPos.y = y - 5;
-                }
-                
+            cv::Point textPos(x, y + h + 15);
+            
 
-                cv::putText(imgCopy, jsonStr, textPos, cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(64, 64, 64), 2);
+            if (textPos.y > imgCopy.rows - 10) {
+                textPos.y = y - 5;
             }
             
-            cv::bitwise_or(result.dotMask, dotMask, result.dotMask);
+
+            cv::putText(imgCopy, json.str(), textPos, cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(64, 64, 64), 2);
         }
     }
     
     result.cards = pairRectanglesIntoCards(result.rectangles, img);
     
-    for (const auto& card : result.cards) {
+    for (size_t ci = 0; canvas && ci < result.cards.size(); ++ci) {
+        const auto& card = result.cards[ci];
         for (size_t i = 0; i < card.corners.size(); ++i) {
             cv::Point start = card.corners[i];
             cv::Point end = card.corners[(i + 1) % card.corners.size()];
@@ -1169,16 +1126,14 @@ DetectionResult detectDotCards(const cv::Mat& img, bool debug) {
         
         cv::Point center = cv::Point(card.boundingRect.x + card.boundingRect.width / 2,
                                    card.boundingRect.y + card.boundingRect.height / 2);
-        std::string cardInfo = "Card " + std::to_string(&card - &result.cards[0] + 1);
+        std::string cardInfo = "Card " + std::to_string(ci + 1);
         cv::putText(imgCopy, cardInfo, center, cv::FONT_HERSHEY_SIMPLEX, 0.8, cv::Scalar(255, 0, 0), 2);
     }
 
     if (debug) {
-#ifndef __ANDROID__
-        cv::imshow("rect_mask", result.rectMask);
-        cv::imshow("original", imgCopy);
-        cv::imshow("all_dot_mask", result.dotMask);
-#endif
+        debugShow("rect_mask", result.rectMask);
+        debugShow("original", imgCopy);
+        debugShow("all_dot_mask", result.dotMask);
         
 
         std::cout << "\n=== Dot Mask ROI Analysis ===" << std::endl;
@@ -1242,20 +1197,15 @@ DetectionResult detectDotCards(const cv::Mat& img, bool debug) {
             
 
             std::string windowName = "Dot ROI " + std::to_string(i + 1);
-#ifndef __ANDROID__
-            cv::imshow(windowName, visualImage);
+            debugShow(windowName, visualImage);
 
             std::string roiWindowName = "Original ROI " + std::to_string(i + 1);
             std::string maskWindowName = "Mask " + std::to_string(i + 1);
-            cv::imshow(roiWindowName, roiImage);
-            cv::imshow(maskWindowName, roiMask);
-#endif
+            debugShow(roiWindowName, roiImage);
+            debugShow(maskWindowName, roiMask);
         }
         
-#ifndef __ANDROID__
-        cv::waitKey(0);
-        cv::destroyAllWindows();
-#endif
+        debugWait();
     }
     
     result.success = !result.rectangles.empty();
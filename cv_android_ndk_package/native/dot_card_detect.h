@@ -5,10 +5,6 @@
 #  if __has_include(<opencv2/core.hpp>)
 #    include <opencv2/core.hpp>
 #    include <opencv2/imgproc.hpp>
-#    include <opencv2/imgcodecs.hpp>
-#    ifndef __ANDROID__
-#      include <opencv2/highgui.hpp>
-#    endif
 #    define HAVE_OPENCV 1
 #  else
 #    define HAVE_OPENCV 0
@@ -17,10 +13,6 @@
 #  if __has_include(<opencv2/core.hpp>)
 #    include <opencv2/core.hpp>
 #    include <opencv2/imgproc.hpp>
-#    include <opencv2/imgcodecs.hpp>
-#    ifndef __ANDROID__
-#      include <opencv2/highgui.hpp>
-#    endif
 #    ifndef HAVE_OPENCV
 #      define HAVE_OPENCV 1
 #    endif
@@ -80,18 +72,50 @@ struct DetectionResult {
     // 颜色ID: 0=Red, 1=Yellow, 2=Green, 3=Cyan, 4=Blue, 5=Indigo
     std::map<std::string, std::pair<int, int>> regionColors;
     
+    // 每个mark各自的区域颜色，与rectangles一一对应，供解码阶段直接复用
+    std::vector<std::map<std::string, std::pair<int, int>>> markRegionColors;
+    
     // 检测到的卡片信息
     std::vector<Card> cards;         // 配对后的卡片列表
     
     DetectionResult() : angle(0.0), success(false) {}
 };
 
+// 单帧颜色统计上下文（见color_frame.h）
+struct ColorFrame;
+
+// 单个mark扩展区域的颜色分析结果
+struct RegionColorResult {
+    double angle;            // mark旋转角度
+    bool rotated;            // 是否按旋转区域处理
+    // 键为区域代码(U/D/L/R)，值为(近距离颜色ID, 远距离颜色ID)
+    std::map<std::string, std::pair<int, int>> regionColors;
+    
+    RegionColorResult() : angle(0.0), rotated(false) {}
+};
+
+// 连通域候选标记（由二值图单次连通域标记得到）
+struct MarkCandidate {
+    int label;                // 在标签图中的连通域编号
+    int area;                 // 像素面积
+    cv::Rect boundingRect;    // 外接矩形
+    cv::Point2f centroid;     // 质心
+    double fillRatio;         // 像素面积 / 外接矩形面积
+    
+    MarkCandidate() : label(0), area(0), fillRatio(0.0) {}
+};
+
+// 调试图像输出：核心库只依赖 core/imgproc，debug=true 时产生的中间图像交给调试输出接口，
+// 未设置时直接丢弃；projectioncards_debug 提供基于 HighGUI 的实现（见 dot_card_debug.h）
+typedef void (*DebugShowFn)(const std::string& name, const cv::Mat& image);
+typedef void (*DebugWaitFn)();
+
 /**
- * 加载图像
- * @param path 图像路径
- * @return 加载的图像，如果失败返回空Mat
+ * 设置调试图像输出接口
+ * @param show 输出一张命名的调试图像
+ * @param wait 一组调试图像输出完毕（例如等待按键并关闭窗口）
  */
-cv::Mat loadImage(const std::string& path);
+void setDebugViewer(DebugShowFn show, DebugWaitFn wait);
 
 /**
  * 点卡预处理
@@ -119,6 +143,38 @@ bool verifyWhitePixelRatio(const std::vector<cv::Point>& approx,
                           const cv::Mat& thresholdImg, 
                           double minRatio = 0.65);
 
+/**
+ * 单次连通域标记提取候选标记，并按尺寸、长宽比、周长上界和填充率预筛选
+ * @param thresholdImg 二值化图像
+ * @param labels 输出的标签图（CV_32S），供后续按候选提取轮廓
+ * @param scale 图像相对原图的缩放比例，尺寸门限随之缩放
+ * @return 通过预筛选的候选列表
+ */
+std::vector<MarkCandidate> extractMarkCandidates(const cv::Mat& thresholdImg, cv::Mat& labels, float scale = 1.0f);
+
+/**
+ * 对单个候选在其外接矩形内提取轮廓，执行精确的形状检查并做多边形近似
+ * @param candidate 候选标记
+ * @param labels extractMarkCandidates输出的标签图
+ * @param thresholdImg 二值化图像
+ * @param approx 输出的近似多边形
+ * @param scale 图像相对原图的缩放比例，面积与周长门限随之缩放
+ * @return 是否为有效的正方形标记
+ */
+bool approximateMarkCandidate(const MarkCandidate& candidate,
+                              const cv::Mat& labels,
+                              const cv::Mat& thresholdImg,
+                              std::vector<cv::Point>& approx,
+                              float scale = 1.0f);
+
+/**
+ * 从二值化图像中检测正方形标记
+ * @param thresholdImg 二值化图像
+ * @param scale 图像相对原图的缩放比例，尺寸门限随之缩放
+ * @return 检测到的标记多边形
+ */
+std::vector<std::vector<cv::Point>> detectMarks(const cv::Mat& thresholdImg, float scale = 1.0f);
+
 /**
  * 检查扩展区域的颜色
  * @param img 输入图像（会被修改用于绘制）
@@ -151,6 +207,22 @@ std::tuple<cv::Mat, double, std::map<std::string, std::pair<int, int>>> checkExt
     const std::map<std::string, cv::Mat>& precomputedColorMasks
 );
 
+/**
+ * 基于单帧颜色统计上下文分析mark四周扩展区域的颜色
+ * 区域按行区间查询各颜色积分图，代价与区域面积无关
+ * @param approx 检测到的矩形轮廓
+ * @param frame 单帧颜色统计上下文
+ * @param dotMask 可选，检测到颜色的区域写入该掩码（与图像同尺寸的CV_8UC1）
+ * @param canvas 可选，用于绘制调试信息的图像
+ * @return 旋转角度与区域颜色
+ */
+RegionColorResult analyzeExtendedRegions(
+    const std::vector<cv::Point>& approx,
+    const ColorFrame& frame,
+    cv::Mat* dotMask = nullptr,
+    cv::Mat* canvas = nullptr
+);
+
 /**
  * 获取默认颜色范围
  * @return 颜色范围映射
@@ -166,11 +238,16 @@ std::map<std::string, ColorRange> getDefaultColorRanges();
 DetectionResult detectDotCards(const cv::Mat& img, bool debug = true);
 
 /**
- * 显示颜色掩码（调试用）
- * @param hsv HSV图像
- * @param colorRanges 颜色范围
+ * 点卡检测（复用调用方已构建的单帧颜色统计上下文）
+ * @param img 输入图像
+ * @param frame 由同一图像构建的颜色统计上下文
+ * @param debug 是否显示调试信息
+ * @param maxMarks 参与配对的候选mark上限，超出时保留面积最大者；0表示不限制
+ * @param scale img相对原图的缩放比例（质量档位的工作分辨率），mark尺寸门限随之缩放
+ * @return 检测结果
  */
-void showColorMasks(const cv::Mat& hsv, const std::map<std::string, ColorRange>& colorRanges);
+DetectionResult detectDotCards(const cv::Mat& img, const ColorFrame& frame, bool debug, int maxMarks = 0,
+                               float scale = 1.0f);
 
 /**
  * 创建红色掩码
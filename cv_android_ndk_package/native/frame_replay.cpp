@@ -0,0 +1,258 @@
+// 标准库
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "detect_decode_api.h"
+#include "frame_stream.h"
+
+#ifdef REPLAY_WITH_SHAPES
+#include "shape_detector_c_api.h"
+#endif
+
+// 离线回放：将录制的帧流送入 projectioncards（以及可选的 shape_detector_ndk）管线，
+// 统计每帧耗时分布，并可与基准结果逐帧比对
+
+static const int kMaxCards = 64;
+
+struct LatencyStats {
+    std::vector<double> samples;
+
+    void add(double ms) { samples.push_back(ms); }
+
+    void print(const char* name) const {
+        if (samples.empty()) return;
+        std::vector<double> sorted = samples;
+        std::sort(sorted.begin(), sorted.end());
+        auto pct = [&sorted](double p) {
+            size_t idx = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+            return sorted[std::min(idx, sorted.size() - 1)];
+        };
+        double sum = 0.0;
+        for (double v : sorted) sum += v;
+        std::printf("%-10s n=%zu mean=%.2fms p50=%.2fms p90=%.2fms p99=%.2fms max=%.2fms\n",
+                    name, sorted.size(), sum / sorted.size(), pct(0.50), pct(0.90), pct(0.99), sorted.back());
+    }
+};
+
+static double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void loadLines(const std::string& path, std::vector<std::string>& lines) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) lines.push_back(line);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: frame_replay <stream> [--realtime] [--stateless] [--shapes] [--limit N]"
+                     " [--budget MS] [--out results.jsonl] [--baseline results.jsonl]" << std::endl;
+        return 1;
+    }
+
+    std::string streamPath = argv[1];
+    bool realtime = false;
+    bool stateless = false;
+    bool withShapes = false;
+    long limit = -1;
+    float budgetMs = 0.0f;
+    std::string outPath;
+    std::string baselinePath;
+    for (int i = 2; i < argc; ++i) {
+        std::string opt = argv[i];
+        if (opt == "--realtime") realtime = true;
+        else if (opt == "--stateless") stateless = true;
+        else if (opt == "--shapes") withShapes = true;
+        else if (opt == "--limit" && i + 1 < argc) limit = std::atol(argv[++i]);
+        else if (opt == "--budget" && i + 1 < argc) budgetMs = static_cast<float>(std::atof(argv[++i]));
+        else if (opt == "--out" && i + 1 < argc) outPath = argv[++i];
+        else if (opt == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+    }
+
+#ifndef REPLAY_WITH_SHAPES
+    if (withShapes) {
+        std::cerr << "Built without shape_detector_ndk; --shapes ignored" << std::endl;
+        withShapes = false;
+    }
+#endif
+
+    FrameStream::Reader reader;
+    if (!reader.open(streamPath)) {
+        std::cerr << "Failed to open stream: " << reader.error() << std::endl;
+        return 2;
+    }
+    const FrameStream::StreamInfo& info = reader.info();
+    if (info.format != FrameStream::PIXEL_FORMAT_NV21 && info.format != FrameStream::PIXEL_FORMAT_BGR8) {
+        std::cerr << "Unsupported pixel format: " << info.format << std::endl;
+        return 2;
+    }
+    std::cout << "Stream: " << info.width << "x" << info.height
+              << (info.format == FrameStream::PIXEL_FORMAT_NV21 ? " NV21" : " BGR8")
+              << ", frames: " << reader.frameCount() << std::endl;
+    if (!info.metadata.empty()) {
+        std::cout << "Metadata: " << info.metadata << std::endl;
+    }
+
+    std::ofstream out;
+    if (!outPath.empty()) {
+        out.open(outPath);
+        if (!out) {
+            std::cerr << "Failed to open output: " << outPath << std::endl;
+            return 2;
+        }
+    }
+    std::vector<std::string> baseline;
+    if (!baselinePath.empty()) loadLines(baselinePath, baseline);
+
+    DetectSessionHandle session = stateless ? nullptr : detect_session_create();
+    if (session && budgetMs > 0.0f) {
+        detect_session_set_latency_budget(session, budgetMs);
+    }
+    std::vector<int> levelFrames;
+#ifdef REPLAY_WITH_SHAPES
+    if (withShapes && !shape_detector_init()) {
+        std::cerr << "shape_detector_init failed: " << shape_detector_get_last_error() << std::endl;
+        withShapes = false;
+    }
+#endif
+
+    LatencyStats cardStats;
+    LatencyStats shapeStats;
+    std::vector<DetectedCard> cards(kMaxCards);
+#ifdef REPLAY_WITH_SHAPES
+    std::vector<DetectedShape> shapes(kMaxCards);
+#endif
+    std::vector<size_t> diffFrames;
+    size_t compared = 0;
+
+    const size_t frameCount = (limit >= 0) ? std::min(reader.frameCount(), static_cast<size_t>(limit))
+                                           : reader.frameCount();
+    const auto replayStart = std::chrono::steady_clock::now();
+    uint64_t firstTimestamp = 0;
+    for (size_t i = 0; i < frameCount; ++i) {
+        FrameStream::FrameView frame;
+        if (!reader.frame(i, frame)) {
+            std::cerr << "Frame " << i << ": " << reader.error() << std::endl;
+            break;
+        }
+        if (i == 0) firstTimestamp = frame.timestampNs;
+
+        // 按录制时间戳节奏送帧
+        if (realtime) {
+            auto due = replayStart + std::chrono::nanoseconds(frame.timestampNs - firstTimestamp);
+            std::this_thread::sleep_until(due);
+        }
+
+        const unsigned char* data = frame.data;
+        auto start = std::chrono::steady_clock::now();
+        int n = 0;
+        if (info.format == FrameStream::PIXEL_FORMAT_NV21) {
+            n = session ? detect_session_process_nv21(session, data, info.width, info.height, cards.data(), kMaxCards)
+                        : detect_decode_cards_nv21(data, info.width, info.height, cards.data(), kMaxCards);
+        } else {
+            n = session ? detect_session_process_bgr8(session, data, info.width, info.height, cards.data(), kMaxCards)
+                        : detect_decode_cards_bgr8(data, info.width, info.height, cards.data(), kMaxCards);
+        }
+        cardStats.add(elapsedMs(start));
+        if (session && budgetMs > 0.0f) {
+            DetectSessionStats stats;
+            detect_session_get_stats(session, &stats);
+            levelFrames.resize(stats.quality_level_count, 0);
+            ++levelFrames[stats.quality_level];
+        }
+
+        // 结果行只包含确定性内容，便于逐行比对
+        std::ostringstream line;
+        line << "{\"frame\":" << i << ",\"cards\":[";
+        for (int k = 0; k < n; ++k) {
+            const DetectedCard& c = cards[k];
+            if (k) line << ",";
+            line << "[" << c.card_id << "," << c.group_type << "," << c.tl_x << "," << c.tl_y
+                 << "," << c.br_x << "," << c.br_y << "]";
+        }
+        line << "]";
+
+#ifdef REPLAY_WITH_SHAPES
+        if (withShapes) {
+            cv::Mat bgr;
+            if (info.format == FrameStream::PIXEL_FORMAT_NV21) {
+                cv::Mat yuv(info.height + info.height / 2, info.width, CV_8UC1, const_cast<unsigned char*>(data));
+                cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_NV21);
+            } else {
+                bgr = cv::Mat(info.height, info.width, CV_8UC3, const_cast<unsigned char*>(data));
+            }
+            ImageData image;
+            image.data = bgr.data;
+            image.width = bgr.cols;
+            image.height = bgr.rows;
+            image.channels = 3;
+
+            auto shapeStart = std::chrono::steady_clock::now();
+            const int shapeCount = shape_detector_detect_into(&image, false, shapes.data(),
+                                                              static_cast<int>(shapes.size()));
+            shapeStats.add(elapsedMs(shapeStart));
+
+            line << ",\"shapes\":[";
+            for (int k = 0; k < shapeCount; ++k) {
+                const DetectedShape& s = shapes[k];
+                char buf[96];
+                std::snprintf(buf, sizeof(buf), "%s[\"%s\",%.1f,%.1f]", k ? "," : "",
+                              s.shape_code, s.center.x, s.center.y);
+                line << buf;
+            }
+            line << "]";
+        }
+#endif
+        line << "}";
+
+        const std::string result = line.str();
+        if (out) out << result << "\n";
+        if (i < baseline.size()) {
+            ++compared;
+            if (baseline[i] != result) diffFrames.push_back(i);
+        }
+    }
+    const double totalMs = elapsedMs(replayStart);
+
+    if (session && budgetMs > 0.0f) {
+        DetectSessionStats stats;
+        detect_session_get_stats(session, &stats);
+        std::printf("Budget %.1fms: final quality level %d, avg %.2fms (last frame: convert %.2f scale %.2f"
+                    " color %.2f detect %.2f decode %.2f)\n", budgetMs, stats.quality_level, stats.average_ms,
+                    stats.convert_ms, stats.scale_ms, stats.color_ms, stats.detect_ms, stats.decode_ms);
+        for (size_t level = 0; level < levelFrames.size(); ++level) {
+            if (levelFrames[level] > 0) std::printf("  level %zu: %d frames\n", level, levelFrames[level]);
+        }
+    }
+    if (session) detect_session_destroy(session);
+#ifdef REPLAY_WITH_SHAPES
+    if (withShapes) shape_detector_cleanup();
+#endif
+
+    std::printf("Replayed %zu frames in %.1fms (%.1f fps)%s\n", cardStats.samples.size(), totalMs,
+                totalMs > 0.0 ? cardStats.samples.size() * 1000.0 / totalMs : 0.0,
+                realtime ? " at recorded speed" : "");
+    cardStats.print("cards");
+    shapeStats.print("shapes");
+
+    if (!baselinePath.empty()) {
+        std::printf("Baseline: %zu frames compared, %zu differ\n", compared, diffFrames.size());
+        for (size_t k = 0; k < diffFrames.size() && k < 10; ++k) {
+            std::printf("  frame %zu differs\n", diffFrames[k]);
+        }
+        return diffFrames.empty() ? 0 : 4;
+    }
+    return 0;
+}
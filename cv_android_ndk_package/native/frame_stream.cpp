@@ -0,0 +1,316 @@
+#include "frame_stream.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef FRAME_STREAM_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace FrameStream {
+
+namespace {
+
+const char FILE_MAGIC[8] = {'T', 'O', 'S', 'F', 'R', 'A', 'M', 'E'};
+const char INDEX_MAGIC[8] = {'T', 'O', 'S', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint32_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 32;
+constexpr size_t RECORD_BYTES = 24;
+constexpr size_t TRAILER_BYTES = 24;
+
+inline uint64_t align8(uint64_t v) { return (v + 7) & ~static_cast<uint64_t>(7); }
+
+inline void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+inline void putU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+inline uint32_t getU32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+inline uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+} // namespace
+
+size_t frameBytes(PixelFormat format, int width, int height) {
+    if (width <= 0 || height <= 0) return 0;
+    const size_t pixels = static_cast<size_t>(width) * static_cast<size_t>(height);
+    switch (format) {
+        case PIXEL_FORMAT_NV21: return pixels + pixels / 2;
+        case PIXEL_FORMAT_BGR8: return pixels * 3;
+        case PIXEL_FORMAT_GRAY8: return pixels;
+        default: return 0;
+    }
+}
+
+bool lz4Available() {
+#ifdef FRAME_STREAM_HAVE_LZ4
+    return true;
+#else
+    return false;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Writer
+
+Writer::Writer() : file_(nullptr), compress_(false), position_(0) {}
+
+Writer::~Writer() {
+    close();
+}
+
+bool Writer::open(const std::string& path, const StreamInfo& info, bool compress) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_ || frameBytes(info.format, info.width, info.height) == 0) return false;
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return false;
+
+    info_ = info;
+    compress_ = compress && lz4Available();
+    offsets_.clear();
+
+    uint8_t header[HEADER_BYTES] = {0};
+    std::memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+    putU32(header + 8, VERSION);
+    putU32(header + 12, static_cast<uint32_t>(info.format));
+    putU32(header + 16, static_cast<uint32_t>(info.width));
+    putU32(header + 20, static_cast<uint32_t>(info.height));
+    putU32(header + 24, static_cast<uint32_t>(info.metadata.size()));
+    putU32(header + 28, 0);
+
+    const uint64_t metadataEnd = HEADER_BYTES + info.metadata.size();
+    const uint8_t padding[8] = {0};
+    bool ok = std::fwrite(header, 1, HEADER_BYTES, file_) == HEADER_BYTES;
+    ok = ok && std::fwrite(info.metadata.data(), 1, info.metadata.size(), file_) == info.metadata.size();
+    ok = ok && std::fwrite(padding, 1, align8(metadataEnd) - metadataEnd, file_) == align8(metadataEnd) - metadataEnd;
+    if (!ok) {
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    position_ = align8(metadataEnd);
+    return true;
+}
+
+bool Writer::write(const uint8_t* data, uint64_t timestampNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_ || !data) return false;
+
+    const size_t rawBytes = frameBytes(info_.format, info_.width, info_.height);
+    const uint8_t* payload = data;
+    size_t payloadBytes = rawBytes;
+    uint32_t flags = 0;
+
+#ifdef FRAME_STREAM_HAVE_LZ4
+    if (compress_) {
+        scratch_.resize(static_cast<size_t>(LZ4_compressBound(static_cast<int>(rawBytes))));
+        int compressed = LZ4_compress_default(reinterpret_cast<const char*>(data), scratch_.data(),
+                                              static_cast<int>(rawBytes), static_cast<int>(scratch_.size()));
+        // 压缩无收益的帧按原始数据保存
+        if (compressed > 0 && static_cast<size_t>(compressed) < rawBytes) {
+            payload = reinterpret_cast<const uint8_t*>(scratch_.data());
+            payloadBytes = static_cast<size_t>(compressed);
+            flags |= FRAME_FLAG_LZ4;
+        }
+    }
+#endif
+
+    uint8_t record[RECORD_BYTES] = {0};
+    putU32(record, static_cast<uint32_t>(payloadBytes));
+    putU32(record + 4, flags);
+    putU64(record + 8, timestampNs);
+    putU32(record + 16, static_cast<uint32_t>(rawBytes));
+
+    const uint64_t end = position_ + RECORD_BYTES + payloadBytes;
+    const uint8_t padding[8] = {0};
+    bool ok = std::fwrite(record, 1, RECORD_BYTES, file_) == RECORD_BYTES;
+    ok = ok && std::fwrite(payload, 1, payloadBytes, file_) == payloadBytes;
+    ok = ok && std::fwrite(padding, 1, align8(end) - end, file_) == align8(end) - end;
+    if (!ok) return false;
+
+    offsets_.push_back(position_);
+    position_ = align8(end);
+    return true;
+}
+
+void Writer::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+
+    const uint64_t indexOffset = position_;
+    std::vector<uint8_t> index(offsets_.size() * 8 + TRAILER_BYTES);
+    for (size_t i = 0; i < offsets_.size(); ++i) {
+        putU64(index.data() + i * 8, offsets_[i]);
+    }
+    uint8_t* trailer = index.data() + offsets_.size() * 8;
+    putU64(trailer, offsets_.size());
+    putU64(trailer + 8, indexOffset);
+    std::memcpy(trailer + 16, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    std::fwrite(index.data(), 1, index.size(), file_);
+
+    std::fclose(file_);
+    file_ = nullptr;
+}
+
+// ---------------------------------------------------------------------------
+// Reader
+
+Reader::Reader() : base_(nullptr), size_(0) {}
+
+Reader::~Reader() {
+    close();
+}
+
+void Reader::close() {
+    if (base_) {
+        munmap(const_cast<uint8_t*>(base_), size_);
+    }
+    base_ = nullptr;
+    size_ = 0;
+    offsets_.clear();
+}
+
+bool Reader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(HEADER_BYTES)) {
+        ::close(fd);
+        error_ = "file too small";
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        error_ = "mmap failed";
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(mapped);
+    size_ = static_cast<size_t>(st.st_size);
+
+    if (std::memcmp(base_, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || getU32(base_ + 8) != VERSION) {
+        error_ = "not a frame stream (bad magic or version)";
+        close();
+        return false;
+    }
+    info_.format = static_cast<PixelFormat>(getU32(base_ + 12));
+    info_.width = static_cast<int>(getU32(base_ + 16));
+    info_.height = static_cast<int>(getU32(base_ + 20));
+    const uint32_t metadataBytes = getU32(base_ + 24);
+    if (HEADER_BYTES + metadataBytes > size_ || frameBytes(info_.format, info_.width, info_.height) == 0) {
+        error_ = "corrupt header";
+        close();
+        return false;
+    }
+    info_.metadata.assign(reinterpret_cast<const char*>(base_ + HEADER_BYTES), metadataBytes);
+
+    const uint64_t dataStart = align8(HEADER_BYTES + metadataBytes);
+    if (hasIndex()) {
+        // 有索引时逐条校验，索引损坏视为文件损坏而不是回退扫描
+        if (!parseIndex(dataStart)) {
+            close();
+            return false;
+        }
+    } else {
+        // 无索引（录制未正常结束）：顺序扫描
+        scanRecords(dataStart);
+    }
+    return true;
+}
+
+bool Reader::hasIndex() const {
+    if (size_ < HEADER_BYTES + TRAILER_BYTES) return false;
+    const uint8_t* trailer = base_ + size_ - TRAILER_BYTES;
+    return std::memcmp(trailer + 16, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0;
+}
+
+bool Reader::parseIndex(uint64_t dataStart) {
+    const uint8_t* trailer = base_ + size_ - TRAILER_BYTES;
+    const uint64_t count = getU64(trailer);
+    const uint64_t indexOffset = getU64(trailer + 8);
+    if (count > (size_ - TRAILER_BYTES) / 8 || indexOffset < dataStart ||
+        indexOffset + count * 8 + TRAILER_BYTES != size_) {
+        error_ = "corrupt index trailer";
+        return false;
+    }
+
+    // 每条记录（记录头与帧数据）必须完整位于数据区内，且原始帧大小与文件头一致
+    const size_t rawBytes = frameBytes(info_.format, info_.width, info_.height);
+    offsets_.resize(static_cast<size_t>(count));
+    for (uint64_t i = 0; i < count; ++i) {
+        const uint64_t offset = getU64(base_ + indexOffset + i * 8);
+        if (offset < dataStart || offset > indexOffset || indexOffset - offset < RECORD_BYTES ||
+            getU32(base_ + offset) > indexOffset - offset - RECORD_BYTES ||
+            getU32(base_ + offset + 16) != rawBytes) {
+            offsets_.clear();
+            error_ = "corrupt index entry " + std::to_string(i);
+            return false;
+        }
+        offsets_[i] = offset;
+    }
+    return true;
+}
+
+void Reader::scanRecords(uint64_t offset) {
+    offsets_.clear();
+    const size_t rawBytes = frameBytes(info_.format, info_.width, info_.height);
+    while (offset + RECORD_BYTES <= size_) {
+        const uint64_t payloadBytes = getU32(base_ + offset);
+        if (getU32(base_ + offset + 16) != rawBytes || offset + RECORD_BYTES + payloadBytes > size_) break;
+        offsets_.push_back(offset);
+        offset = align8(offset + RECORD_BYTES + payloadBytes);
+    }
+}
+
+bool Reader::frame(size_t index, FrameView& frame) {
+    if (index >= offsets_.size()) return false;
+    const uint8_t* record = base_ + offsets_[index];
+    const uint32_t payloadBytes = getU32(record);
+    const uint32_t flags = getU32(record + 4);
+    const uint32_t rawBytes = getU32(record + 16);
+    const uint8_t* payload = record + RECORD_BYTES;
+
+    frame.timestampNs = getU64(record + 8);
+    frame.bytes = rawBytes;
+    if (!(flags & FRAME_FLAG_LZ4)) {
+        frame.data = payload;
+        return payloadBytes == rawBytes;
+    }
+
+#ifdef FRAME_STREAM_HAVE_LZ4
+    scratch_.resize(rawBytes);
+    int decoded = LZ4_decompress_safe(reinterpret_cast<const char*>(payload),
+                                      reinterpret_cast<char*>(scratch_.data()),
+                                      static_cast<int>(payloadBytes), static_cast<int>(rawBytes));
+    if (decoded != static_cast<int>(rawBytes)) {
+        error_ = "LZ4 frame failed to decompress";
+        return false;
+    }
+    frame.data = scratch_.data();
+    return true;
+#else
+    error_ = "stream contains LZ4 frames but LZ4 support was not compiled in";
+    return false;
+#endif
+}
+
+} // namespace FrameStream
@@ -0,0 +1,145 @@
+#ifndef FRAME_STREAM_H
+#define FRAME_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 帧流文件：录制相机原始帧（NV21/BGR）及时间戳与标定元数据，供离线回放复现性能问题
+//
+// 文件布局（小端，各段按8字节对齐）：
+//   文件头   32字节：magic "TOSFRAME" | version | pixelFormat | width | height | metadataBytes | flags
+//   元数据   metadataBytes字节（UTF-8，例如标定参数JSON）
+//   帧记录   每帧24字节记录头：payloadBytes | flags(bit0=LZ4) | timestampNs(u64) | rawBytes | reserved，随后为帧数据
+//   索引     每帧偏移(u64)，末尾24字节：frameCount(u64) | indexOffset(u64) | magic "TOSINDEX"
+// 录制中断导致缺少索引时，读取端顺序扫描帧记录恢复；索引存在但越界时打开失败
+namespace FrameStream {
+
+enum PixelFormat : uint32_t {
+    PIXEL_FORMAT_NV21 = 1,
+    PIXEL_FORMAT_BGR8 = 2,
+    PIXEL_FORMAT_GRAY8 = 3
+};
+
+// 帧记录标志
+constexpr uint32_t FRAME_FLAG_LZ4 = 1u;
+
+/**
+ * 单帧原始数据字节数
+ * @return 字节数，格式未知时为0
+ */
+size_t frameBytes(PixelFormat format, int width, int height);
+
+// 是否编译了LZ4支持
+bool lz4Available();
+
+// 帧流元信息
+struct StreamInfo {
+    PixelFormat format;
+    int width;
+    int height;
+    std::string metadata;
+
+    StreamInfo() : format(PIXEL_FORMAT_NV21), width(0), height(0) {}
+};
+
+// 帧流写入器（线程安全）
+class Writer {
+public:
+    Writer();
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    /**
+     * 创建帧流文件并写入文件头
+     * @param path 文件路径
+     * @param info 帧格式、尺寸与元数据
+     * @param compress 是否按帧LZ4压缩（未编译LZ4时按原始数据保存）
+     * @return 是否成功
+     */
+    bool open(const std::string& path, const StreamInfo& info, bool compress = false);
+
+    /**
+     * 追加一帧
+     * @param data 帧数据（字节数须为frameBytes(format, width, height)）
+     * @param timestampNs 时间戳（纳秒）
+     * @return 是否成功
+     */
+    bool write(const uint8_t* data, uint64_t timestampNs);
+
+    // 写入索引并关闭文件
+    void close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    const StreamInfo& info() const { return info_; }
+    size_t frameCount() const { return offsets_.size(); }
+
+private:
+    std::FILE* file_;
+    StreamInfo info_;
+    bool compress_;
+    uint64_t position_;
+    std::vector<uint64_t> offsets_;
+    std::vector<char> scratch_;
+    std::mutex mutex_;
+};
+
+// 单帧视图：data在下一次读取前有效（LZ4帧解压到读取器内部缓冲区，原始帧直接指向映射内存）
+struct FrameView {
+    uint64_t timestampNs;
+    const uint8_t* data;
+    size_t bytes;
+
+    FrameView() : timestampNs(0), data(nullptr), bytes(0) {}
+};
+
+// 帧流读取器：内存映射文件，按索引随机访问
+class Reader {
+public:
+    Reader();
+    ~Reader();
+
+    Reader(const Reader&) = delete;
+    Reader& operator=(const Reader&) = delete;
+
+    /**
+     * 映射并解析帧流文件
+     * @param path 文件路径
+     * @return 是否成功（失败原因见error()；索引中任一记录越出数据区即失败）
+     */
+    bool open(const std::string& path);
+    void close();
+
+    const StreamInfo& info() const { return info_; }
+    size_t frameCount() const { return offsets_.size(); }
+    const std::string& error() const { return error_; }
+
+    /**
+     * 读取第index帧
+     * @param index 帧序号
+     * @param frame 输出帧视图
+     * @return 是否成功
+     */
+    bool frame(size_t index, FrameView& frame);
+
+private:
+    bool hasIndex() const;
+    bool parseIndex(uint64_t dataStart);
+    void scanRecords(uint64_t offset);
+
+    const uint8_t* base_;
+    size_t size_;
+    StreamInfo info_;
+    std::vector<uint64_t> offsets_;
+    std::vector<uint8_t> scratch_;
+    std::string error_;
+};
+
+} // namespace FrameStream
+
+#endif // FRAME_STREAM_H
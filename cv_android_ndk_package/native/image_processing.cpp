@@ -139,20 +139,4 @@ std::pair<cv::Mat, cv::Mat> preprocessImage(const cv::Mat& image,
     return std::make_pair(grayImage, thresholdImage);
 }
 
-std::tuple<cv::Mat, cv::Mat, cv::Mat> loadAndPreprocess(const std::string& imagePath,
-                                                       bool applyGrayscale,
-                                                       bool applyThreshold,
-                                                       const std::string& thresholdMethod,
-                                                       const std::map<std::string, int>& thresholdParams) {
-    cv::Mat originalImage = cv::imread(imagePath);
-    if (originalImage.empty()) {
-        throw std::runtime_error("无法加载图像: " + imagePath);
-    }
-    
-    auto result = preprocessImage(originalImage, applyGrayscale, applyThreshold, 
-                                 thresholdMethod, thresholdParams);
-    
-    return std::make_tuple(originalImage, result.first, result.second);
-}
-
 } // namespace ImageProcessing
\ No newline at end of file
@@ -5,7 +5,6 @@
 #  if __has_include(<opencv2/core.hpp>)
 #    include <opencv2/core.hpp>
 #    include <opencv2/imgproc.hpp>
-#    include <opencv2/imgcodecs.hpp>
 #    if !defined(HAVE_OPENCV)
 #      define HAVE_OPENCV 1
 #    endif
@@ -57,12 +56,6 @@ std::pair<cv::Mat, cv::Mat> preprocessImage(const cv::Mat& image,
                                            const std::string& thresholdMethod = "otsu",
                                            const std::map<std::string, int>& thresholdParams = {});
 
-std::tuple<cv::Mat, cv::Mat, cv::Mat> loadAndPreprocess(const std::string& imagePath,
-                                                       bool applyGrayscale = true,
-                                                       bool applyThreshold = true,
-                                                       const std::string& thresholdMethod = "otsu",
-                                                       const std::map<std::string, int>& thresholdParams = {});
-
 } // namespace ImageProcessing
 
 #endif // IMAGE_PROCESSING_H
\ No newline at end of file
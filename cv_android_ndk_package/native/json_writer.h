@@ -0,0 +1,226 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace JsonOutput {
+
+// 输出格式
+enum class JsonStyle {
+    COMPACT,    // {"a":1,"b":[1,2]}
+    SPACED,     // {"a": 1, "b": [1, 2]}
+    PRETTY      // 换行并以两个空格缩进；inline容器按SPACED输出在同一行
+};
+
+// 流式JSON写入器：直接追加到可复用的缓冲区（clear()保留容量），数字用std::to_chars格式化，
+// 不产生临时字符串；逗号与缩进由写入器维护，嵌套深度不限
+class JsonWriter {
+public:
+    // 预留的嵌套层数，超过时作用域栈按需增长
+    static constexpr size_t RESERVED_DEPTH = 32;
+
+    explicit JsonWriter(JsonStyle style = JsonStyle::COMPACT, size_t reserveBytes = 1024)
+        : style_(style) {
+        buffer_.reserve(reserveBytes);
+        scopes_.reserve(RESERVED_DEPTH + 1);
+        clear();
+    }
+
+    // 清空内容，保留缓冲区与作用域栈容量
+    void clear() {
+        buffer_.clear();
+        afterKey_ = false;
+        scopes_.clear();
+        scopes_.push_back(Scope{true, style_ == JsonStyle::PRETTY});
+    }
+
+    void setStyle(JsonStyle style) { style_ = style; }
+
+    /**
+     * 开始对象
+     * @param inlineScope PRETTY格式下该对象及其内容输出在同一行
+     */
+    JsonWriter& beginObject(bool inlineScope = false) { return open('{', inlineScope); }
+    JsonWriter& endObject() { return close('}'); }
+
+    /**
+     * 开始数组
+     * @param inlineScope PRETTY格式下该数组及其内容输出在同一行
+     */
+    JsonWriter& beginArray(bool inlineScope = false) { return open('[', inlineScope); }
+    JsonWriter& endArray() { return close(']'); }
+
+    // 写入对象键，随后必须写入一个值
+    JsonWriter& key(std::string_view name) {
+        separate();
+        appendString(name);
+        buffer_ += ':';
+        if (style_ != JsonStyle::COMPACT) buffer_ += ' ';
+        afterKey_ = true;
+        return *this;
+    }
+
+    JsonWriter& value(std::string_view text) {
+        separate();
+        appendString(text);
+        return *this;
+    }
+
+    // 避免字符串字面量隐式转换为bool
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+
+    JsonWriter& value(bool flag) {
+        separate();
+        buffer_ += flag ? "true" : "false";
+        return *this;
+    }
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, int>::type = 0>
+    JsonWriter& value(T number) {
+        separate();
+        appendChars(number);
+        return *this;
+    }
+
+    // 浮点数按最短可往返表示输出；NaN与无穷输出为null
+    JsonWriter& value(double number) {
+        separate();
+        if (!std::isfinite(number)) {
+            buffer_ += "null";
+        } else {
+            appendChars(number);
+        }
+        return *this;
+    }
+
+    /**
+     * 浮点数按固定小数位输出
+     * @param number 数值
+     * @param precision 小数位数
+     */
+    JsonWriter& value(double number, int precision) {
+        separate();
+        if (!std::isfinite(number)) {
+            buffer_ += "null";
+        } else {
+            appendChars(number, std::chars_format::fixed, precision);
+        }
+        return *this;
+    }
+
+    JsonWriter& valueNull() {
+        separate();
+        buffer_ += "null";
+        return *this;
+    }
+
+    const std::string& str() const { return buffer_; }
+    const char* data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+
+private:
+    // 单层容器的状态
+    struct Scope {
+        bool first;     // 尚未写入元素
+        bool pretty;    // 元素换行缩进输出
+    };
+
+    // 当前容器深度（顶层为0）
+    size_t depth() const { return scopes_.size() - 1; }
+
+    JsonWriter& open(char bracket, bool inlineScope) {
+        separate();
+        buffer_ += bracket;
+        const bool pretty = scopes_.back().pretty && !inlineScope;
+        scopes_.push_back(Scope{true, pretty});
+        return *this;
+    }
+
+    JsonWriter& close(char bracket) {
+        if (depth() > 0) {
+            if (scopes_.back().pretty && !scopes_.back().first) newline(depth() - 1);
+            scopes_.pop_back();
+        }
+        buffer_ += bracket;
+        afterKey_ = false;
+        return *this;
+    }
+
+    // 在键或值之前写入分隔符与缩进
+    void separate() {
+        if (afterKey_) {
+            afterKey_ = false;
+            return;
+        }
+        if (depth() == 0) return;
+        Scope& scope = scopes_.back();
+        if (!scope.first) {
+            buffer_ += ',';
+            if (!scope.pretty && style_ != JsonStyle::COMPACT) buffer_ += ' ';
+        }
+        scope.first = false;
+        if (scope.pretty) newline(depth());
+    }
+
+    void newline(size_t depth) {
+        buffer_ += '\n';
+        buffer_.append(depth * 2, ' ');
+    }
+
+    void appendString(std::string_view text) {
+        static const char HEX[] = "0123456789abcdef";
+        buffer_ += '"';
+        size_t run = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            const unsigned char ch = static_cast<unsigned char>(text[i]);
+            if (ch != '"' && ch != '\\' && ch >= 0x20) continue;
+            buffer_.append(text.data() + run, i - run);
+            run = i + 1;
+            switch (ch) {
+                case '"': buffer_ += "\\\""; break;
+                case '\\': buffer_ += "\\\\"; break;
+                case '\n': buffer_ += "\\n"; break;
+                case '\r': buffer_ += "\\r"; break;
+                case '\t': buffer_ += "\\t"; break;
+                default:
+                    buffer_ += "\\u00";
+                    buffer_ += HEX[ch >> 4];
+                    buffer_ += HEX[ch & 0xF];
+                    break;
+            }
+        }
+        buffer_.append(text.data() + run, text.size() - run);
+        buffer_ += '"';
+    }
+
+    // 在缓冲区尾部预留空间后原地格式化，空间不足时扩大预留重试
+    template <typename... Args>
+    void appendChars(Args... args) {
+        const size_t start = buffer_.size();
+        for (size_t room = 32; ; room *= 4) {
+            buffer_.resize(start + room);
+            char* begin = &buffer_[start];
+            const std::to_chars_result result = std::to_chars(begin, begin + room, args...);
+            if (result.ec == std::errc()) {
+                buffer_.resize(start + static_cast<size_t>(result.ptr - begin));
+                return;
+            }
+        }
+    }
+
+    std::string buffer_;
+    JsonStyle style_;
+    bool afterKey_;
+    std::vector<Scope> scopes_;
+};
+
+} // namespace JsonOutput
+
+#endif // JSON_WRITER_H
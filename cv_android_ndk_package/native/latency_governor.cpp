@@ -0,0 +1,58 @@
+#include "latency_governor.h"
+#include <algorithm>
+
+namespace DotCardDetect {
+
+LatencyGovernor::LatencyGovernor(const LatencyGovernorConfig& config)
+    : config_(config), levelIndex_(0), averageMs_(0.0f), calmFrames_(0) {
+    // 先限制配对与重试（几乎不影响识别率），再降分辨率并拉长关键帧间隔
+    levels_.push_back(QualityLevel(1.0f, 1, 0, -1));
+    levels_.push_back(QualityLevel(1.0f, 1, 48, 2));
+    levels_.push_back(QualityLevel(0.75f, 1, 32, 1));
+    levels_.push_back(QualityLevel(0.75f, 2, 24, 1));
+    levels_.push_back(QualityLevel(0.5f, 2, 16, 1));
+    levels_.push_back(QualityLevel(0.5f, 3, 12, 1));
+}
+
+void LatencyGovernor::report(const StageTimings& timings) {
+    last_ = timings;
+    averageMs_ = (averageMs_ <= 0.0f) ? timings.totalMs
+                                      : averageMs_ + config_.ewmaAlpha * (timings.totalMs - averageMs_);
+    if (config_.budgetMs <= 0.0f) return;
+
+    const int maxIndex = static_cast<int>(levels_.size()) - 1;
+    const bool spike = timings.totalMs > config_.spikeRatio * config_.budgetMs;
+    if ((spike || averageMs_ > config_.budgetMs) && levelIndex_ < maxIndex) {
+        // 降档后按新档位的预期重新累计平均值
+        ++levelIndex_;
+        averageMs_ = std::min(averageMs_, config_.budgetMs);
+        calmFrames_ = 0;
+        return;
+    }
+
+    if (averageMs_ < config_.recoverRatio * config_.budgetMs && levelIndex_ > 0) {
+        if (++calmFrames_ >= config_.recoverFrames) {
+            --levelIndex_;
+            calmFrames_ = 0;
+        }
+    } else {
+        calmFrames_ = 0;
+    }
+}
+
+void LatencyGovernor::setBudget(float budgetMs) {
+    config_.budgetMs = budgetMs;
+    if (budgetMs <= 0.0f) {
+        levelIndex_ = 0;
+        calmFrames_ = 0;
+    }
+}
+
+void LatencyGovernor::reset() {
+    levelIndex_ = 0;
+    averageMs_ = 0.0f;
+    calmFrames_ = 0;
+    last_ = StageTimings();
+}
+
+} // namespace DotCardDetect
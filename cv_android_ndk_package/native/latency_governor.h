@@ -0,0 +1,86 @@
+#ifndef LATENCY_GOVERNOR_H
+#define LATENCY_GOVERNOR_H
+
+#include <vector>
+
+namespace DotCardDetect {
+
+// 单帧各阶段耗时（毫秒）
+struct StageTimings {
+    float convertMs;    // 颜色转换（NV21→BGR）
+    float scaleMs;      // 缩放到工作分辨率
+    float colorMs;      // 单帧颜色统计上下文
+    float detectMs;     // mark检测与配对
+    float decodeMs;     // 解码
+    float totalMs;      // 整帧
+
+    StageTimings() : convertMs(0.0f), scaleMs(0.0f), colorMs(0.0f), detectMs(0.0f), decodeMs(0.0f), totalMs(0.0f) {}
+};
+
+// 质量档位：数值越大越省时
+struct QualityLevel {
+    float scale;            // 工作分辨率相对原图的比例
+    int keyframeInterval;   // 每隔多少帧做一次检测，其间复用上一帧结果
+    int maxMarks;           // 参与配对的候选mark上限（配对代价随mark数四次方增长），0表示不限制
+    int maxCornerAttempts;  // 图块解码失败后逐角点重试的次数上限，-1表示不限制
+
+    QualityLevel(float s = 1.0f, int k = 1, int m = 0, int a = -1)
+        : scale(s), keyframeInterval(k), maxMarks(m), maxCornerAttempts(a) {}
+};
+
+// 延迟预算调节器配置
+struct LatencyGovernorConfig {
+    float budgetMs;         // 单帧处理预算，<=0 时不调节（始终使用最高档）
+    float ewmaAlpha;        // 帧耗时指数滑动平均系数
+    float spikeRatio;       // 单帧耗时超过预算该倍数时立即降档
+    float recoverRatio;     // 平均耗时低于预算该比例时才考虑升档
+    int recoverFrames;      // 连续满足升档条件的帧数
+
+    LatencyGovernorConfig()
+        : budgetMs(0.0f), ewmaAlpha(0.2f), spikeRatio(1.5f), recoverRatio(0.6f), recoverFrames(30) {}
+};
+
+// 延迟预算调节器：根据实际处理耗时在质量档位间升降，
+// 超出预算时降低工作分辨率、拉长关键帧间隔、限制候选mark数与解码重试，耗时充裕时逐级恢复
+class LatencyGovernor {
+public:
+    explicit LatencyGovernor(const LatencyGovernorConfig& config = LatencyGovernorConfig());
+
+    /**
+     * 报告一帧实际处理（未复用结果）的耗时，并据此调整档位
+     * @param timings 各阶段耗时
+     */
+    void report(const StageTimings& timings);
+
+    // 当前档位参数
+    const QualityLevel& level() const { return levels_[levelIndex_]; }
+    // 当前档位编号，0为最高质量
+    int levelIndex() const { return levelIndex_; }
+    int levelCount() const { return static_cast<int>(levels_.size()); }
+
+    // 帧耗时滑动平均与最近一帧各阶段耗时
+    float averageMs() const { return averageMs_; }
+    const StageTimings& lastTimings() const { return last_; }
+
+    /**
+     * 设置单帧预算
+     * @param budgetMs 预算毫秒数，<=0 关闭调节并恢复最高档
+     */
+    void setBudget(float budgetMs);
+    float budget() const { return config_.budgetMs; }
+
+    // 恢复最高档并清空统计
+    void reset();
+
+private:
+    LatencyGovernorConfig config_;
+    std::vector<QualityLevel> levels_;
+    int levelIndex_;
+    float averageMs_;
+    int calmFrames_;
+    StageTimings last_;
+};
+
+} // namespace DotCardDetect
+
+#endif // LATENCY_GOVERNOR_H
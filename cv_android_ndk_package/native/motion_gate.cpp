@@ -0,0 +1,84 @@
+#include "motion_gate.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace DotCardDetect {
+
+MotionGate::MotionGate(const MotionGateConfig& config) : config_(config) {
+    config_.downscale = std::max(1, config_.downscale);
+    config_.tileSize = std::max(1, config_.tileSize);
+}
+
+cv::Mat MotionGate::downsample(const cv::Mat& image) const {
+    if (image.empty()) return cv::Mat();
+    cv::Size size(std::max(1, image.cols / config_.downscale), std::max(1, image.rows / config_.downscale));
+    cv::Mat small;
+    cv::resize(image, small, size, 0, 0, cv::INTER_AREA);
+    if (small.channels() == 3) {
+        cv::cvtColor(small, small, cv::COLOR_BGR2GRAY);
+    }
+    return small;
+}
+
+MotionState MotionGate::evaluate(const cv::Mat& small, cv::Size fullSize) const {
+    MotionState state;
+    if (small.empty()) return state;
+
+    const int tile = config_.tileSize;
+    const int tilesX = (small.cols + tile - 1) / tile;
+    const int tilesY = (small.rows + tile - 1) / tile;
+    state.totalTiles = tilesX * tilesY;
+
+    if (reference_.empty() || reference_.size() != small.size()) {
+        // 无参考帧：视为整帧变化
+        state.changedTiles = state.totalTiles;
+        state.dirtyRect = cv::Rect(0, 0, fullSize.width, fullSize.height);
+        return state;
+    }
+    state.reference = true;
+
+    // 逐行累加每个分块的绝对差
+    std::vector<int> sad(static_cast<size_t>(state.totalTiles), 0);
+    for (int y = 0; y < small.rows; ++y) {
+        const uchar* cur = small.ptr<uchar>(y);
+        const uchar* ref = reference_.ptr<uchar>(y);
+        int* rowSad = sad.data() + static_cast<size_t>(y / tile) * tilesX;
+        for (int x = 0; x < small.cols; ++x) {
+            rowSad[x / tile] += std::abs(static_cast<int>(cur[x]) - static_cast<int>(ref[x]));
+        }
+    }
+
+    int minTx = tilesX, minTy = tilesY, maxTx = -1, maxTy = -1;
+    for (int ty = 0; ty < tilesY; ++ty) {
+        const int th = std::min(tile, small.rows - ty * tile);
+        for (int tx = 0; tx < tilesX; ++tx) {
+            const int tw = std::min(tile, small.cols - tx * tile);
+            if (sad[static_cast<size_t>(ty) * tilesX + tx] <= config_.sadThreshold * tw * th) continue;
+            ++state.changedTiles;
+            minTx = std::min(minTx, tx);
+            minTy = std::min(minTy, ty);
+            maxTx = std::max(maxTx, tx);
+            maxTy = std::max(maxTy, ty);
+        }
+    }
+
+    if (state.changedTiles > 0) {
+        // 换算回原图坐标；最后一列/行分块延伸到原图边缘（降采样时被舍去的像素）
+        const int cell = tile * config_.downscale;
+        const int x1 = (maxTx == tilesX - 1) ? fullSize.width : (maxTx + 1) * cell;
+        const int y1 = (maxTy == tilesY - 1) ? fullSize.height : (maxTy + 1) * cell;
+        cv::Rect dirty(minTx * cell, minTy * cell, x1 - minTx * cell, y1 - minTy * cell);
+        state.dirtyRect = dirty & cv::Rect(0, 0, fullSize.width, fullSize.height);
+    }
+    return state;
+}
+
+void MotionGate::commit(const cv::Mat& small) {
+    small.copyTo(reference_);
+}
+
+void MotionGate::reset() {
+    reference_.release();
+}
+
+} // namespace DotCardDetect
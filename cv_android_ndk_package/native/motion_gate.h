@@ -0,0 +1,69 @@
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include "dot_card_detect.h"
+#include <vector>
+
+namespace DotCardDetect {
+
+// 运动门控配置
+struct MotionGateConfig {
+    int downscale;          // 亮度平面的降采样倍数
+    int tileSize;           // 降采样图像上的分块边长
+    int sadThreshold;       // 分块内平均绝对差超过该值时视为变化
+    float fullFrameRatio;   // 变化区域超过整帧该比例时直接整帧处理
+
+    MotionGateConfig() : downscale(4), tileSize(8), sadThreshold(6), fullFrameRatio(0.5f) {}
+};
+
+// 单帧的变化检测结果
+struct MotionState {
+    bool reference;             // 是否已有参考帧（首帧为false）
+    int changedTiles;           // 变化的分块数
+    int totalTiles;             // 分块总数
+    cv::Rect dirtyRect;         // 变化分块的外接矩形（原图坐标），无变化时为空
+
+    MotionState() : reference(false), changedTiles(0), totalTiles(0) {}
+    bool unchanged() const { return reference && changedTiles == 0; }
+};
+
+// 运动门控：在降采样的亮度平面上逐块计算与上一处理帧的SAD，
+// 桌面静止时可整帧跳过处理，局部变化时只需处理变化区域
+class MotionGate {
+public:
+    explicit MotionGate(const MotionGateConfig& config = MotionGateConfig());
+
+    /**
+     * 将图像降采样为门控使用的亮度小图
+     * @param image 原分辨率亮度平面（CV_8UC1，例如NV21的Y平面）或BGR图像（先缩小再转灰度）
+     * @return 降采样后的亮度图
+     */
+    cv::Mat downsample(const cv::Mat& image) const;
+
+    /**
+     * 与参考帧逐块比较（不更新参考帧）
+     * @param small downsample()的结果
+     * @param fullSize 原图尺寸，用于换算dirtyRect
+     * @return 变化检测结果
+     */
+    MotionState evaluate(const cv::Mat& small, cv::Size fullSize) const;
+
+    /**
+     * 将当前帧设为参考帧（仅在该帧被实际处理后调用）
+     * @param small downsample()的结果
+     */
+    void commit(const cv::Mat& small);
+
+    // 丢弃参考帧，下一帧将整帧处理
+    void reset();
+
+    const MotionGateConfig& config() const { return config_; }
+
+private:
+    MotionGateConfig config_;
+    cv::Mat reference_;
+};
+
+} // namespace DotCardDetect
+
+#endif // MOTION_GATE_H
@@ -0,0 +1,340 @@
+#include "region_template_cache.h"
+#include <cmath>
+#include <algorithm>
+#include <climits>
+
+namespace DotCardDetect {
+
+namespace {
+
+constexpr int KEY_SIZE_BITS = 12;
+constexpr int KEY_ANGLE_BITS = 10;
+constexpr int KEY_MAX_SIZE = (1 << KEY_SIZE_BITS) - 1;
+constexpr int KEY_ANGLE_OFFSET = 1 << (KEY_ANGLE_BITS - 1);
+
+int angleBucket(double angle) {
+    return static_cast<int>(std::lround(angle / RegionTemplateCache::ANGLE_BUCKET_DEGREES));
+}
+
+uint64_t mixKey(uint64_t key) {
+    // splitmix64 的终结步骤，打散到各组
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+// hazard指针域（进程内所有缓存共用）：每个线程认领一条记录，指向其正在使用的缓存模板
+constexpr size_t MAX_HAZARD_RECORDS = 64;
+// 待回收模板数达到该值时扫描一次hazard记录；大于记录数，每次扫描至少释放一半
+constexpr size_t RECLAIM_THRESHOLD = 2 * MAX_HAZARD_RECORDS;
+
+struct HazardRecord {
+    std::atomic<const RegionTemplate*> pointer;
+    std::atomic<bool> claimed;
+};
+
+struct RetiredNode {
+    const RegionTemplate* tmpl;
+    RetiredNode* next;
+};
+
+// 以下全局量均为零初始化、无析构，线程局部对象在进程退出时析构仍可安全访问
+HazardRecord g_hazards[MAX_HAZARD_RECORDS];
+std::atomic<RetiredNode*> g_retired{nullptr};
+std::atomic<size_t> g_retiredCount{0};
+
+// 当前线程的hazard记录：首次使用时认领，线程退出时归还
+struct ThreadHazard {
+    HazardRecord* record = nullptr;
+    bool inUse = false;     // 已有未释放的句柄占用该记录
+
+    ~ThreadHazard() {
+        if (record) {
+            record->pointer.store(nullptr, std::memory_order_release);
+            record->claimed.store(false, std::memory_order_release);
+        }
+    }
+};
+
+ThreadHazard& threadHazard() {
+    thread_local ThreadHazard hazard;
+    return hazard;
+}
+
+// 认领空闲记录；全部被占用时返回空指针
+HazardRecord* claimHazard(ThreadHazard& local) {
+    for (size_t i = 0; i < MAX_HAZARD_RECORDS && !local.record; ++i) {
+        bool expected = false;
+        if (!g_hazards[i].claimed.load(std::memory_order_relaxed) &&
+            g_hazards[i].claimed.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            local.record = &g_hazards[i];
+        }
+    }
+    return local.record;
+}
+
+// 读取slot并以hazard保护：发布hazard后重读slot，未变化才说明读到的模板尚未被替换回收
+const RegionTemplate* protect(const std::atomic<const RegionTemplate*>& slot, HazardRecord& hazard) {
+    const RegionTemplate* entry = slot.load(std::memory_order_acquire);
+    for (;;) {
+        hazard.pointer.store(entry, std::memory_order_seq_cst);
+        const RegionTemplate* current = slot.load(std::memory_order_seq_cst);
+        if (current == entry) return entry;
+        entry = current;
+    }
+}
+
+void pushRetired(RetiredNode* first, RetiredNode* last) {
+    RetiredNode* head = g_retired.load(std::memory_order_relaxed);
+    do {
+        last->next = head;
+    } while (!g_retired.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// 释放没有hazard指向的待回收模板，仍被保护的放回待回收栈
+void reclaimRetired() {
+    RetiredNode* list = g_retired.exchange(nullptr, std::memory_order_acquire);
+    if (!list) return;
+
+    std::array<const RegionTemplate*, MAX_HAZARD_RECORDS> guarded;
+    size_t guardedCount = 0;
+    for (auto& record : g_hazards) {
+        const RegionTemplate* pointer = record.pointer.load(std::memory_order_seq_cst);
+        if (pointer) guarded[guardedCount++] = pointer;
+    }
+    std::sort(guarded.begin(), guarded.begin() + guardedCount);
+
+    RetiredNode* keepFirst = nullptr;
+    RetiredNode* keepLast = nullptr;
+    while (list) {
+        RetiredNode* node = list;
+        list = list->next;
+        if (std::binary_search(guarded.begin(), guarded.begin() + guardedCount, node->tmpl)) {
+            node->next = keepFirst;
+            keepFirst = node;
+            if (!keepLast) keepLast = node;
+        } else {
+            delete node->tmpl;
+            delete node;
+            g_retiredCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (keepFirst) pushRetired(keepFirst, keepLast);
+}
+
+// 已从slot摘下的模板挂入待回收栈，累计到阈值时扫描回收
+void retire(const RegionTemplate* tmpl) {
+    if (!tmpl) return;
+    RetiredNode* node = new RetiredNode{tmpl, nullptr};
+    pushRetired(node, node);
+    if (g_retiredCount.fetch_add(1, std::memory_order_relaxed) + 1 >= RECLAIM_THRESHOLD) {
+        reclaimRetired();
+    }
+}
+
+} // namespace
+
+RegionTemplateHandle::RegionTemplateHandle(RegionTemplateHandle&& other) noexcept
+    : tmpl_(other.tmpl_), hazard_(other.hazard_), owned_(std::move(other.owned_)) {
+    other.tmpl_ = nullptr;
+    other.hazard_ = nullptr;
+}
+
+RegionTemplateHandle& RegionTemplateHandle::operator=(RegionTemplateHandle&& other) noexcept {
+    if (this != &other) {
+        reset();
+        tmpl_ = other.tmpl_;
+        hazard_ = other.hazard_;
+        owned_ = std::move(other.owned_);
+        other.tmpl_ = nullptr;
+        other.hazard_ = nullptr;
+    }
+    return *this;
+}
+
+void RegionTemplateHandle::reset() {
+    if (hazard_) {
+        ThreadHazard* local = static_cast<ThreadHazard*>(hazard_);
+        local->record->pointer.store(nullptr, std::memory_order_release);
+        local->inUse = false;
+        hazard_ = nullptr;
+    }
+    owned_.reset();
+    tmpl_ = nullptr;
+}
+
+RegionDirection regionDirectionFromName(const std::string& direction) {
+    if (direction == "up") return REGION_UP;
+    if (direction == "down") return REGION_DOWN;
+    if (direction == "left") return REGION_LEFT;
+    return REGION_RIGHT;
+}
+
+std::vector<cv::Point2f> extendedRegionTriangle(const cv::Rect& rect, RegionDirection direction) {
+    float left = static_cast<float>(rect.x);
+    float top = static_cast<float>(rect.y);
+    float right = static_cast<float>(rect.x + rect.width - 1);
+    float bottom = static_cast<float>(rect.y + rect.height - 1);
+    float midX = static_cast<float>(rect.x + rect.width / 2);
+    float midY = static_cast<float>(rect.y + rect.height / 2);
+
+    switch (direction) {
+        case REGION_UP:
+            return {cv::Point2f(left, bottom), cv::Point2f(right, bottom), cv::Point2f(midX, top)};
+        case REGION_DOWN:
+            return {cv::Point2f(left, top), cv::Point2f(right, top), cv::Point2f(midX, bottom)};
+        case REGION_LEFT:
+            return {cv::Point2f(right, top), cv::Point2f(right, bottom), cv::Point2f(left, midY)};
+        case REGION_RIGHT:
+        default:
+            return {cv::Point2f(left, top), cv::Point2f(left, bottom), cv::Point2f(right, midY)};
+    }
+}
+
+RegionTemplateCache::RegionTemplateCache() : clock_(0), hits_(0), misses_(0) {}
+
+RegionTemplateCache::~RegionTemplateCache() {
+    clear();
+    reclaimRetired();
+}
+
+bool RegionTemplateCache::makeKey(int width, int height, RegionDirection direction, double angle, uint64_t& key) {
+    if (width <= 0 || height <= 0 || width > KEY_MAX_SIZE || height > KEY_MAX_SIZE) {
+        return false;
+    }
+
+    int bucket = angleBucket(angle) + KEY_ANGLE_OFFSET;
+    if (bucket < 0 || bucket >= (1 << KEY_ANGLE_BITS)) {
+        return false;
+    }
+
+    key = static_cast<uint64_t>(width)
+        | (static_cast<uint64_t>(height) << KEY_SIZE_BITS)
+        | (static_cast<uint64_t>(direction) << (2 * KEY_SIZE_BITS))
+        | (static_cast<uint64_t>(bucket) << (2 * KEY_SIZE_BITS + 2));
+    return true;
+}
+
+std::unique_ptr<RegionTemplate> RegionTemplateCache::buildTemplate(uint64_t key, int width, int height,
+                                                                   RegionDirection direction, double angle) {
+    auto tmpl = std::make_unique<RegionTemplate>();
+    tmpl->key = key;
+
+    // 未被图像边界裁剪时的扩展区域（相对mark外接矩形左上角）
+    int extendW = width * 2;
+    int extendH = height * 2;
+    cv::Rect rect;
+    switch (direction) {
+        case REGION_UP:    rect = cv::Rect(0, -extendH, width, extendH); break;
+        case REGION_DOWN:  rect = cv::Rect(0, height, width, extendH); break;
+        case REGION_LEFT:  rect = cv::Rect(-extendW, 0, extendW, height); break;
+        case REGION_RIGHT:
+        default:           rect = cv::Rect(width, 0, extendW, height); break;
+    }
+
+    std::vector<cv::Point2f> triangle = extendedRegionTriangle(rect, direction);
+
+    // 按角度桶中心旋转，旋转中心为mark外接矩形中心
+    double bucketAngle = angleBucket(angle) * ANGLE_BUCKET_DEGREES;
+    if (bucketAngle != 0.0) {
+        cv::Mat rotationMatrix = cv::getRotationMatrix2D(cv::Point2f(width / 2.0f, height / 2.0f), -bucketAngle, 1.0);
+        std::vector<cv::Point2f> rotatedTriangle;
+        cv::transform(triangle, rotatedTriangle, rotationMatrix);
+        triangle.swap(rotatedTriangle);
+    }
+
+    const int unbounded = 1 << 20;
+    rasterizeConvexPolygon(triangle, cv::Rect(-unbounded, -unbounded, 2 * unbounded, 2 * unbounded), tmpl->spans);
+
+    if (!tmpl->spans.empty()) {
+        int minX = INT_MAX, maxX = INT_MIN;
+        for (const auto& span : tmpl->spans) {
+            minX = std::min(minX, span.x0);
+            maxX = std::max(maxX, span.x1);
+        }
+        int minY = tmpl->spans.front().y;
+        int maxY = tmpl->spans.back().y;
+        tmpl->bounds = cv::Rect(minX, minY, maxX - minX, maxY - minY + 1);
+    }
+    tmpl->area = spanArea(tmpl->spans);
+
+    return tmpl;
+}
+
+RegionTemplateHandle RegionTemplateCache::acquire(int width, int height,
+                                                  RegionDirection direction, double angle) {
+    RegionTemplateHandle handle;
+    uint64_t key;
+    if (!makeKey(width, height, direction, angle, key)) {
+        return handle;
+    }
+
+    const size_t set = static_cast<size_t>(mixKey(key) % NUM_SETS);
+    Slot* ways = &slots_[set * NUM_WAYS];
+    const uint64_t now = clock_.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    // 本线程已有未释放的句柄或hazard记录用尽时无法保护共享模板，按未命中处理
+    ThreadHazard& local = threadHazard();
+    HazardRecord* hazard = local.inUse ? nullptr : claimHazard(local);
+    if (hazard) {
+        for (size_t i = 0; i < NUM_WAYS; ++i) {
+            const RegionTemplate* entry = protect(ways[i].entry, *hazard);
+            if (entry && entry->key == key) {
+                ways[i].lastUse.store(now, std::memory_order_relaxed);
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                local.inUse = true;
+                handle.tmpl_ = entry;
+                handle.hazard_ = &local;
+                return handle;
+            }
+        }
+        hazard->pointer.store(nullptr, std::memory_order_release);
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_ptr<RegionTemplate> created = buildTemplate(key, width, height, direction, angle);
+    if (!hazard) {
+        handle.tmpl_ = created.get();
+        handle.owned_ = std::move(created);
+        return handle;
+    }
+
+    // 替换组内最久未使用的slot；并发插入同一键时最多造成一次重复，不影响正确性
+    size_t victim = 0;
+    uint64_t oldest = UINT64_MAX;
+    for (size_t i = 0; i < NUM_WAYS; ++i) {
+        uint64_t lastUse = ways[i].lastUse.load(std::memory_order_relaxed);
+        if (lastUse < oldest) {
+            oldest = lastUse;
+            victim = i;
+        }
+    }
+
+    // 发布前先以hazard保护，其他线程随即替换并回收它也不影响本句柄
+    const RegionTemplate* published = created.release();
+    hazard->pointer.store(published, std::memory_order_seq_cst);
+    retire(ways[victim].entry.exchange(published, std::memory_order_seq_cst));
+    ways[victim].lastUse.store(now, std::memory_order_relaxed);
+
+    local.inUse = true;
+    handle.tmpl_ = published;
+    handle.hazard_ = &local;
+    return handle;
+}
+
+void RegionTemplateCache::clear() {
+    for (auto& slot : slots_) {
+        retire(slot.entry.exchange(nullptr, std::memory_order_seq_cst));
+        slot.lastUse.store(0, std::memory_order_relaxed);
+    }
+}
+
+RegionTemplateCache& defaultRegionTemplateCache() {
+    static RegionTemplateCache cache;
+    return cache;
+}
+
+} // namespace DotCardDetect
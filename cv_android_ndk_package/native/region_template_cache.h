@@ -0,0 +1,149 @@
+#ifndef REGION_TEMPLATE_CACHE_H
+#define REGION_TEMPLATE_CACHE_H
+
+#include "color_frame.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace DotCardDetect {
+
+// 扩展区域方向
+enum RegionDirection {
+    REGION_UP = 0,
+    REGION_DOWN = 1,
+    REGION_LEFT = 2,
+    REGION_RIGHT = 3
+};
+
+/**
+ * 方向名称（"up"/"down"/"left"/"right"）转换为方向枚举
+ * @param direction 方向名称
+ * @return 方向枚举，未知名称返回REGION_RIGHT
+ */
+RegionDirection regionDirectionFromName(const std::string& direction);
+
+/**
+ * 扩展区域内的三角形采样区域（与rect同一坐标系），尖端指向远离mark的方向
+ * @param rect 扩展区域矩形
+ * @param direction 方向
+ * @return 三角形顶点
+ */
+std::vector<cv::Point2f> extendedRegionTriangle(const cv::Rect& rect, RegionDirection direction);
+
+// 预先栅格化的区域模板，坐标相对于mark外接矩形左上角
+struct RegionTemplate {
+    uint64_t key;                  // 量化后的(宽, 高, 方向, 角度桶)
+    std::vector<RowSpan> spans;    // 行区间（相对坐标）
+    cv::Rect bounds;               // 所有行区间的外接矩形（相对坐标）
+    int area;                      // 覆盖的像素数
+
+    RegionTemplate() : key(0), area(0) {}
+};
+
+/**
+ * 缓存模板的句柄：持有期间模板不会被回收
+ * 缓存命中时由当前线程的hazard指针保护模板，句柄析构时解除；
+ * 当前线程已有未释放的句柄或hazard槽用尽时，句柄自行持有一份新建的模板。
+ * 句柄只能在创建它的线程上使用和析构。
+ */
+class RegionTemplateHandle {
+public:
+    RegionTemplateHandle() : tmpl_(nullptr), hazard_(nullptr) {}
+    RegionTemplateHandle(RegionTemplateHandle&& other) noexcept;
+    RegionTemplateHandle& operator=(RegionTemplateHandle&& other) noexcept;
+    ~RegionTemplateHandle() { reset(); }
+
+    RegionTemplateHandle(const RegionTemplateHandle&) = delete;
+    RegionTemplateHandle& operator=(const RegionTemplateHandle&) = delete;
+
+    const RegionTemplate* get() const { return tmpl_; }
+    const RegionTemplate* operator->() const { return tmpl_; }
+    explicit operator bool() const { return tmpl_ != nullptr; }
+
+    // 释放模板（解除hazard保护或销毁自行持有的模板）
+    void reset();
+
+private:
+    friend class RegionTemplateCache;
+
+    const RegionTemplate* tmpl_;
+    void* hazard_;                              // 保护tmpl_的线程hazard记录，自行持有时为空
+    std::unique_ptr<const RegionTemplate> owned_;
+};
+
+// 区域模板缓存
+// 同一桌面上mark的尺寸与角度集中在很小的范围内，将三角/旋转区域的栅格化结果
+// 按量化后的(宽, 高, 方向, 角度桶)缓存为行区间，区域采样退化为对标签平面的行区间遍历。
+// 组相联结构，容量固定，组内按最近使用时间近似LRU淘汰。
+// 查找与发布均无锁：slot保存模板的原子裸指针，读者以每线程一个hazard指针保护正在使用的模板，
+// 被替换或清除的模板挂入无锁的待回收栈，确认没有hazard指向后才释放（进程内所有缓存共用）。
+class RegionTemplateCache {
+public:
+    static constexpr size_t NUM_SETS = 64;
+    static constexpr size_t NUM_WAYS = 4;
+    static constexpr double ANGLE_BUCKET_DEGREES = 1.0;
+
+    RegionTemplateCache();
+    ~RegionTemplateCache();
+
+    RegionTemplateCache(const RegionTemplateCache&) = delete;
+    RegionTemplateCache& operator=(const RegionTemplateCache&) = delete;
+
+    /**
+     * 生成缓存键
+     * @param width mark外接矩形宽度
+     * @param height mark外接矩形高度
+     * @param direction 方向
+     * @param angle 旋转角度（度），未旋转时为0
+     * @param key 输出的缓存键
+     * @return 尺寸超出可编码范围时返回false（调用方应直接计算）
+     */
+    static bool makeKey(int width, int height, RegionDirection direction, double angle, uint64_t& key);
+
+    /**
+     * 查找或生成模板
+     * @param width mark外接矩形宽度
+     * @param height mark外接矩形高度
+     * @param direction 方向
+     * @param angle 旋转角度（度）
+     * @return 模板句柄，无法缓存时为空
+     */
+    RegionTemplateHandle acquire(int width, int height, RegionDirection direction, double angle);
+
+    // 清空缓存（可与acquire并发；已发出的句柄仍然有效）
+    void clear();
+
+    // 命中/未命中计数（统计用）
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<const RegionTemplate*> entry;
+        std::atomic<uint64_t> lastUse;
+
+        Slot() : entry(nullptr), lastUse(0) {}
+    };
+
+    static std::unique_ptr<RegionTemplate> buildTemplate(uint64_t key, int width, int height,
+                                                         RegionDirection direction, double angle);
+
+    std::array<Slot, NUM_SETS * NUM_WAYS> slots_;
+    std::atomic<uint64_t> clock_;
+    std::atomic<uint64_t> hits_;
+    std::atomic<uint64_t> misses_;
+};
+
+/**
+ * 进程内共享的区域模板缓存
+ * @return 缓存实例
+ */
+RegionTemplateCache& defaultRegionTemplateCache();
+
+} // namespace DotCardDetect
+
+#endif // REGION_TEMPLATE_CACHE_H
@@ -0,0 +1,90 @@
+#ifndef STRIPE_SCHEDULER_H
+#define STRIPE_SCHEDULER_H
+
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace StripeProcessing {
+
+// 单个条带处理时所有中间平面合计的目标大小，按低端ARM SoC的L2容量取值
+constexpr size_t DEFAULT_STRIPE_BYTES = 256 * 1024;
+
+// 条带行数下限，避免行数过少时调度开销占比过大
+constexpr int MIN_STRIPE_ROWS = 8;
+
+// 水平条带：输出行为[y0, y1)，邻域运算需要读取[readY0, readY1)
+struct Stripe {
+    int index;
+    int y0;
+    int y1;
+    int readY0;
+    int readY1;
+
+    int rows() const { return y1 - y0; }
+    int readRows() const { return readY1 - readY0; }
+    // 输出行在读取范围内的起始偏移
+    int offset() const { return y0 - readY0; }
+};
+
+/**
+ * 按缓存容量估算条带行数
+ * @param cols 图像宽度
+ * @param bytesPerPixel 条带内所有中间平面每像素合计字节数
+ * @param halo 条带上下各需要的额外行数
+ * @param stripeBytes 条带目标大小
+ * @return 条带输出行数
+ */
+inline int stripeRowsFor(int cols, int bytesPerPixel, int halo = 0,
+                         size_t stripeBytes = DEFAULT_STRIPE_BYTES) {
+    size_t rowBytes = static_cast<size_t>(std::max(1, cols)) * static_cast<size_t>(std::max(1, bytesPerPixel));
+    int rows = static_cast<int>(stripeBytes / rowBytes) - 2 * halo;
+    return std::max(MIN_STRIPE_ROWS, rows);
+}
+
+/**
+ * 将图像行划分为条带
+ * @param imageRows 图像高度
+ * @param stripeRows 每个条带的输出行数
+ * @param halo 条带上下各需要的额外行数（在图像边界处截断）
+ * @return 条带列表
+ */
+inline std::vector<Stripe> makeStripes(int imageRows, int stripeRows, int halo = 0) {
+    std::vector<Stripe> stripes;
+    stripeRows = std::max(1, stripeRows);
+    for (int y = 0; y < imageRows; y += stripeRows) {
+        Stripe stripe;
+        stripe.index = static_cast<int>(stripes.size());
+        stripe.y0 = y;
+        stripe.y1 = std::min(imageRows, y + stripeRows);
+        stripe.readY0 = std::max(0, stripe.y0 - halo);
+        stripe.readY1 = std::min(imageRows, stripe.y1 + halo);
+        stripes.push_back(stripe);
+    }
+    return stripes;
+}
+
+/**
+ * 在线程池上逐条带执行处理
+ * 每个工作线程先调用makeScratch()得到自己的中间缓冲区，再依次处理分到的条带，
+ * 中间平面只在条带内存活，不会整帧往返内存
+ * @param stripes 条带列表
+ * @param makeScratch 创建线程私有缓冲区的函数
+ * @param process 处理函数 process(const Stripe&, Scratch&)
+ */
+template <typename MakeScratch, typename Process>
+void forEachStripe(const std::vector<Stripe>& stripes, MakeScratch&& makeScratch, Process&& process) {
+    if (stripes.empty()) return;
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(stripes.size())), [&](const cv::Range& range) {
+        auto scratch = makeScratch();
+        for (int i = range.start; i < range.end; ++i) {
+            process(stripes[i], scratch);
+        }
+    });
+}
+
+} // namespace StripeProcessing
+
+#endif // STRIPE_SCHEDULER_H
@@ -0,0 +1,191 @@
+#include "bit_mask.h"
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+/**
+ * 测试程序：验证BitMask与8位掩码结果一致（跨64位字边界的区间、计数与按位运算）
+ *
+ * 编译命令:
+ * g++ -std=c++17 test_bit_mask.cpp bit_mask.cpp `pkg-config --cflags --libs opencv4` -o test_bit_mask
+ */
+
+using namespace DotCardDetect;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+// 随机8位掩码，宽度不是64的倍数以覆盖行尾的不完整字
+cv::Mat randomMask(int rows, int cols, unsigned seed) {
+    std::mt19937 rng(seed);
+    cv::Mat mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+    for (int y = 0; y < rows; ++y) {
+        uchar* row = mask.ptr<uchar>(y);
+        int x = 0;
+        while (x < cols) {
+            int run = 1 + static_cast<int>(rng() % 90);
+            bool on = rng() % 2 == 0;
+            for (int i = x; i < std::min(cols, x + run); ++i) row[i] = on ? 255 : 0;
+            x += run;
+        }
+    }
+    return mask;
+}
+
+int countNonZero8(const cv::Mat& mask, int x0, int y0, int x1, int y1) {
+    int total = 0;
+    for (int y = std::max(0, y0); y < std::min(mask.rows, y1); ++y) {
+        const uchar* row = mask.ptr<uchar>(y);
+        for (int x = std::max(0, x0); x < std::min(mask.cols, x1); ++x) total += row[x] != 0;
+    }
+    return total;
+}
+
+bool sameMask(const cv::Mat& a, const cv::Mat& b) {
+    if (a.rows != b.rows || a.cols != b.cols) return false;
+    for (int y = 0; y < a.rows; ++y) {
+        for (int x = 0; x < a.cols; ++x) {
+            if ((a.ptr<uchar>(y)[x] != 0) != (b.ptr<uchar>(y)[x] != 0)) return false;
+        }
+    }
+    return true;
+}
+
+// 测试打包与展开
+void testPackRoundTrip() {
+    std::cout << "\n=== 测试打包与展开 ===" << std::endl;
+
+    cv::Mat mask = randomMask(37, 203, 1);
+    BitMask bits = BitMask::fromMat(mask);
+    TEST_ASSERT(bits.rows() == 37 && bits.cols() == 203 && bits.wordsPerRow() == 4, "尺寸与每行字数");
+    TEST_ASSERT(sameMask(bits.toMat(), mask), "fromMat/toMat往返一致");
+    TEST_ASSERT(bits.count() == countNonZero8(mask, 0, 0, mask.cols, mask.rows), "count与逐像素计数一致");
+
+    bool testOk = true;
+    for (int y = 0; y < mask.rows; ++y) {
+        for (int x = 0; x < mask.cols; ++x) {
+            testOk = testOk && bits.test(x, y) == (mask.ptr<uchar>(y)[x] != 0);
+        }
+    }
+    TEST_ASSERT(testOk, "test逐像素一致");
+
+    // 分块打包
+    BitMask striped;
+    striped.create(mask.rows, mask.cols);
+    striped.packRows(mask.rowRange(0, 20), 0);
+    striped.packRows(mask.rowRange(20, mask.rows), 20);
+    TEST_ASSERT(sameMask(striped.toMat(), mask), "packRows分块打包一致");
+
+    BitMask empty = BitMask::fromMat(cv::Mat());
+    TEST_ASSERT(empty.empty() && empty.count() == 0, "空掩码");
+}
+
+// 测试区间置位与计数
+void testSpans() {
+    std::cout << "\n=== 测试区间 ===" << std::endl;
+
+    BitMask bits(3, 130);
+    bits.setSpan(1, 60, 70);      // 跨越第一个字边界
+    bits.setSpan(1, 127, 200);    // 裁剪到列数
+    bits.setSpan(5, 0, 10);       // 越界行忽略
+    TEST_ASSERT(bits.count() == 13, "setSpan跨字并裁剪");
+    TEST_ASSERT(bits.countSpan(1, 0, 64) == 4 && bits.countSpan(1, 64, 130) == 9, "countSpan按字边界拆分");
+    TEST_ASSERT(bits.countRect(cv::Rect(62, -5, 100, 100)) == 11, "countRect裁剪到掩码范围");
+
+    std::vector<std::pair<int, int>> spans;
+    bits.forEachSpan([&spans](int y, int x0, int x1) {
+        if (y == 1) spans.push_back(std::make_pair(x0, x1));
+    });
+    TEST_ASSERT(spans.size() == 2 && spans[0] == std::make_pair(60, 70) && spans[1] == std::make_pair(127, 130),
+                "forEachSpan返回跨字区间与行尾区间");
+
+    // 整字全为1的区间
+    BitMask full(1, 192);
+    full.setSpan(0, 0, 192);
+    spans.clear();
+    full.forEachSpan([&spans](int, int x0, int x1) { spans.push_back(std::make_pair(x0, x1)); });
+    TEST_ASSERT(spans.size() == 1 && spans[0] == std::make_pair(0, 192) && full.count() == 192, "整行置位为单个区间");
+
+    // 随机掩码的区间重建
+    cv::Mat mask = randomMask(16, 150, 2);
+    BitMask random = BitMask::fromMat(mask);
+    cv::Mat rebuilt = cv::Mat::zeros(mask.rows, mask.cols, CV_8UC1);
+    random.forEachSpan([&rebuilt](int y, int x0, int x1) {
+        for (int x = x0; x < x1; ++x) rebuilt.ptr<uchar>(y)[x] = 255;
+    });
+    TEST_ASSERT(sameMask(rebuilt, mask), "forEachSpan覆盖全部置位像素");
+
+    bool rectOk = true;
+    for (int i = 0; i < 20; ++i) {
+        cv::Rect rect(i * 7 - 10, i % 5, 30 + i * 3, 8);
+        rectOk = rectOk && random.countRect(rect) ==
+                 countNonZero8(mask, rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+    }
+    TEST_ASSERT(rectOk, "countRect与逐像素计数一致");
+}
+
+// 测试按位运算
+void testBitwise() {
+    std::cout << "\n=== 测试按位运算 ===" << std::endl;
+
+    cv::Mat a8 = randomMask(9, 100, 3);
+    cv::Mat b8 = randomMask(9, 100, 4);
+    BitMask a = BitMask::fromMat(a8);
+    BitMask b = BitMask::fromMat(b8);
+
+    cv::Mat and8 = cv::Mat::zeros(a8.rows, a8.cols, CV_8UC1);
+    cv::Mat or8 = cv::Mat::zeros(a8.rows, a8.cols, CV_8UC1);
+    for (int y = 0; y < a8.rows; ++y) {
+        for (int x = 0; x < a8.cols; ++x) {
+            bool pa = a8.ptr<uchar>(y)[x] != 0;
+            bool pb = b8.ptr<uchar>(y)[x] != 0;
+            and8.ptr<uchar>(y)[x] = (pa && pb) ? 255 : 0;
+            or8.ptr<uchar>(y)[x] = (pa || pb) ? 255 : 0;
+        }
+    }
+
+    BitMask dst;
+    BitMask::bitwiseAnd(a, b, dst);
+    TEST_ASSERT(sameMask(dst.toMat(), and8), "bitwiseAnd");
+    BitMask::bitwiseOr(a, b, dst);
+    TEST_ASSERT(sameMask(dst.toMat(), or8), "bitwiseOr");
+
+    BitMask inPlace = a;
+    inPlace.andWith(b);
+    TEST_ASSERT(sameMask(inPlace.toMat(), and8), "andWith");
+    inPlace = a;
+    inPlace.orWith(b);
+    TEST_ASSERT(sameMask(inPlace.toMat(), or8), "orWith");
+
+    BitMask::bitwiseAnd(a, b, a);
+    TEST_ASSERT(sameMask(a.toMat(), and8), "bitwiseAnd输出与输入相同");
+}
+
+int main() {
+    std::cout << "=== BitMask 测试程序 ===" << std::endl;
+
+    testPackRoundTrip();
+    testSpans();
+    testBitwise();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
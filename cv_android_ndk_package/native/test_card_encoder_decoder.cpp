@@ -0,0 +1,435 @@
+#include "card_encoder_decoder.h"
+#include <iostream>
+#include <array>
+#include <cmath>
+#include <map>
+#include <vector>
+
+/**
+ * 测试程序：验证CardEncoderDecoder的编码表、容错邻域表、多读数联合解码与角标方向解码
+ *
+ * 编译命令:
+ * g++ -std=c++17 test_card_encoder_decoder.cpp card_encoder_decoder.cpp -o test_card_encoder_decoder
+ */
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+typedef std::array<int, 4> Digits;
+
+const Digits NONE = {-1, -1, -1, -1};
+
+// 按方向q的观测：逆时针边(q+2)读前两位，顺时针边(q+1)读后两位
+void placeCode(int q, const Digits& code, Digits& nearColors, Digits& farColors) {
+    int cw = (q + 1) % 4;
+    int ccw = (q + 2) % 4;
+    nearColors[ccw] = code[0];
+    farColors[ccw] = code[1];
+    nearColors[cw] = code[2];
+    farColors[cw] = code[3];
+}
+
+// 测试编码表：每张卡片的A/B组编码精确解码，回文编码不分配
+void testCodeTable(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试编码表 ===" << std::endl;
+
+    bool exactOk = true;
+    int cards = 0;
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        if (!info) continue;
+        ++cards;
+        const Digits& a = info->groupA.digits;
+        const Digits& b = info->groupB.digits;
+        auto ra = decoder.decodeEncoding(a);
+        auto rb = decoder.decodeEncoding(b);
+        auto ta = decoder.decodeTolerant(a);
+        exactOk = exactOk && ra.success && ra.cardId == cardId && ra.groupType == CardEncoderDecoder::GROUP_A &&
+                  rb.success && rb.cardId == cardId && rb.groupType == CardEncoderDecoder::GROUP_B &&
+                  decoder.decodeAGroup(a) == cardId && decoder.decodeBGroup(b) == cardId &&
+                  ta.success && ta.cardId == cardId && ta.distance == 0 && ta.confidence > 0.0f && ta.confidence <= 1.0f;
+    }
+    TEST_ASSERT(cards == decoder.getTotalCards() && cards > 0, "卡片信息齐全（" << cards << "张）");
+    TEST_ASSERT(exactOk, "A/B组编码精确解码");
+
+    TEST_ASSERT(!decoder.decodeEncoding(1, 2, 1, 2).success, "回文编码不解码");
+    TEST_ASSERT(!decoder.decodeEncoding(0, 0, 0, 6).success, "越界颜色不解码");
+    TEST_ASSERT(CardEncoderDecoder::codeIndex(0, 0, 0, -1) == -1, "codeIndex拒绝越界");
+}
+
+// 暴力计算单个观测码的解码：候选为距离不超过1的码字所属卡片，
+// 每张卡片的似然为其A/B两个码字的似然之和，按统一阈值判定接受
+struct BruteForceResult {
+    int cardId;
+    float confidence;
+};
+
+BruteForceResult bruteForceDecode(const CardEncoderDecoder& decoder, const Digits& observed) {
+    const int C = CardEncoderDecoder::NUM_COLORS;
+    auto likelihoodOf = [&](const Digits& code) {
+        float likelihood = 1.0f;
+        for (int pos = 0; pos < 4; ++pos) {
+            if (observed[pos] == CardEncoderDecoder::UNKNOWN_COLOR) continue;
+            likelihood *= CardEncoderDecoder::confusionProbability(observed[pos], code[pos]);
+        }
+        return likelihood;
+    };
+
+    std::map<int, float> cardTotal;
+    for (int code = 0; code < CardEncoderDecoder::NUM_CODES; ++code) {
+        Digits candidate = {code / (C * C * C), code / (C * C) % C, code / C % C, code % C};
+        auto entry = decoder.decodeEncoding(candidate);
+        if (!entry.success) continue;
+        int distance = 0;
+        for (int pos = 0; pos < 4; ++pos) distance += observed[pos] != candidate[pos];
+        if (distance > 1) continue;
+        auto info = decoder.getCardInfo(entry.cardId);
+        cardTotal[entry.cardId] = likelihoodOf(info->groupA.digits) + likelihoodOf(info->groupB.digits);
+    }
+
+    int bestCard = -1;
+    float best = 0.0f, runnerUp = 0.0f, total = 0.0f;
+    for (const auto& kv : cardTotal) {
+        total += kv.second;
+        if (kv.second > best) {
+            runnerUp = best;
+            best = kv.second;
+            bestCard = kv.first;
+        } else if (kv.second > runnerUp) {
+            runnerUp = kv.second;
+        }
+    }
+    if (bestCard < 0 || best < CardEncoderDecoder::MIN_DECODE_CONFIDENCE * total ||
+        best < CardEncoderDecoder::MIN_DECODE_MARGIN * runnerUp) {
+        return {-1, 0.0f};
+    }
+    return {bestCard, best / total};
+}
+
+// 测试容错邻域表：与逐个码字暴力计算的后验结果一致
+void testNeighborTable(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试容错邻域表 ===" << std::endl;
+
+    const int N = CardEncoderDecoder::NUM_OBSERVED_SYMBOLS;
+    int checked = 0;
+    int mismatches = 0;
+    int accepted = 0;
+    for (int index = 0; index < CardEncoderDecoder::NUM_OBSERVED_CODES; ++index) {
+        Digits observed = {index / (N * N * N), index / (N * N) % N, index / N % N, index % N};
+        int unknown = 0;
+        for (int digit : observed) unknown += digit == CardEncoderDecoder::UNKNOWN_COLOR;
+
+        auto result = decoder.decodeTolerant(observed);
+        ++checked;
+        if (unknown > 1) {
+            mismatches += result.success ? 1 : 0;
+            continue;
+        }
+        BruteForceResult expected = bruteForceDecode(decoder, observed);
+        if (expected.cardId < 0) {
+            mismatches += result.success ? 1 : 0;
+        } else if (!result.success || result.cardId != expected.cardId ||
+                   std::fabs(result.confidence - expected.confidence) > 1e-5f || result.distance > 1) {
+            ++mismatches;
+        }
+        accepted += result.success ? 1 : 0;
+    }
+    TEST_ASSERT(mismatches == 0, "邻域表与暴力计算一致（" << checked << "个观测码，接受" << accepted << "个）");
+
+    TEST_ASSERT(decoder.decodeTolerant(-1, 2, 3, 4).success == decoder.decodeTolerant(6, 2, 3, 4).success &&
+                decoder.decodeTolerant(99, 2, 3, 4).cardId == decoder.decodeTolerant(6, 2, 3, 4).cardId &&
+                decoder.decodeCombined(std::vector<Digits>{{-1, 2, 3, 4}, {2, 1, 0, 4}}.data(), 2).cardId ==
+                decoder.decodeCombined(std::vector<Digits>{{6, 2, 3, 4}, {2, 1, 0, 4}}.data(), 2).cardId,
+                "越界数字均视为不可读");
+    TEST_ASSERT(!decoder.decodeTolerant(-1, -1, 3, 4).success, "两个不可读数字时失败");
+}
+
+// 测试单个不可读数字：单独一个读数无法区分各填充，另一角点读数补足后恢复
+void testErasureRecovery(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试不可读数字恢复 ===" << std::endl;
+
+    int cases = 0;
+    int lone = 0;
+    int withClean = 0;
+    int withPartners = 0;
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        if (!info) continue;
+        const Digits& a = info->groupA.digits;
+        const Digits& b = info->groupB.digits;
+        for (int pos = 0; pos < 4; ++pos) {
+            Digits erased = a;
+            erased[pos] = -1;
+            ++cases;
+            lone += decoder.decodeTolerant(erased).success ? 1 : 0;
+
+            std::vector<Digits> pair = {erased, b};
+            auto r = decoder.decodeCombined(pair.data(), 2);
+            withClean += (r.success && r.cardId == cardId && r.orientation == 1) ? 1 : 0;
+
+            // 四个角点各有一个不可读数字（位置各不相同）
+            std::vector<Digits> corners(4, a);
+            for (int k = 0; k < 4; ++k) corners[k][(pos + k) % 4] = -1;
+            r = decoder.decodeCombined(corners.data(), 4);
+            withPartners += (r.success && r.cardId == cardId) ? 1 : 0;
+        }
+    }
+    TEST_ASSERT(lone == 0, "单独的残缺读数判为歧义（" << cases << "例）");
+    TEST_ASSERT(withClean == cases, "残缺读数加一个完整读数（B组）恢复原卡片（" << withClean << "/" << cases << "）");
+    TEST_ASSERT(withPartners == cases, "四个角点各缺一位时恢复原卡片（" << withPartners << "/" << cases << "）");
+}
+
+// 测试色相相邻误读：与另一卡片的精确读数无法区分，角点读数矛盾时拒绝，多数一致时取多数
+void testAmbiguousSubstitution(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试相邻色相误读 ===" << std::endl;
+
+    int cases = 0;
+    int rejected = 0;
+    int majority = 0;
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        if (!info) continue;
+        const Digits& a = info->groupA.digits;
+        for (int pos = 0; pos < 4; ++pos) {
+            Digits misread = a;
+            misread[pos] ^= 1;
+            auto other = decoder.decodeEncoding(misread);
+            if (!other.success) continue;  // 误读成回文编码时本身不是有效码字
+            ++cases;
+
+            std::vector<Digits> conflicting = {a, misread};
+            auto r = decoder.decodeCombined(conflicting.data(), 2);
+            rejected += r.success ? 0 : 1;
+
+            std::vector<Digits> corners = {a, misread, a, a};
+            r = decoder.decodeCombined(corners.data(), 4);
+            majority += (r.success && r.cardId == cardId && r.orientation == 0) ? 1 : 0;
+        }
+    }
+    TEST_ASSERT(cases > 0 && rejected == cases, "两个读数相差一个相邻色相时判为歧义（" << rejected << "/" << cases << "）");
+    TEST_ASSERT(majority == cases, "一个角点误读、三个角点一致时解码为原卡片（" << majority << "/" << cases << "）");
+
+    int clean = 0;
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        auto r = decoder.decodeTolerant(info->groupA.digits);
+        clean += (r.success && r.cardId == cardId &&
+                  r.confidence >= CardEncoderDecoder::MIN_DECODE_CONFIDENCE) ? 1 : 0;
+    }
+    TEST_ASSERT(clean == decoder.getTotalCards(), "完整读数全部通过接受阈值");
+    TEST_ASSERT(!decoder.decodeCombined(nullptr, 0).success, "没有读数时失败");
+}
+
+// 将方向0的观测整体旋转r个方向（方向d移到d+r）
+void rotateLayout(int r, Digits& nearColors, Digits& farColors) {
+    Digits nearRotated = NONE;
+    Digits farRotated = NONE;
+    for (int d = 0; d < 4; ++d) {
+        nearRotated[(d + r) % 4] = nearColors[d];
+        farRotated[(d + r) % 4] = farColors[d];
+    }
+    nearColors = nearRotated;
+    farColors = farRotated;
+}
+
+void setEdge(int d, int nearColor, int farColor, Digits& nearColors, Digits& farColors) {
+    nearColors[d] = nearColor;
+    farColors[d] = farColor;
+}
+
+// 测试四个旋转方向下的相邻方向对、四方向全有颜色与相对方向对三种布局
+void testRotations(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试四个旋转方向 ===" << std::endl;
+
+    int adjacentOk = 0, fullOk = 0, oppositeOk = 0, reflectedOk = 0, total = 0;
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        if (!info) continue;
+        const Digits& code = info->groupA.digits;
+        for (int r = 0; r < 4; ++r) {
+            ++total;
+            auto matches = [&](const CardEncoderDecoder::OrientedDecodeResult& result, CardEncoderDecoder::GroupType group) {
+                return result.success && result.cardId == cardId && result.orientation == r && result.groupType == group;
+            };
+
+            // 方向0：逆时针边D读前两位，顺时针边R读后两位
+            Digits nearColors = NONE, farColors = NONE;
+            placeCode(0, code, nearColors, farColors);
+            Digits nearAdjacent = nearColors, farAdjacent = farColors;
+            rotateLayout(r, nearAdjacent, farAdjacent);
+            adjacentOk += matches(decoder.decodeObservation(nearAdjacent, farAdjacent), CardEncoderDecoder::GROUP_A) ? 1 : 0;
+
+            // 四个方向均有颜色：U重复R的颜色对、L重复D的颜色对（如相邻卡片的同色点列），
+            // 其余读法为回文或镜像，仍唯一确定卡片与方向
+            Digits nearFull = nearColors, farFull = farColors;
+            setEdge(CardEncoderDecoder::DIR_UP, code[2], code[3], nearFull, farFull);
+            setEdge(CardEncoderDecoder::DIR_LEFT, code[0], code[1], nearFull, farFull);
+            rotateLayout(r, nearFull, farFull);
+            fullOk += matches(decoder.decodeObservation(nearFull, farFull), CardEncoderDecoder::GROUP_A) ? 1 : 0;
+
+            // 相对方向对：先读D，再读U
+            Digits nearOpposite = NONE, farOpposite = NONE;
+            setEdge(CardEncoderDecoder::DIR_DOWN, code[0], code[1], nearOpposite, farOpposite);
+            setEdge(CardEncoderDecoder::DIR_UP, code[2], code[3], nearOpposite, farOpposite);
+            rotateLayout(r, nearOpposite, farOpposite);
+            oppositeOk += matches(decoder.decodeObservation(nearOpposite, farOpposite), CardEncoderDecoder::GROUP_A) ? 1 : 0;
+
+            // 镜像：两条边互换，读到同一卡片的B组
+            Digits nearReflected = NONE, farReflected = NONE;
+            setEdge(CardEncoderDecoder::DIR_RIGHT, code[0], code[1], nearReflected, farReflected);
+            setEdge(CardEncoderDecoder::DIR_DOWN, code[2], code[3], nearReflected, farReflected);
+            rotateLayout(r, nearReflected, farReflected);
+            reflectedOk += matches(decoder.decodeObservation(nearReflected, farReflected), CardEncoderDecoder::GROUP_B) ? 1 : 0;
+        }
+    }
+    TEST_ASSERT(adjacentOk == total, "相邻方向对：卡片、A组与朝向随旋转正确（" << adjacentOk << "/" << total << "）");
+    TEST_ASSERT(fullOk == total, "四方向全有颜色：卡片、A组与朝向随旋转正确（" << fullOk << "/" << total << "）");
+    TEST_ASSERT(oppositeOk == total, "相对方向对：卡片、A组与朝向随旋转正确（" << oppositeOk << "/" << total << "）");
+    TEST_ASSERT(reflectedOk == total, "镜像布局解码为B组（" << reflectedOk << "/" << total << "）");
+}
+
+// 测试近/远颜色互换的回退读法：近/远按像素占比排序，读到回文码时尝试互换
+void testNearFarSwap(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试近/远互换回退 ===" << std::endl;
+
+    int cases = 0, ok = 0;
+    for (int a = 0; a < CardEncoderDecoder::NUM_COLORS; ++a) {
+        for (int b = 0; b < CardEncoderDecoder::NUM_COLORS; ++b) {
+            if (a == b) continue;
+            // 实际印刷为(b,a,a,b)，逆时针边的近/远被读反，观测为回文(a,b,a,b)
+            auto printed = decoder.decodeEncoding(b, a, a, b);
+            for (int r = 0; r < 4; ++r) {
+                Digits nearColors = NONE, farColors = NONE;
+                placeCode(0, {a, b, a, b}, nearColors, farColors);
+                rotateLayout(r, nearColors, farColors);
+                auto result = decoder.decodeObservation(nearColors, farColors);
+                ++cases;
+                ok += (printed.success && result.success && result.cardId == printed.cardId && result.orientation == r) ? 1 : 0;
+            }
+        }
+    }
+    TEST_ASSERT(cases > 0 && ok == cases, "回文读数经近/远互换解码为原卡片（" << ok << "/" << cases << "）");
+
+    auto info = decoder.getCardInfo(5);
+    if (!info) return;
+    Digits nearColors = NONE, farColors = NONE;
+    placeCode(0, info->groupA.digits, nearColors, farColors);
+    auto result = decoder.decodeObservation(nearColors, farColors);
+    TEST_ASSERT(result.success && result.cardId == 5, "正常读数优先于互换读法");
+}
+
+// 测试无法确定卡片的观测
+void testUnresolvableMasks(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试无效方向组合 ===" << std::endl;
+
+    auto info = decoder.getCardInfo(5);
+    if (!info) return;
+    const Digits& code = info->groupA.digits;
+
+    TEST_ASSERT(!decoder.decodeObservation(NONE, NONE).success, "无方向时失败");
+
+    Digits nearColors = NONE;
+    nearColors[CardEncoderDecoder::DIR_RIGHT] = code[0];
+    TEST_ASSERT(!decoder.decodeObservation(nearColors, NONE).success, "单个方向时失败");
+
+    // 四个方向均有颜色且其余边组成另一卡片的有效编码：多张卡片票数接近，判为歧义
+    int cases = 0, rejected = 0;
+    for (int x = 0; x < CardEncoderDecoder::NUM_COLORS; ++x) {
+        for (int y = 0; y < CardEncoderDecoder::NUM_COLORS; ++y) {
+            Digits nearFull = NONE, farFull = NONE;
+            placeCode(0, code, nearFull, farFull);
+            setEdge(CardEncoderDecoder::DIR_LEFT, code[0], code[1], nearFull, farFull);
+            setEdge(CardEncoderDecoder::DIR_UP, x, y, nearFull, farFull);
+            // 方向3读(R, U) = (code[2], code[3], x, y)
+            auto clutter = decoder.decodeTolerant(code[2], code[3], x, y);
+            if (!clutter.success || clutter.cardId == 5) continue;
+            ++cases;
+            rejected += decoder.decodeObservation(nearFull, farFull).success ? 0 : 1;
+        }
+    }
+    TEST_ASSERT(cases > 0 && rejected == cases, "其余边读出其他卡片时判为歧义（" << rejected << "/" << cases << "）");
+}
+
+// 测试三个方向时的投票：同一卡片或另一读法失败时解码，两张不同卡片票数接近时判为歧义
+void testThreeDirectionVotes(const CardEncoderDecoder& decoder) {
+    std::cout << "\n=== 测试三方向投票 ===" << std::endl;
+
+    // 缺失方向m时候选方向为m（边m+1,m+2）与m+1（边m+2,m+3），共用边m+2
+    const int m = CardEncoderDecoder::DIR_UP;
+    const int extra = (m + 3) % 4;
+    int baseWins = 0, sameCard = 0, ambiguous = 0;
+    bool baseOk = true, sameOk = true, ambiguousOk = true;
+
+    for (int cardId = 1; cardId <= decoder.getTotalCards(); ++cardId) {
+        auto info = decoder.getCardInfo(cardId);
+        if (!info) continue;
+        const Digits& code = info->groupA.digits;
+
+        Digits nearColors = NONE;
+        Digits farColors = NONE;
+        placeCode(m, code, nearColors, farColors);
+
+        // 在第三个方向放置颜色，使另一候选读到 {e, g, code[0], code[1]}
+        for (int e = 0; e < CardEncoderDecoder::NUM_COLORS; ++e) {
+            for (int g = 0; g < CardEncoderDecoder::NUM_COLORS; ++g) {
+                auto other = decoder.decodeTolerant(e, g, code[0], code[1]);
+                Digits near3 = nearColors;
+                Digits far3 = farColors;
+                near3[extra] = e;
+                far3[extra] = g;
+                auto result = decoder.decodeObservation(near3, far3);
+
+                if (!other.success) {
+                    baseWins++;
+                    baseOk = baseOk && result.success && result.orientation == m && result.cardId == cardId &&
+                             result.groupType == CardEncoderDecoder::GROUP_A;
+                } else if (other.cardId == cardId) {
+                    sameCard++;
+                    sameOk = sameOk && result.success && result.cardId == cardId &&
+                             result.groupType == CardEncoderDecoder::GROUP_A && result.orientation == m;
+                } else {
+                    ambiguous++;
+                    ambiguousOk = ambiguousOk && !result.success;
+                }
+            }
+        }
+    }
+    TEST_ASSERT(baseWins > 0 && sameCard > 0 && ambiguous > 0, "覆盖三种投票情形");
+    TEST_ASSERT(baseOk, "第三方向读法失败时保留原方向（" << baseWins << "例）");
+    TEST_ASSERT(sameOk, "两种读法为同一卡片时取A组读法（" << sameCard << "例）");
+    TEST_ASSERT(ambiguousOk, "两种读法为不同卡片时判为歧义（" << ambiguous << "例）");
+}
+
+int main() {
+    std::cout << "=== CardEncoderDecoder 测试程序 ===" << std::endl;
+
+    CardEncoderDecoder decoder;
+    testCodeTable(decoder);
+    testNeighborTable(decoder);
+    testErasureRecovery(decoder);
+    testAmbiguousSubstitution(decoder);
+    testRotations(decoder);
+    testNearFarSwap(decoder);
+    testUnresolvableMasks(decoder);
+    testThreeDirectionVotes(decoder);
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
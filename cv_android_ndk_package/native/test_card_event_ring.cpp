@@ -0,0 +1,122 @@
+#include "card_event_ring.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/**
+ * 测试程序：验证CardEventRing的顺序、满时丢弃与丢失标记，以及单生产者/单消费者并发
+ *
+ * 编译命令:
+ * g++ -std=c++17 -pthread test_card_event_ring.cpp -o test_card_event_ring
+ */
+
+using namespace DotCardDetect;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+CardEvent makeEvent(int frame) {
+    CardEvent event = CardEvent();
+    event.type = CARD_EVENT_MOVE;
+    event.track_id = frame % 7;
+    event.card_id = -1;
+    event.group_type = -1;
+    event.code_corner = -1;
+    event.frame = frame;
+    return event;
+}
+
+// 测试顺序、容量与环绕
+void testOrderAndCapacity() {
+    std::cout << "\n=== 测试顺序与容量 ===" << std::endl;
+
+    CardEventRing ring(5);  // 向上取整为8
+    CardEvent out[16];
+    int pushed = 0;
+    while (ring.push(makeEvent(pushed))) ++pushed;
+    TEST_ASSERT(pushed == 8, "容量向上取整为2的幂");
+    TEST_ASSERT(ring.takeLost(), "满时丢弃并标记丢失");
+    TEST_ASSERT(!ring.takeLost(), "takeLost读取后清除标记");
+
+    int n = ring.pop(out, 3);
+    TEST_ASSERT(n == 3 && out[0].frame == 0 && out[2].frame == 2, "按写入顺序取出且不超过maxEvents");
+
+    // 释放空间后继续写入，跨越缓冲区末尾
+    for (int i = 0; i < 3; ++i) ring.push(makeEvent(pushed++));
+    n = ring.pop(out, 16);
+    bool ordered = n == 8;
+    for (int i = 0; i < n; ++i) ordered = ordered && out[i].frame == 3 + i;
+    TEST_ASSERT(ordered, "环绕后顺序正确");
+    TEST_ASSERT(ring.pop(out, 16) == 0, "取空后返回0");
+
+    ring.push(makeEvent(100));
+    ring.push(makeEvent(101));
+    ring.discard();
+    TEST_ASSERT(ring.pop(out, 16) == 0, "discard丢弃全部待取事件");
+    ring.push(makeEvent(102));
+    TEST_ASSERT(ring.pop(out, 16) == 1 && out[0].frame == 102, "discard后继续可用");
+}
+
+// 测试一个生产者线程与一个消费者线程并发读写
+void testConcurrent() {
+    std::cout << "\n=== 测试并发读写 ===" << std::endl;
+
+    const int total = 200000;
+    CardEventRing ring(64);
+    std::vector<int> received;
+    received.reserve(total);
+
+    std::thread producer([&ring]() {
+        for (int i = 0; i < total; ) {
+            if (ring.push(makeEvent(i))) {
+                ++i;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    CardEvent out[32];
+    bool contentOk = true;
+    while (static_cast<int>(received.size()) < total) {
+        int n = ring.pop(out, 32);
+        for (int i = 0; i < n; ++i) {
+            contentOk = contentOk && out[i].track_id == out[i].frame % 7 && out[i].type == CARD_EVENT_MOVE;
+            received.push_back(out[i].frame);
+        }
+        if (n == 0) std::this_thread::yield();
+    }
+    producer.join();
+
+    bool ordered = true;
+    for (int i = 0; i < total; ++i) ordered = ordered && received[i] == i;
+    TEST_ASSERT(ordered, "并发时事件不丢失、不重复且有序");
+    TEST_ASSERT(contentOk, "并发时事件内容完整");
+}
+
+int main() {
+    std::cout << "=== CardEventRing 测试程序 ===" << std::endl;
+
+    testOrderAndCapacity();
+    testConcurrent();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
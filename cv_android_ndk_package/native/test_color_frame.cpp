@@ -0,0 +1,138 @@
+#include "color_frame.h"
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * 测试程序：验证ColorFrame默认构建路径的区域计数（积分图）与逐像素计数、popcount回退路径一致
+ *
+ * 编译命令（依赖检测核心库）:
+ * g++ -std=c++17 test_color_frame.cpp -L. -lprojectioncards `pkg-config --cflags --libs opencv4` -o test_color_frame
+ */
+
+using namespace DotCardDetect;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+// 随机块状0/255掩码
+cv::Mat randomMask(int rows, int cols, unsigned seed) {
+    std::mt19937 rng(seed);
+    cv::Mat mask = cv::Mat::zeros(rows, cols, CV_8UC1);
+    for (int i = 0; i < 40; ++i) {
+        cv::Rect block(static_cast<int>(rng() % cols), static_cast<int>(rng() % rows),
+                       1 + static_cast<int>(rng() % 40), 1 + static_cast<int>(rng() % 30));
+        mask(block & cv::Rect(0, 0, cols, rows)).setTo(255);
+    }
+    return mask;
+}
+
+int countNonZero8(const cv::Mat& mask, int y, int x0, int x1) {
+    if (y < 0 || y >= mask.rows) return 0;
+    int total = 0;
+    const uchar* row = mask.ptr<uchar>(y);
+    for (int x = std::max(0, x0); x < std::min(mask.cols, x1); ++x) total += row[x] != 0;
+    return total;
+}
+
+// 测试默认路径（buildColorFrameFromMasks不带withIntegrals参数）的区域计数
+void testDefaultRegionSums() {
+    std::cout << "\n=== 测试默认路径的区域计数 ===" << std::endl;
+
+    const int rows = 90;
+    const int cols = 211;
+    std::map<std::string, cv::Mat> masks;
+    masks["Red"] = randomMask(rows, cols, 1);
+    masks["Green"] = randomMask(rows, cols, 2);
+    const cv::Mat hsv(rows, cols, CV_8UC3, cv::Scalar(0, 0, 0));
+
+    ColorFrame frame = buildColorFrameFromMasks(hsv, masks);
+    ColorFrame popcount = buildColorFrameFromMasks(hsv, masks, false);
+    TEST_ASSERT(frame.integrals.size() == frame.colorCount() && frame.colorCount() == 2, "默认建立每种颜色的积分图");
+    TEST_ASSERT(popcount.integrals.empty(), "withIntegrals=false时不建立积分图");
+
+    bool rectOk = true;
+    for (size_t c = 0; c < frame.colorCount(); ++c) {
+        const cv::Mat& mask = masks[frame.colorNames[c]];
+        for (int i = 0; i < 30; ++i) {
+            cv::Rect rect(i * 9 - 20, i * 3 - 10, 25 + i * 4, 12 + i);
+            int expected = 0;
+            for (int y = rect.y; y < rect.y + rect.height; ++y) expected += countNonZero8(mask, y, rect.x, rect.x + rect.width);
+            rectOk = rectOk && frame.countInRect(c, rect) == expected && popcount.countInRect(c, rect) == expected;
+        }
+    }
+    TEST_ASSERT(rectOk, "countInRect（含越界裁剪）与逐像素计数一致");
+
+    // 旋转区域按行区间计数，区间部分越出图像
+    std::vector<cv::Point2f> triangle = {cv::Point2f(-15.0f, 5.0f), cv::Point2f(120.0f, 40.0f), cv::Point2f(30.0f, 110.0f)};
+    std::vector<RowSpan> spans;
+    rasterizeConvexPolygon(triangle, cv::Rect(-50, -50, cols + 100, rows + 100), spans);
+    const cv::Point offset(7, -3);
+
+    bool spanOk = !spans.empty();
+    for (size_t c = 0; c < frame.colorCount(); ++c) {
+        const cv::Mat& mask = masks[frame.colorNames[c]];
+        int expected = 0;
+        for (const auto& span : spans) {
+            const int y = span.y + offset.y;
+            const int x0 = span.x0 + offset.x;
+            const int x1 = span.x1 + offset.x;
+            expected += countNonZero8(mask, y, x0, x1);
+            spanOk = spanOk && frame.countInRowSpan(c, y, x0, x1) == countNonZero8(mask, y, x0, x1);
+        }
+        spanOk = spanOk && frame.countInSpans(c, spans, offset) == expected &&
+                 popcount.countInSpans(c, spans, offset) == expected;
+    }
+    TEST_ASSERT(spanOk, "countInSpans/countInRowSpan与逐像素计数、popcount路径一致");
+}
+
+// 测试由BGR图像构建时默认同样建立积分图
+void testBuildFromImage() {
+    std::cout << "\n=== 测试由图像构建 ===" << std::endl;
+
+    cv::Mat bgr(60, 100, CV_8UC3, cv::Scalar(255, 255, 255));
+    bgr(cv::Rect(10, 10, 30, 20)).setTo(cv::Scalar(0, 0, 255));    // 红
+    bgr(cv::Rect(50, 30, 40, 25)).setTo(cv::Scalar(255, 0, 0));    // 蓝
+
+    ColorFrame frame = buildColorFrame(bgr, getDefaultColorRanges());
+    TEST_ASSERT(!frame.empty() && frame.integrals.size() == frame.colorCount(), "buildColorFrame默认建立积分图");
+
+    bool countOk = true;
+    for (size_t c = 0; c < frame.colorCount(); ++c) {
+        const cv::Rect whole(0, 0, frame.cols(), frame.rows());
+        countOk = countOk && frame.countInRect(c, whole) == frame.colorBits[c].count();
+        if (frame.colorNames[c] == "Red") countOk = countOk && frame.countInRect(c, cv::Rect(0, 0, 45, 35)) == 600;
+        if (frame.colorNames[c] == "Blue") countOk = countOk && frame.countInRect(c, cv::Rect(50, 30, 20, 10)) == 200;
+    }
+    TEST_ASSERT(countOk, "积分图计数与位掩码计数一致");
+}
+
+int main() {
+    std::cout << "=== ColorFrame 测试程序 ===" << std::endl;
+
+    testDefaultRegionSums();
+    testBuildFromImage();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
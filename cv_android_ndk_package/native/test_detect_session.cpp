@@ -0,0 +1,158 @@
+#include "detect_session.h"
+#include <iostream>
+#include <vector>
+
+/**
+ * 测试程序：验证检测会话在运动门控复用帧上的轨迹老化与REMOVE事件，
+ * 以及各质量档位工作分辨率下mark尺寸门限的缩放
+ *
+ * 编译命令（依赖检测核心库）:
+ * g++ -std=c++17 test_detect_session.cpp -L. -lprojectioncards `pkg-config --cflags --libs opencv4` -o test_detect_session
+ */
+
+using namespace DotCardDetect;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+const int MAX_MISSED = 2;
+
+// 白色桌面；withCard时放一个黑色方形mark（检测为单角卡片）
+cv::Mat makeScene(bool withCard) {
+    cv::Mat bgr(240, 320, CV_8UC3, cv::Scalar(255, 255, 255));
+    if (withCard) {
+        bgr(cv::Rect(100, 80, 40, 40)).setTo(cv::Scalar(0, 0, 0));
+    }
+    return bgr;
+}
+
+DetectionSessionConfig makeConfig() {
+    DetectionSessionConfig config;
+    config.maxMissedFrames = MAX_MISSED;
+    config.motionGating = true;
+    return config;
+}
+
+// 取出全部事件，统计某类型的个数
+int countEvents(DetectionSession& session, int type) {
+    CardEvent events[64];
+    int total = 0;
+    int n;
+    while ((n = session.pollEvents(events, 64)) > 0) {
+        for (int i = 0; i < n; ++i) total += events[i].type == type;
+    }
+    return total;
+}
+
+// 卡片拿走后桌面静止：后续帧全部被门控复用，轨迹仍需老化并发出REMOVE
+void testRemoveOnGatedFrames() {
+    std::cout << "\n=== 测试门控帧上的REMOVE ===" << std::endl;
+
+    DetectionSession session(makeConfig());
+    DetectedCard cards[8];
+    const cv::Mat card = makeScene(true);
+    const cv::Mat empty = makeScene(false);
+
+    int n = session.process(card, cards, 8);
+    TEST_ASSERT(n == 1 && cards[0].track_id > 0, "检测到卡片并建立轨迹");
+    TEST_ASSERT(countEvents(session, CARD_EVENT_ADD) == 1, "首帧发出ADD");
+
+    // 拿走卡片：这一帧有变化，实际检测后没有卡片
+    n = session.process(empty, cards, 8);
+    TEST_ASSERT(n == 0, "卡片拿走后不再输出");
+
+    const int reusedBefore = session.reusedFrameCount();
+    int removes = countEvents(session, CARD_EVENT_REMOVE);
+    for (int i = 0; i < MAX_MISSED + 1; ++i) {
+        session.process(empty, cards, 8);
+        removes += countEvents(session, CARD_EVENT_REMOVE);
+    }
+    TEST_ASSERT(session.reusedFrameCount() - reusedBefore == MAX_MISSED + 1, "静止画面被门控复用");
+    TEST_ASSERT(removes == 1, "丢失超过maxMissedFrames后在复用帧上发出一次REMOVE");
+
+    for (int i = 0; i < 5; ++i) session.process(empty, cards, 8);
+    TEST_ASSERT(countEvents(session, CARD_EVENT_REMOVE) == 0, "REMOVE不重复发出");
+}
+
+// 卡片静止不动：复用帧刷新轨迹，不会被误删
+void testStaticCardKept() {
+    std::cout << "\n=== 测试静止卡片保持 ===" << std::endl;
+
+    DetectionSession session(makeConfig());
+    DetectedCard cards[8];
+    const cv::Mat card = makeScene(true);
+
+    session.process(card, cards, 8);
+    int n = 0;
+    for (int i = 0; i < MAX_MISSED * 4; ++i) n = session.process(card, cards, 8);
+    TEST_ASSERT(session.reusedFrameCount() == MAX_MISSED * 4, "静止帧全部复用");
+    TEST_ASSERT(n == 1 && cards[0].reused == 1, "复用帧继续输出缓存卡片");
+    TEST_ASSERT(countEvents(session, CARD_EVENT_REMOVE) == 0, "仍在画面中的卡片不发出REMOVE");
+}
+
+// 在各质量档位的工作分辨率上检测mark：尺寸门限随scale缩放，保留/剔除的mark与原图一致
+void testMarkGatesPerQualityLevel() {
+    std::cout << "\n=== 测试各质量档位的mark尺寸门限 ===" << std::endl;
+
+    // 原图二值图：14px与40px的mark有效；8px过小；280px的周长与面积超出上限
+    cv::Mat full = cv::Mat::zeros(480, 640, CV_8UC1);
+    const cv::Rect squares[] = {cv::Rect(40, 40, 14, 14), cv::Rect(120, 40, 8, 8),
+                                cv::Rect(200, 40, 40, 40), cv::Rect(300, 150, 280, 280)};
+    for (const auto& square : squares) full(square).setTo(255);
+    const cv::Point2f expected[] = {cv::Point2f(47.0f, 47.0f), cv::Point2f(220.0f, 60.0f)};
+
+    LatencyGovernorConfig config;
+    config.budgetMs = 10.0f;
+    LatencyGovernor governor(config);
+    StageTimings slow;
+    slow.totalMs = 100.0f;
+
+    for (int level = 0; level < governor.levelCount(); ++level, governor.report(slow)) {
+        const float scale = governor.level().scale;
+        cv::Mat image = full;
+        if (scale < 1.0f) {
+            cv::resize(full, image, cv::Size(), scale, scale, cv::INTER_AREA);
+            cv::threshold(image, image, 127, 255, cv::THRESH_BINARY);
+        }
+
+        auto marks = detectMarks(image, scale);
+        bool positionsOk = marks.size() == 2;
+        for (size_t i = 0; positionsOk && i < marks.size(); ++i) {
+            cv::Rect box = cv::boundingRect(marks[i]);
+            cv::Point2f center((box.x + box.width * 0.5f) / scale, (box.y + box.height * 0.5f) / scale);
+            bool matched = false;
+            for (const auto& point : expected) matched = matched || cv::norm(center - point) < 3.0f;
+            positionsOk = matched;
+        }
+        TEST_ASSERT(governor.levelIndex() == level && positionsOk,
+                    "档位" << level << "（scale " << scale << "）保留两个有效mark，剔除过小与过大的mark");
+    }
+}
+
+int main() {
+    std::cout << "=== DetectionSession 测试程序 ===" << std::endl;
+
+    testRemoveOnGatedFrames();
+    testStaticCardKept();
+    testMarkGatesPerQualityLevel();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include "frame_stream.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * 测试程序：验证帧流写入/读取往返、缺失索引时的顺序扫描恢复与损坏索引的拒绝
+ *
+ * 编译命令:
+ * g++ -std=c++17 test_frame_stream.cpp frame_stream.cpp -o test_frame_stream
+ * （启用LZ4时追加 -DFRAME_STREAM_HAVE_LZ4=1 -llz4）
+ */
+
+using namespace FrameStream;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+const char* STREAM_PATH = "test_frame_stream.tfs";
+const int FRAME_COUNT = 5;
+
+// 第index帧的内容：平坦区域便于压缩，夹杂按帧变化的字节
+std::vector<uint8_t> makeFrame(const StreamInfo& info, int index) {
+    std::vector<uint8_t> frame(frameBytes(info.format, info.width, info.height), static_cast<uint8_t>(index * 10));
+    for (size_t i = 0; i < frame.size(); i += 97) {
+        frame[i] = static_cast<uint8_t>(i * 31 + index);
+    }
+    return frame;
+}
+
+StreamInfo makeInfo(PixelFormat format) {
+    StreamInfo info;
+    info.format = format;
+    info.width = 64;
+    info.height = 48;
+    info.metadata = "{\"fx\":512.5,\"cx\":32}";  // 长度不是8的倍数，覆盖元数据后的对齐填充
+    return info;
+}
+
+bool writeStream(const StreamInfo& info, bool compress) {
+    Writer writer;
+    if (!writer.open(STREAM_PATH, info, compress)) return false;
+    for (int i = 0; i < FRAME_COUNT; ++i) {
+        std::vector<uint8_t> frame = makeFrame(info, i);
+        if (!writer.write(frame.data(), 1000000ULL * i + 7)) return false;
+    }
+    writer.close();
+    return true;
+}
+
+// 逐帧比对读取结果（倒序读取以覆盖随机访问）
+bool framesMatch(Reader& reader, const StreamInfo& info) {
+    if (reader.frameCount() != static_cast<size_t>(FRAME_COUNT)) return false;
+    for (int i = FRAME_COUNT - 1; i >= 0; --i) {
+        FrameView view;
+        if (!reader.frame(static_cast<size_t>(i), view)) return false;
+        std::vector<uint8_t> expected = makeFrame(info, i);
+        if (view.timestampNs != 1000000ULL * i + 7 || view.bytes != expected.size() ||
+            std::memcmp(view.data, expected.data(), expected.size()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> readFile() {
+    std::vector<uint8_t> bytes;
+    if (std::FILE* file = std::fopen(STREAM_PATH, "rb")) {
+        uint8_t buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+        std::fclose(file);
+    }
+    return bytes;
+}
+
+void writeFile(const std::vector<uint8_t>& bytes) {
+    if (std::FILE* file = std::fopen(STREAM_PATH, "wb")) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+}
+
+// 测试往返
+void testRoundTrip() {
+    std::cout << "\n=== 测试写入读取往返 ===" << std::endl;
+
+    const PixelFormat formats[] = {PIXEL_FORMAT_NV21, PIXEL_FORMAT_BGR8, PIXEL_FORMAT_GRAY8};
+    for (PixelFormat format : formats) {
+        StreamInfo info = makeInfo(format);
+        TEST_ASSERT(writeStream(info, false), "写入格式" << format);
+
+        Reader reader;
+        bool opened = reader.open(STREAM_PATH);
+        TEST_ASSERT(opened && reader.info().format == format && reader.info().width == info.width &&
+                    reader.info().height == info.height && reader.info().metadata == info.metadata,
+                    "文件头与元数据往返（格式" << format << "）");
+        TEST_ASSERT(opened && framesMatch(reader, info), "帧数据与时间戳往返（格式" << format << "）");
+    }
+
+    StreamInfo info = makeInfo(PIXEL_FORMAT_NV21);
+    TEST_ASSERT(writeStream(info, true), "压缩写入（LZ4" << (lz4Available() ? "已启用" : "未编译，按原始数据保存") << "）");
+    Reader reader;
+    TEST_ASSERT(reader.open(STREAM_PATH) && framesMatch(reader, info), "压缩帧往返");
+
+    FrameView view;
+    TEST_ASSERT(!reader.frame(FRAME_COUNT, view), "越界帧序号返回失败");
+
+    Writer writer;
+    StreamInfo bad = info;
+    bad.width = 0;
+    TEST_ASSERT(!writer.open(STREAM_PATH, bad), "拒绝无效尺寸");
+}
+
+// 测试缺失索引与损坏索引
+void testIndexRecovery() {
+    std::cout << "\n=== 测试索引恢复与校验 ===" << std::endl;
+
+    StreamInfo info = makeInfo(PIXEL_FORMAT_GRAY8);
+    writeStream(info, false);
+    const std::vector<uint8_t> intact = readFile();
+    const size_t indexBytes = FRAME_COUNT * 8 + 24;
+
+    // 录制中断：没有索引，顺序扫描恢复全部帧
+    writeFile(std::vector<uint8_t>(intact.begin(), intact.end() - indexBytes));
+    Reader scanned;
+    TEST_ASSERT(scanned.open(STREAM_PATH) && framesMatch(scanned, info), "无索引时顺序扫描恢复");
+
+    // 最后一帧被截断：扫描只恢复完整的帧
+    writeFile(std::vector<uint8_t>(intact.begin(), intact.end() - indexBytes - 100));
+    Reader truncated;
+    TEST_ASSERT(truncated.open(STREAM_PATH) && truncated.frameCount() == static_cast<size_t>(FRAME_COUNT - 1),
+                "截断的末帧不被扫描");
+
+    // 索引指向的记录越过索引起点：打开失败
+    std::vector<uint8_t> corrupt = intact;
+    const size_t lastEntry = intact.size() - 24 - 8;
+    const size_t lastRecord = corrupt[lastEntry] | (corrupt[lastEntry + 1] << 8) | (corrupt[lastEntry + 2] << 16);
+    corrupt[lastRecord] = 0xFF;
+    corrupt[lastRecord + 1] = 0xFF;
+    writeFile(corrupt);
+    Reader oversized;
+    TEST_ASSERT(!oversized.open(STREAM_PATH) && !oversized.error().empty(), "记录长度越界时打开失败");
+
+    corrupt = intact;
+    corrupt[lastEntry + 5] = 0x01;  // 偏移远超文件大小
+    writeFile(corrupt);
+    Reader badOffset;
+    TEST_ASSERT(!badOffset.open(STREAM_PATH), "索引偏移越界时打开失败");
+
+    corrupt = intact;
+    corrupt[intact.size() - 24] = 0x7F;  // 帧数与索引长度不符
+    writeFile(corrupt);
+    Reader badCount;
+    TEST_ASSERT(!badCount.open(STREAM_PATH), "索引帧数不符时打开失败");
+
+    corrupt = intact;
+    corrupt[0] = 'X';
+    writeFile(corrupt);
+    Reader badMagic;
+    TEST_ASSERT(!badMagic.open(STREAM_PATH), "文件头magic错误时打开失败");
+}
+
+int main() {
+    std::cout << "=== FrameStream 测试程序 ===" << std::endl;
+
+    testRoundTrip();
+    testIndexRecovery();
+    std::remove(STREAM_PATH);
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+#include "json_writer.h"
+#include <iostream>
+#include <limits>
+#include <string>
+
+/**
+ * 测试程序：验证JsonWriter三种格式的输出、转义、数字格式与深层嵌套
+ *
+ * 编译命令:
+ * g++ -std=c++17 test_json_writer.cpp -o test_json_writer
+ */
+
+using namespace JsonOutput;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+void writeSample(JsonWriter& writer) {
+    writer.beginObject();
+    writer.key("a").value(1);
+    writer.key("b").beginArray().value(true).valueNull().value("x").endArray();
+    writer.key("c").beginObject().endObject();
+    writer.key("d").beginArray(true).value(1).value(2).endArray();
+    writer.endObject();
+}
+
+// 测试三种输出格式
+void testStyles() {
+    std::cout << "\n=== 测试输出格式 ===" << std::endl;
+
+    JsonWriter compact(JsonStyle::COMPACT);
+    writeSample(compact);
+    TEST_ASSERT(compact.str() == "{\"a\":1,\"b\":[true,null,\"x\"],\"c\":{},\"d\":[1,2]}", "COMPACT格式");
+
+    JsonWriter spaced(JsonStyle::SPACED);
+    writeSample(spaced);
+    TEST_ASSERT(spaced.str() == "{\"a\": 1, \"b\": [true, null, \"x\"], \"c\": {}, \"d\": [1, 2]}", "SPACED格式");
+
+    JsonWriter pretty(JsonStyle::PRETTY);
+    writeSample(pretty);
+    const std::string expected =
+        "{\n"
+        "  \"a\": 1,\n"
+        "  \"b\": [\n"
+        "    true,\n"
+        "    null,\n"
+        "    \"x\"\n"
+        "  ],\n"
+        "  \"c\": {},\n"
+        "  \"d\": [1, 2]\n"
+        "}";
+    TEST_ASSERT(pretty.str() == expected, "PRETTY格式（inline数组在同一行）");
+
+    // 顶层数组中的多个对象
+    JsonWriter lines(JsonStyle::COMPACT);
+    lines.beginArray();
+    for (int i = 0; i < 3; ++i) lines.beginObject().key("i").value(i).endObject();
+    lines.endArray();
+    TEST_ASSERT(lines.str() == "[{\"i\":0},{\"i\":1},{\"i\":2}]", "数组中对象之间的逗号");
+}
+
+// 测试字符串转义
+void testEscaping() {
+    std::cout << "\n=== 测试转义 ===" << std::endl;
+
+    JsonWriter writer;
+    writer.value(std::string("q\"b\\n\nr\rt\t\x01 中文", 18));
+    TEST_ASSERT(writer.str() == "\"q\\\"b\\\\n\\nr\\rt\\t\\u0001 中文\"", "引号、反斜杠、控制字符转义，UTF-8原样输出");
+
+    writer.clear();
+    writer.beginObject().key("k\"").value("").endObject();
+    TEST_ASSERT(writer.str() == "{\"k\\\"\":\"\"}", "键名转义与空字符串");
+}
+
+// 测试数字格式
+void testNumbers() {
+    std::cout << "\n=== 测试数字 ===" << std::endl;
+
+    JsonWriter writer;
+    writer.beginArray()
+        .value(-42)
+        .value(static_cast<unsigned long long>(18446744073709551615ULL))
+        .value(0.1)
+        .value(1.5, 2)
+        .value(-0.004, 2)
+        .value(std::numeric_limits<double>::quiet_NaN())
+        .value(std::numeric_limits<double>::infinity(), 3)
+        .value(1e300)
+        .endArray();
+    TEST_ASSERT(writer.str() == "[-42,18446744073709551615,0.1,1.50,-0.00,null,null,1e+300]",
+                "整数、最短往返浮点、固定小数位，非有限值为null");
+
+    // 超过初始预留空间的定点数
+    writer.clear();
+    writer.value(1e40, 3);
+    TEST_ASSERT(writer.size() == 45 && writer.str().compare(writer.size() - 4, 4, ".000") == 0, "长定点数扩大预留后格式化");
+}
+
+// 测试深层嵌套与clear复用
+void testDepth() {
+    std::cout << "\n=== 测试嵌套深度 ===" << std::endl;
+
+    const int depth = JsonWriter::RESERVED_DEPTH * 3;
+    JsonWriter writer(JsonStyle::SPACED);
+    for (int i = 0; i < depth; ++i) writer.beginArray().value(i);
+    for (int i = 0; i < depth; ++i) writer.value(-i).endArray();
+
+    // 逐层拼接期望输出：每层先写一个值，内层闭合后再写一个值
+    std::string expected;
+    for (int i = 0; i < depth; ++i) expected += "[" + std::to_string(i) + ", ";
+    for (int i = 0; i < depth; ++i) {
+        expected += std::to_string(-i);
+        expected += "]";
+        if (i + 1 < depth) expected += ", ";
+    }
+    TEST_ASSERT(writer.str() == expected, "超过预留深度的嵌套逗号正确");
+
+    JsonWriter pretty(JsonStyle::PRETTY);
+    for (int i = 0; i < depth; ++i) pretty.beginObject().key("k");
+    pretty.value(1);
+    for (int i = 0; i < depth; ++i) pretty.endObject();
+    const std::string& text = pretty.str();
+    const std::string innermost = "\n" + std::string(depth * 2, ' ') + "\"k\": 1\n";
+    TEST_ASSERT(text.find(innermost) != std::string::npos && text.back() == '}', "超过预留深度的缩进正确");
+
+    writer.clear();
+    writer.beginObject().key("x").value(1).endObject();
+    TEST_ASSERT(writer.str() == "{\"x\": 1}", "clear后重新开始");
+}
+
+int main() {
+    std::cout << "=== JsonWriter 测试程序 ===" << std::endl;
+
+    testStyles();
+    testEscaping();
+    testNumbers();
+    testDepth();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}
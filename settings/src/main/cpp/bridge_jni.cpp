@@ -13,6 +13,9 @@ typedef int jint;
 typedef void* jobject;
 typedef void* jbyteArray;
 typedef void* jintArray;
+typedef void* jstring;
+typedef unsigned char jboolean;
+typedef float jfloat;
 #ifndef JNI_ABORT
 #define JNI_ABORT 0
 #endif
@@ -24,6 +27,22 @@ typedef const struct JNINativeInterface_* JNIEnv;
 #include <exception>
 #include "detect_decode_api.h"
 
+// 预览帧连续送入同一个会话，已确认的卡片复用缓存ID而不必逐帧解码
+// 预览帧的单帧延迟预算（毫秒），超出时会话自动降低工作分辨率等以保证帧率
+static const float kFrameBudgetMs = 25.0f;
+
+static DetectSessionHandle sharedSession() {
+    static DetectSessionHandle session = [] {
+        DetectSessionHandle s = detect_session_create();
+        if (s) detect_session_set_latency_budget(s, kFrameBudgetMs);
+        return s;
+    }();
+    return session;
+}
+
+// processNv21 的结果数组容量
+static const int kSessionMaxCards = 64;
+
 extern "C" JNIEXPORT jintArray JNICALL
 Java_com_tableos_settings_ProjectionCardsBridge_detectDecodeNv21(
         JNIEnv* env, jobject /*thiz*/, jbyteArray nv21, jint width, jint height, jint max_cards) {
@@ -39,7 +58,10 @@ Java_com_tableos_settings_ProjectionCardsBridge_detectDecodeNv21(
                 w = width;
                 h = height;
             }
-            count = detect_decode_cards_nv21(reinterpret_cast<const unsigned char*>(data), w, h, cards, max_cards);
+            DetectSessionHandle session = sharedSession();
+            const unsigned char* frame = reinterpret_cast<const unsigned char*>(data);
+            count = session ? detect_session_process_nv21(session, frame, w, h, cards, max_cards)
+                            : detect_decode_cards_nv21(frame, w, h, cards, max_cards);
         }
     } catch (const std::exception& /*e*/) {
         count = 0;
@@ -65,4 +87,98 @@ Java_com_tableos_settings_ProjectionCardsBridge_detectDecodeNv21(
     if (data) env->ReleaseByteArrayElements(nv21, data, JNI_ABORT);
     if (cards) delete[] cards;
     return result;
-}
\ No newline at end of file
+}
+
+// 只把预览帧送入会话，结果通过 pollEvents 以增量事件取回，桌面静止时几乎没有 JNI 数据往返
+extern "C" JNIEXPORT jint JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_processNv21(
+        JNIEnv* env, jobject /*thiz*/, jbyteArray nv21, jint width, jint height) {
+    DetectSessionHandle session = sharedSession();
+    if (!session || !nv21 || width <= 0 || height <= 0) return 0;
+    jbyte* data = env->GetByteArrayElements(nv21, nullptr);
+    if (!data) return 0;
+    // 结果数组只用于满足接口，事件中包含全部轨迹
+    DetectedCard cards[kSessionMaxCards];
+    int count = 0;
+    try {
+        int w = width - (width & 1);
+        int h = height - (height & 1);
+        if (w <= 0 || h <= 0) {
+            w = width;
+            h = height;
+        }
+        count = detect_session_process_nv21(session, reinterpret_cast<const unsigned char*>(data), w, h,
+                                            cards, kSessionMaxCards);
+    } catch (...) {
+        count = 0;
+    }
+    env->ReleaseByteArrayElements(nv21, data, JNI_ABORT);
+    return count;
+}
+
+// 取出增量事件：[count, 每个事件9个int: type, trackId, cardId, group, tlx, tly, brx, bry, codeCorner]
+extern "C" JNIEXPORT jintArray JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_pollEvents(
+        JNIEnv* env, jobject /*thiz*/, jint max_events) {
+    DetectSessionHandle session = sharedSession();
+    std::vector<CardEvent> events(max_events > 0 ? max_events : 0);
+    int count = (session && !events.empty())
+                ? detect_session_poll_events(session, events.data(), (int)events.size()) : 0;
+    int out_len = 1 + count * 9;
+    std::vector<jint> tmp(out_len);
+    tmp[0] = count;
+    for (int i = 0; i < count; ++i) {
+        const CardEvent& e = events[i];
+        int base = 1 + i * 9;
+        tmp[base + 0] = e.type;
+        tmp[base + 1] = e.track_id;
+        tmp[base + 2] = e.card_id;
+        tmp[base + 3] = e.group_type;
+        tmp[base + 4] = e.tl_x;
+        tmp[base + 5] = e.tl_y;
+        tmp[base + 6] = e.br_x;
+        tmp[base + 7] = e.br_y;
+        tmp[base + 8] = e.code_corner;
+    }
+    jintArray result = env->NewIntArray(out_len);
+    if (result) {
+        env->SetIntArrayRegion(result, 0, out_len, tmp.data());
+    }
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_setMoveEpsilon(
+        JNIEnv* /*env*/, jobject /*thiz*/, jfloat pixels) {
+    DetectSessionHandle session = sharedSession();
+    if (session) detect_session_set_move_epsilon(session, pixels);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_resetSession(
+        JNIEnv* /*env*/, jobject /*thiz*/) {
+    DetectSessionHandle session = sharedSession();
+    if (session) detect_session_reset(session);
+}
+
+// 录制送入会话的预览帧（帧流格式），用于离线回放复现性能问题
+extern "C" JNIEXPORT void JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_startRecording(
+        JNIEnv* env, jobject /*thiz*/, jstring path, jstring metadata, jboolean compress) {
+    DetectSessionHandle session = sharedSession();
+    if (!session || !path) return;
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    const char* metadataChars = metadata ? env->GetStringUTFChars(metadata, nullptr) : nullptr;
+    if (pathChars) {
+        detect_session_start_recording(session, pathChars, metadataChars, compress ? 1 : 0);
+    }
+    if (metadataChars) env->ReleaseStringUTFChars(metadata, metadataChars);
+    if (pathChars) env->ReleaseStringUTFChars(path, pathChars);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_tableos_settings_ProjectionCardsBridge_stopRecording(
+        JNIEnv* /*env*/, jobject /*thiz*/) {
+    DetectSessionHandle session = sharedSession();
+    if (session) detect_session_stop_recording(session);
+}
@@ -50,6 +50,8 @@ class InputRecognitionTestFragment : Fragment() {
 
     private val REQUEST_CAMERA = 1101
     @Volatile private var processing = false
+    // 由增量事件维护的当前卡片（仅在后台处理线程访问）
+    private val trackedCards = LinkedHashMap<Int, IntArray>()
 
     override fun onCreateView(inflater: LayoutInflater, container: ViewGroup?, savedInstanceState: Bundle?): View {
         return inflater.inflate(R.layout.fragment_input_recognition_test, container, false)
@@ -92,6 +94,9 @@ class InputRecognitionTestFragment : Fragment() {
         if (cameraId == null) { Toast.makeText(requireContext(), "未找到可用摄像头", Toast.LENGTH_SHORT).show(); return }
         try {
             if (ContextCompat.checkSelfPermission(requireContext(), Manifest.permission.CAMERA) != PackageManager.PERMISSION_GRANTED) return
+            // 重新开始识别：清空原生会话的轨迹，之后的卡片都会以 ADD 事件重新发布
+            trackedCards.clear()
+            ProjectionCardsBridge.resetSessionSafe()
             startBackgroundThread()
             manager.openCamera(cameraId, object : CameraDevice.StateCallback() {
                 override fun onOpened(device: CameraDevice) { cameraDevice = device; createPreviewSession() }
@@ -331,9 +336,27 @@ class InputRecognitionTestFragment : Fragment() {
         // 应用图像预处理以减少摩尔纹和色偏
         val processedNv21 = preprocessImage(nv21, width, height)
 
-        val out = ProjectionCardsBridge.detectNv21Safe(processedNv21, width, height, 8)
-        val count = if (out.isNotEmpty()) out[0] else 0
-        if (count <= 0) {
+        // 帧送入原生会话，只取回增量事件；桌面静止时没有事件，也不刷新界面
+        ProjectionCardsBridge.processNv21Safe(processedNv21, width, height)
+        val events = ProjectionCardsBridge.pollEventsSafe()
+        val eventCount = if (events.isNotEmpty()) events[0] else 0
+        if (eventCount <= 0) return
+        for (i in 0 until eventCount) {
+            val base = 1 + i * ProjectionCardsBridge.EVENT_STRIDE
+            val trackId = events[base + 1]
+            // 轨迹状态：cardId, group, tlx, tly, brx, bry
+            val state = intArrayOf(events[base + 2], events[base + 3],
+                events[base + 4], events[base + 5], events[base + 6], events[base + 7])
+            when (events[base]) {
+                ProjectionCardsBridge.EVENT_RESET -> trackedCards.clear()
+                ProjectionCardsBridge.EVENT_ADD -> trackedCards[trackId] = state
+                ProjectionCardsBridge.EVENT_MOVE,
+                ProjectionCardsBridge.EVENT_ID_CONFIRMED -> if (trackedCards.containsKey(trackId)) trackedCards[trackId] = state
+                ProjectionCardsBridge.EVENT_REMOVE -> trackedCards.remove(trackId)
+            }
+        }
+
+        if (trackedCards.isEmpty()) {
             requireActivity().runOnUiThread {
                 resultText.text = "识别结果：未检测到卡片"
                 overlay.showBoxes(emptyList())
@@ -343,21 +366,22 @@ class InputRecognitionTestFragment : Fragment() {
 
         val boxes = mutableListOf<RectF>()
         val sb = StringBuilder()
-        sb.append("识别结果：共").append(count).append("张\n")
+        sb.append("识别结果：共").append(trackedCards.size).append("张\n")
         // 根据旋转后的显示尺寸进行缩放计算
         val dispW = if (appliedRotation == 90 || appliedRotation == 270) height else width
         val dispH = if (appliedRotation == 90 || appliedRotation == 270) width else height
         val sx = overlay.width.toFloat() / dispW
         val sy = overlay.height.toFloat() / dispH
-        for (i in 0 until count) {
-            val base = 1 + i * 6
-            val cardId = out[base]
-            val group = out[base + 1]
-            val tlx = out[base + 2]
-            val tly = out[base + 3]
-            val brx = out[base + 4]
-            val bry = out[base + 5]
-            sb.append("#").append(i + 1).append(" ID=").append(cardId)
+        var index = 0
+        for (card in trackedCards.values) {
+            val cardId = card[0]
+            val group = card[1]
+            val tlx = card[2]
+            val tly = card[3]
+            val brx = card[4]
+            val bry = card[5]
+            index += 1
+            sb.append("#").append(index).append(" ID=").append(cardId)
                 .append(" 组=").append(if (group == 0) "A" else if (group == 1) "B" else "?")
                 .append(" 位置=(").append(tlx).append(",").append(tly).append(")-(").append(brx).append(",").append(bry).append(")\n")
             var rect = RectF(tlx.toFloat(), tly.toFloat(), brx.toFloat(), bry.toFloat())
@@ -16,5 +16,56 @@ object ProjectionCardsBridge {
         return if (loaded) detectDecodeNv21(nv21, width, height, maxCards) else intArrayOf(0)
     }
 
+    /** 增量事件类型，与 detect_decode_api.h 中的 CARD_EVENT_* 一致 */
+    const val EVENT_RESET = 0
+    const val EVENT_ADD = 1
+    const val EVENT_MOVE = 2
+    const val EVENT_REMOVE = 3
+    const val EVENT_ID_CONFIRMED = 4
+
+    /** 每个事件在 pollEventsSafe 结果中占用的 int 数：type, trackId, cardId, group, tlx, tly, brx, bry, codeCorner（读码角点 0=TL..3=BL，非卡片旋转方向） */
+    const val EVENT_STRIDE = 9
+
+    /** 只送帧不取结果，卡片变化通过 pollEventsSafe 取回；返回本帧卡片数 */
+    fun processNv21Safe(nv21: ByteArray, width: Int, height: Int): Int {
+        return if (loaded) processNv21(nv21, width, height) else 0
+    }
+
+    /** 取出增量事件：[count, count * EVENT_STRIDE 个 int]；桌面静止时通常为空 */
+    fun pollEventsSafe(maxEvents: Int = 64): IntArray {
+        return if (loaded) pollEvents(maxEvents) else intArrayOf(0)
+    }
+
+    /** 清空原生会话的轨迹（例如重新打开摄像头时） */
+    fun resetSessionSafe() {
+        if (loaded) resetSession()
+    }
+
+    /** 包围盒任一边变化超过该像素数才发出 MOVE 事件 */
+    fun setMoveEpsilonSafe(pixels: Float) {
+        if (loaded) setMoveEpsilon(pixels)
+    }
+
+    /** 录制送入检测的预览帧到帧流文件（离线回放用），metadata 可写入标定参数 JSON */
+    fun startRecordingSafe(path: String, metadata: String, compress: Boolean = false) {
+        if (loaded) startRecording(path, metadata, compress)
+    }
+
+    fun stopRecordingSafe() {
+        if (loaded) stopRecording()
+    }
+
     external fun detectDecodeNv21(nv21: ByteArray, width: Int, height: Int, maxCards: Int): IntArray
+
+    external fun processNv21(nv21: ByteArray, width: Int, height: Int): Int
+
+    external fun pollEvents(maxEvents: Int): IntArray
+
+    external fun setMoveEpsilon(pixels: Float)
+
+    external fun resetSession()
+
+    external fun startRecording(path: String, metadata: String, compress: Boolean)
+
+    external fun stopRecording()
 }
\ No newline at end of file
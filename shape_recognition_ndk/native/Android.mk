@@ -26,9 +26,12 @@ include $(CLEAR_VARS)
 LOCAL_MODULE := shape_detector_ndk
 LOCAL_SRC_FILES := \
     shape_detector.cpp \
+    shape_session.cpp \
+    shape_tracker.cpp \
     shape_detector_c_api.cpp
 
 LOCAL_C_INCLUDES += $(LOCAL_PATH)
+LOCAL_C_INCLUDES += $(LOCAL_PATH)/../../cv_android_ndk_package/native
 LOCAL_CFLAGS := -DANDROID_NDK -Wall -Wextra -O2 -fPIC
 LOCAL_CPPFLAGS := -std=c++17 -frtti -fexceptions
 LOCAL_LDLIBS := -llog -ljnigraphics -lz
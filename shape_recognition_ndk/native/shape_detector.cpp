@@ -1,10 +1,13 @@
 #include "shape_detector.h"
+#include "stripe_scheduler.h"
+#include "shape_json.h"
 #include <iostream>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <string>
 #include <map>
+#include <limits>
 
 namespace ShapeDetector {
 
@@ -46,15 +49,29 @@ std::map<std::string, ColorRange> getDefaultColorRanges() {
     return colorRanges;
 }
 
-cv::Mat preprocessImage(const cv::Mat& image) {
-    cv::Mat rotated, blurred;
-    
-    // 校正相机旋转：逆时针旋转90度来校正顺时针旋转的相机画面
-    cv::rotate(image, rotated, cv::ROTATE_90_COUNTERCLOCKWISE);
-    
-    // 高斯模糊减少噪声
-    cv::GaussianBlur(rotated, blurred, cv::Size(5, 5), 0);
-    
+namespace {
+
+// 按滤波方式降噪；对子矩阵滤波时读取父图像中ROI之外的真实像素
+void applyBlur(const cv::Mat& src, cv::Mat& dst, BlurMode blur) {
+    switch (blur) {
+    case BlurMode::GAUSSIAN:
+        cv::GaussianBlur(src, dst, cv::Size(5, 5), 0);
+        break;
+    case BlurMode::BOX:
+        cv::blur(src, dst, cv::Size(5, 5));
+        break;
+    case BlurMode::NONE:
+        dst = src;
+        break;
+    }
+}
+
+} // namespace
+
+cv::Mat preprocessImage(const cv::Mat& image, BlurMode blur) {
+    // 相机旋转的校正只作用于输出坐标，像素保持传感器方向
+    cv::Mat blurred;
+    applyBlur(image, blurred, blur);
     return blurred;
 }
 
@@ -91,10 +108,14 @@ cv::Mat detectColorRegions(const cv::Mat& hsv, const ColorRange& colorRange) {
     cv::morphologyEx(combinedMask, combinedMask, cv::MORPH_CLOSE, kernel);
     
     // 宽松的噪声过滤 - 允许更小的连通区域通过
+    return removeSmallRegions(combinedMask);
+}
+
+cv::Mat removeSmallRegions(const cv::Mat& mask) {
     std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(combinedMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
     
-    cv::Mat filteredMask = cv::Mat::zeros(combinedMask.size(), CV_8UC1);
+    cv::Mat filteredMask = cv::Mat::zeros(mask.size(), CV_8UC1);
     for (const auto& contour : contours) {
         double area = cv::contourArea(contour);
         if (area > 100) {  // 进一步降低最小面积阈值，检测更小的目标
@@ -105,12 +126,274 @@ cv::Mat detectColorRegions(const cv::Mat& hsv, const ColorRange& colorRange) {
     return filteredMask;
 }
 
-bool isLongRectangle(const std::vector<cv::Point>& contour, double& aspectRatio) {
-    // 使用最小外接矩形
-    cv::RotatedRect rotatedRect = cv::minAreaRect(contour);
+namespace {
+
+/**
+ * 3x3十字形结构元素（即3x3 MORPH_ELLIPSE）的逐位腐蚀/膨胀，每一位独立对应一种颜色
+ * 图像边界外按OpenCV形态学默认值处理：腐蚀时视为全1，膨胀时视为全0
+ */
+void crossMorphBits(const cv::Mat& src, cv::Mat& dst, bool erode) {
+    dst.create(src.size(), CV_8UC1);
+    const uchar border = erode ? 0xFF : 0x00;
+    const int cols = src.cols;
+    std::vector<uchar> borderRow(cols, border);
+    for (int y = 0; y < src.rows; ++y) {
+        const uchar* cur = src.ptr<uchar>(y);
+        const uchar* up = y > 0 ? src.ptr<uchar>(y - 1) : borderRow.data();
+        const uchar* down = y + 1 < src.rows ? src.ptr<uchar>(y + 1) : borderRow.data();
+        uchar* out = dst.ptr<uchar>(y);
+        for (int x = 0; x < cols; ++x) {
+            const uchar left = x > 0 ? cur[x - 1] : border;
+            const uchar right = x + 1 < cols ? cur[x + 1] : border;
+            out[x] = erode ? static_cast<uchar>(cur[x] & up[x] & down[x] & left & right)
+                           : static_cast<uchar>(cur[x] | up[x] | down[x] | left | right);
+        }
+    }
+}
+
+int findRoot(std::vector<int>& parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void unite(std::vector<int>& parent, int a, int b) {
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if (a == b) return;
+    // 以较早的游程为根，使区域按首行顺序编号
+    if (a < b) parent[b] = a; else parent[a] = b;
+}
+
+} // namespace
+
+cv::Mat segmentColorLabels(const cv::Mat& image, const std::map<std::string, ColorRange>& colorRanges,
+                           BlurMode blur) {
+    // 条带内每像素的中间数据：模糊后图像(3或4) + HSV(3) + 饱和度/亮度掩码(1) + 颜色掩码(1) + 标签平面(2)
+    const int bytesPerPixel = image.channels() + 7;
+    // Android位图为RGBA，cvtColor按RGB读取前三个通道
+    const int hsvCode = image.channels() == 4 ? cv::COLOR_RGB2HSV : cv::COLOR_BGR2HSV;
+    // 5x5模糊直接读取父图像中的相邻行；3x3开运算+闭运算共四次腐蚀/膨胀，需要4行halo
+    const int halo = 4;
+    
+    cv::Mat labels(image.rows, image.cols, CV_8UC1);
+    
+    // 与detectColorRegions相同的饱和度(>30)与亮度(40, 240]条件，合并为一次inRange，每个条带只算一次
+    const cv::Scalar validLower(0, 31, 41);
+    const cv::Scalar validUpper(255, 255, 240);
+    
+    struct Scratch {
+        cv::Mat blurred;
+        cv::Mat hsv;
+        cv::Mat validMask;
+        cv::Mat colorMask;
+        cv::Mat bits;
+        cv::Mat morph;
+    };
+    
+    const int stripeRows = StripeProcessing::stripeRowsFor(image.cols, bytesPerPixel, halo);
+    const auto stripes = StripeProcessing::makeStripes(image.rows, stripeRows, halo);
+    
+    StripeProcessing::forEachStripe(stripes, [] { return Scratch(); },
+        [&](const StripeProcessing::Stripe& stripe, Scratch& scratch) {
+            // 对子矩阵做滤波时OpenCV会读取父图像中ROI之外的真实像素，结果与整帧模糊一致
+            applyBlur(image.rowRange(stripe.readY0, stripe.readY1), scratch.blurred, blur);
+            cv::cvtColor(scratch.blurred, scratch.hsv, hsvCode);
+            cv::inRange(scratch.hsv, validLower, validUpper, scratch.validMask);
+            
+            scratch.bits = cv::Mat::zeros(scratch.hsv.size(), CV_8UC1);
+            int bit = 0;
+            for (const auto& colorPair : colorRanges) {
+                if (bit >= MAX_LABEL_COLORS) break;
+                cv::inRange(scratch.hsv, colorPair.second.lower, colorPair.second.upper, scratch.colorMask);
+                cv::bitwise_and(scratch.colorMask, scratch.validMask, scratch.colorMask);
+                cv::bitwise_and(scratch.colorMask, cv::Scalar(1 << bit), scratch.colorMask);
+                cv::bitwise_or(scratch.bits, scratch.colorMask, scratch.bits);
+                ++bit;
+            }
+            
+            // 开运算（腐蚀→膨胀）+ 闭运算（膨胀→腐蚀），全部颜色一次完成
+            crossMorphBits(scratch.bits, scratch.morph, true);
+            crossMorphBits(scratch.morph, scratch.bits, false);
+            crossMorphBits(scratch.bits, scratch.morph, false);
+            crossMorphBits(scratch.morph, scratch.bits, true);
+            
+            // 只写回条带自身的行，halo行上的结果受缓冲区边界影响，丢弃
+            scratch.bits.rowRange(stripe.offset(), stripe.offset() + stripe.rows())
+                .copyTo(labels.rowRange(stripe.y0, stripe.y1));
+        });
+    
+    return labels;
+}
+
+std::map<std::string, cv::Mat> segmentColorRegions(const cv::Mat& image,
+                                                   const std::map<std::string, ColorRange>& colorRanges) {
+    cv::Mat labels = segmentColorLabels(image, colorRanges);
+    
+    std::map<std::string, cv::Mat> masks;
+    int bit = 0;
+    for (const auto& colorPair : colorRanges) {
+        if (bit >= MAX_LABEL_COLORS) break;
+        cv::Mat& mask = masks[colorPair.first];
+        cv::bitwise_and(labels, cv::Scalar(1 << bit), mask);
+        cv::compare(mask, 0, mask, cv::CMP_NE);
+        ++bit;
+    }
+    return masks;
+}
+
+ColorBlobs labelColorBlobs(const cv::Mat& labels, int colorCount) {
+    ColorBlobs result;
+    colorCount = std::min(colorCount, MAX_LABEL_COLORS);
+    if (labels.empty() || colorCount <= 0) return result;
+    
+    std::vector<ColorRun> runs;
+    std::vector<int> runColor;
+    std::vector<int> parent;
+    // 每种颜色上一行与当前行的游程下标区间
+    std::vector<int> prevBegin(colorCount, 0), prevEnd(colorCount, 0);
+    std::vector<int> curBegin(colorCount, 0);
+    std::vector<int> openStart(colorCount, -1);
+    std::vector<std::vector<int>> rowRuns(colorCount);
+    std::vector<std::vector<int>> prevRowRuns(colorCount);
+    const uchar colorMaskBits = static_cast<uchar>((1 << colorCount) - 1);
+    
+    auto closeRun = [&](int c, int y, int x0, int x1) {
+        const int idx = static_cast<int>(runs.size());
+        runs.push_back({y, x0, x1});
+        runColor.push_back(c);
+        parent.push_back(idx);
+        // 8连通：与上一行中列区间相接（含对角）的同色游程合并
+        for (int p : prevRowRuns[c]) {
+            const ColorRun& pr = runs[p];
+            if (pr.x1 < x0) continue;
+            if (pr.x0 > x1) break;
+            unite(parent, idx, p);
+        }
+        rowRuns[c].push_back(idx);
+    };
+    
+    // 单次光栅扫描：只在标签值变化处处理发生变化的颜色位
+    for (int y = 0; y < labels.rows; ++y) {
+        const uchar* row = labels.ptr<uchar>(y);
+        uchar prev = 0;
+        for (int x = 0; x < labels.cols; ++x) {
+            const uchar v = row[x] & colorMaskBits;
+            uchar changed = v ^ prev;
+            while (changed) {
+                const int c = __builtin_ctz(changed);
+                changed &= static_cast<uchar>(changed - 1);
+                if (v & (1 << c)) {
+                    openStart[c] = x;
+                } else {
+                    closeRun(c, y, openStart[c], x);
+                }
+            }
+            prev = v;
+        }
+        for (int c = 0; c < colorCount; ++c) {
+            if (prev & (1 << c)) closeRun(c, y, openStart[c], labels.cols);
+            prevRowRuns[c].swap(rowRuns[c]);
+            rowRuns[c].clear();
+        }
+    }
+    
+    // 按根汇总：面积、外接矩形与一阶矩
+    std::vector<int> blobOfRoot(runs.size(), -1);
+    std::vector<int> runBlob(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const int root = findRoot(parent, static_cast<int>(i));
+        if (blobOfRoot[root] < 0) {
+            blobOfRoot[root] = static_cast<int>(result.blobs.size());
+            ColorBlob blob;
+            blob.colorIndex = runColor[root];
+            blob.boundingRect = cv::Rect(runs[i].x0, runs[i].y, 0, 0);
+            result.blobs.push_back(blob);
+        }
+        const int b = blobOfRoot[root];
+        runBlob[i] = b;
+        ColorBlob& blob = result.blobs[b];
+        const ColorRun& run = runs[i];
+        const int len = run.x1 - run.x0;
+        blob.area += len;
+        blob.m10 += 0.5 * len * (run.x0 + run.x1 - 1);
+        blob.m01 += static_cast<double>(len) * run.y;
+        blob.boundingRect |= cv::Rect(run.x0, run.y, len, 1);
+        ++blob.runCount;
+    }
+    
+    // 区域按颜色、再按首行顺序排列，游程按区域连续存放
+    std::vector<int> order(result.blobs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = static_cast<int>(i);
+    std::stable_sort(order.begin(), order.end(), [&result](int a, int b) {
+        return result.blobs[a].colorIndex < result.blobs[b].colorIndex;
+    });
+    std::vector<int> rank(order.size());
+    std::vector<ColorBlob> sorted;
+    sorted.reserve(order.size());
+    int offset = 0;
+    for (size_t k = 0; k < order.size(); ++k) {
+        rank[order[k]] = static_cast<int>(k);
+        sorted.push_back(result.blobs[order[k]]);
+        sorted.back().firstRun = offset;
+        offset += sorted.back().runCount;
+    }
+    result.blobs.swap(sorted);
+    
+    result.runs.resize(runs.size());
+    std::vector<int> fill(result.blobs.size(), 0);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        const int b = rank[runBlob[i]];
+        result.runs[result.blobs[b].firstRun + fill[b]++] = runs[i];
+    }
+    return result;
+}
+
+std::vector<cv::Point> blobContour(const ColorBlobs& blobs, const ColorBlob& blob) {
+    // 在外接矩形（外扩1像素）内重绘区域，再提取外轮廓
+    const cv::Rect& r = blob.boundingRect;
+    cv::Mat mask = cv::Mat::zeros(r.height + 2, r.width + 2, CV_8UC1);
+    for (int i = 0; i < blob.runCount; ++i) {
+        const ColorRun& run = blobs.runs[blob.firstRun + i];
+        uchar* row = mask.ptr<uchar>(run.y - r.y + 1);
+        std::fill(row + run.x0 - r.x + 1, row + run.x1 - r.x + 1, static_cast<uchar>(255));
+    }
     
-    double width = rotatedRect.size.width;
-    double height = rotatedRect.size.height;
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, cv::Point(r.x - 1, r.y - 1));
+    if (contours.empty()) return std::vector<cv::Point>();
+    // 单个8连通区域只有一条外轮廓
+    return contours[0];
+}
+
+ContourFeatures::ContourFeatures(const std::vector<cv::Point>& points)
+    : contour(&points),
+      area(cv::contourArea(points)),
+      perimeter(cv::arcLength(points, true)),
+      boundingRect(cv::boundingRect(points)),
+      minAreaRect(cv::minAreaRect(points)),
+      moments(cv::moments(points)) {
+    cv::convexHull(points, hull);
+    hullArea = cv::contourArea(hull);
+}
+
+const std::vector<cv::Point>& ContourFeatures::approxPoly(double epsilonRatio) const {
+    for (const auto& entry : approxCache_) {
+        if (entry.first == epsilonRatio) {
+            return entry.second;
+        }
+    }
+    approxCache_.emplace_back(epsilonRatio, std::vector<cv::Point>());
+    cv::approxPolyDP(*contour, approxCache_.back().second, epsilonRatio * perimeter, true);
+    return approxCache_.back().second;
+}
+
+bool isLongRectangle(const ContourFeatures& features, double& aspectRatio) {
+    // 使用最小外接矩形
+    double width = features.minAreaRect.size.width;
+    double height = features.minAreaRect.size.height;
     
     // 确保width是长边
     if (width < height) {
@@ -123,23 +406,16 @@ bool isLongRectangle(const std::vector<cv::Point>& contour, double& aspectRatio)
     return (aspectRatio >= 2.0);
 }
 
-bool isTriangle(const std::vector<cv::Point>& contour) {
+bool isTriangle(const ContourFeatures& features) {
     // 使用更严格的多边形逼近
-    std::vector<cv::Point> approx;
-    double epsilon = 0.015 * cv::arcLength(contour, true);
-    cv::approxPolyDP(contour, approx, epsilon, true);
+    const std::vector<cv::Point>& approx = features.approxPoly(0.015);
     
     if (approx.size() != 3) {
         return false;
     }
     
     // 检查轮廓面积与凸包面积的比例，确保形状规整 - 放宽要求
-    double contourArea = cv::contourArea(contour);
-    std::vector<cv::Point> hull;
-    cv::convexHull(contour, hull);
-    double hullArea = cv::contourArea(hull);
-    
-    if (hullArea > 0 && (contourArea / hullArea) < 0.7) {  // 放宽面积比例阈值
+    if (features.hullArea > 0 && (features.area / features.hullArea) < 0.7) {  // 放宽面积比例阈值
         return false;
     }
     
@@ -163,32 +439,29 @@ bool isTriangle(const std::vector<cv::Point>& contour) {
     return true;
 }
 
-bool isRectangle(const std::vector<cv::Point>& contour, double& aspectRatio) {
+bool isRectangle(const ContourFeatures& features, double& aspectRatio) {
     // 基于四边形逼近的矩形识别算法
     
     // 1. 基本面积过滤 - 大幅提高最小面积阈值以过滤噪音
-    double contourArea = cv::contourArea(contour);
+    double contourArea = features.area;
     if (contourArea < 2000) {  // 从500进一步提高到2000，只检测较大的矩形
         return false;
     }
     
     // 2. 使用四边形逼近轮廓 - 收紧epsilon以要求更精确的形状
-    std::vector<cv::Point> approx;
-    double epsilon = 0.015 * cv::arcLength(contour, true);  // 从0.02收紧到0.015
-    cv::approxPolyDP(contour, approx, epsilon, true);
+    const std::vector<cv::Point>* quad = &features.approxPoly(0.015);  // 从0.02收紧到0.015
     
     // 如果逼近结果不是四边形，尝试调整epsilon值（范围收紧）
-    if (approx.size() != 4) {
+    if (quad->size() != 4) {
         // 尝试稍大的epsilon值
-        epsilon = 0.025 * cv::arcLength(contour, true);  // 从0.08收紧到0.025
-        cv::approxPolyDP(contour, approx, epsilon, true);
+        quad = &features.approxPoly(0.025);  // 从0.08收紧到0.025
         
         // 如果仍然不是四边形，尝试更小的epsilon值
-        if (approx.size() != 4) {
-            epsilon = 0.008 * cv::arcLength(contour, true);  // 从0.01收紧到0.008
-            cv::approxPolyDP(contour, approx, epsilon, true);
+        if (quad->size() != 4) {
+            quad = &features.approxPoly(0.008);  // 从0.01收紧到0.008
         }
     }
+    const std::vector<cv::Point>& approx = *quad;
     
     // 如果最终仍然不是四边形，则不是矩形
     if (approx.size() != 4) {
@@ -283,13 +556,10 @@ bool isRectangle(const std::vector<cv::Point>& contour, double& aspectRatio) {
     return true;
 }
 
-void calculateLongRectangleOrientation(const std::vector<cv::Point>& contour, DetectedShape& shape) {
-    // 使用最小外接矩形
-    cv::RotatedRect rotatedRect = cv::minAreaRect(contour);
-    
-    // 获取矩形的四个顶点
+void calculateLongRectangleOrientation(const ContourFeatures& features, DetectedShape& shape) {
+    // 使用最小外接矩形，获取矩形的四个顶点
     cv::Point2f vertices[4];
-    rotatedRect.points(vertices);
+    features.minAreaRect.points(vertices);
     
     // 找到短边的两个中点
     cv::Point2f side1_mid = (vertices[0] + vertices[1]) * 0.5f;
@@ -325,11 +595,9 @@ void calculateLongRectangleOrientation(const std::vector<cv::Point>& contour, De
     shape.orientationAngle = angle;
 }
 
-void calculateTriangleOrientation(const std::vector<cv::Point>& contour, DetectedShape& shape) {
+void calculateTriangleOrientation(const ContourFeatures& features, DetectedShape& shape) {
     // 使用多边形逼近获取三角形顶点
-    std::vector<cv::Point> approx;
-    double epsilon = 0.02 * cv::arcLength(contour, true);
-    cv::approxPolyDP(contour, approx, epsilon, true);
+    const std::vector<cv::Point>& approx = features.approxPoly(0.02);
     
     if (approx.size() != 3) {
         // 如果不是三角形，使用重心作为方向线
@@ -372,21 +640,16 @@ void calculateTriangleOrientation(const std::vector<cv::Point>& contour, Detecte
     shape.orientationAngle = angle;
 }
 
-double calculateShapeConfidence(const std::vector<cv::Point>& contour, ShapeType shapeType) {
+double calculateShapeConfidence(const ContourFeatures& features, ShapeType shapeType) {
     double confidence = 0.0;
     
     // 基础置信度：轮廓面积与凸包面积的比例
-    double contourArea = cv::contourArea(contour);
-    std::vector<cv::Point> hull;
-    cv::convexHull(contour, hull);
-    double hullArea = cv::contourArea(hull);
-    
-    double areaRatio = (hullArea > 0) ? (contourArea / hullArea) : 0.0;
+    double areaRatio = (features.hullArea > 0) ? (features.area / features.hullArea) : 0.0;
     confidence += areaRatio * 0.4;  // 40%权重
     
     // 轮廓周长与边界矩形周长的比例
-    double perimeter = cv::arcLength(contour, true);
-    cv::Rect boundingRect = cv::boundingRect(contour);
+    double perimeter = features.perimeter;
+    const cv::Rect& boundingRect = features.boundingRect;
     double rectPerimeter = 2.0 * (boundingRect.width + boundingRect.height);
     double perimeterRatio = (rectPerimeter > 0) ? (perimeter / rectPerimeter) : 0.0;
     
@@ -402,9 +665,7 @@ double calculateShapeConfidence(const std::vector<cv::Point>& contour, ShapeType
     confidence += std::max(0.0, perimeterScore) * 0.3;  // 30%权重
     
     // 形状规整度：多边形逼近的顶点数量
-    std::vector<cv::Point> approx;
-    double epsilon = 0.015 * cv::arcLength(contour, true);
-    cv::approxPolyDP(contour, approx, epsilon, true);
+    const std::vector<cv::Point>& approx = features.approxPoly(0.015);
     
     double shapeScore = 0.0;
     if (shapeType == ShapeType::TRIANGLE && approx.size() == 3) {
@@ -421,20 +682,24 @@ double calculateShapeConfidence(const std::vector<cv::Point>& contour, ShapeType
 }
 
 ShapeType analyzeContourShape(const std::vector<cv::Point>& contour) {
+    return analyzeContourShape(ContourFeatures(contour));
+}
+
+ShapeType analyzeContourShape(const ContourFeatures& features) {
     double aspectRatio;
     
     // 首先检查是否为三角形
-    if (isTriangle(contour)) {
+    if (isTriangle(features)) {
         return ShapeType::TRIANGLE;
     }
     
     // 检查是否为长矩形
-    if (isLongRectangle(contour, aspectRatio)) {
+    if (isLongRectangle(features, aspectRatio)) {
         return ShapeType::LONG_RECTANGLE;
     }
     
     // 检查是否为普通矩形
-    if (isRectangle(contour, aspectRatio)) {
+    if (isRectangle(features, aspectRatio)) {
         return ShapeType::RECTANGLE;
     }
     
@@ -442,112 +707,184 @@ ShapeType analyzeContourShape(const std::vector<cv::Point>& contour) {
     return ShapeType::RECTANGLE;
 }
 
-DetectionResult detectShapes(const cv::Mat& image, bool debug) {
+DetectionResult detectShapes(const cv::Mat& image, bool debug, BlurMode blur) {
+    DetectionOptions options;
+    options.debug = debug;
+    options.blur = blur;
+    return detectShapes(image, options);
+}
+
+DetectionResult detectShapes(const cv::Mat& image, const DetectionOptions& options) {
     DetectionResult result;
+    detectShapes(image, options, result);
+    return result;
+}
+
+namespace {
+
+// 取出一个已清空的形状：优先复用result.recycled中的形状，保留其各数组与字符串的容量
+DetectedShape& acquireShape(DetectionResult& result) {
+    if (result.recycled.empty()) {
+        result.shapes.emplace_back();
+        return result.shapes.back();
+    }
+    result.shapes.push_back(std::move(result.recycled.back()));
+    result.recycled.pop_back();
+    
+    DetectedShape& shape = result.shapes.back();
+    std::string color = std::move(shape.color);
+    std::vector<cv::Point> contour = std::move(shape.contour);
+    std::vector<cv::Point> hull = std::move(shape.hull);
+    shape = DetectedShape();
+    color.clear();
+    contour.clear();
+    hull.clear();
+    shape.color = std::move(color);
+    shape.contour = std::move(contour);
+    shape.hull = std::move(hull);
+    return shape;
+}
+
+} // namespace
+
+void detectShapes(const cv::Mat& image, const DetectionOptions& options, DetectionResult& result) {
+    const bool debug = options.debug;
+    
+    // 上一帧的形状移入回收区，本帧按需取出复用
+    for (auto& shape : result.shapes) {
+        result.recycled.push_back(std::move(shape));
+    }
+    result.shapes.clear();
+    result.annotatedImage.release();
+    result.success = false;
     
     if (image.empty()) {
         std::cerr << "Error: Empty image" << std::endl;
-        return result;
+        return;
     }
     
-    // 预处理图像
-    cv::Mat processed = preprocessImage(image);
-    cv::Mat hsv;
-    cv::cvtColor(processed, hsv, cv::COLOR_BGR2HSV);
+    // 获取颜色范围（默认范围只构建一次）
+    static const std::map<std::string, ColorRange> defaultColorRanges = getDefaultColorRanges();
+    const auto& colorRanges = options.colorRanges.empty() ? defaultColorRanges : options.colorRanges;
+    const double minArea = options.minArea;
+    const double maxArea = options.maxArea > 0 ? options.maxArea : std::numeric_limits<double>::infinity();
+    std::vector<const std::string*> colorNames;
+    colorNames.reserve(colorRanges.size());
+    for (const auto& colorPair : colorRanges) {
+        colorNames.push_back(&colorPair.first);
+    }
+    
+    // 模糊、HSV转换、全部颜色的分割与形态学处理按条带一次完成，输出单一标签平面
+    // 像素保持传感器方向，相机旋转（逆时针90度）的校正只作用于通过筛选的轮廓
+    cv::Mat labels = segmentColorLabels(image, colorRanges, options.blur);
+    
+    // 一次游程扫描得到全部颜色的连通区域
+    ColorBlobs blobs = labelColorBlobs(labels, static_cast<int>(colorNames.size()));
     
-    // 获取颜色范围
-    auto colorRanges = getDefaultColorRanges();
+    if (debug) {
+        std::cout << "Debug: " << blobs.blobs.size() << " color blobs in " << colorNames.size() << " colors" << std::endl;
+    }
     
-    // 对每种颜色进行检测
     int shapeIdCounter = 1;  // 形状ID计数器
-    for (const auto& colorPair : colorRanges) {
-        const std::string& colorName = colorPair.first;
-        const ColorRange& colorRange = colorPair.second;
+    for (const auto& blob : blobs.blobs) {
+        const std::string& colorName = *colorNames[blob.colorIndex];
         
-        // 检测颜色区域
-        cv::Mat colorMask = detectColorRegions(hsv, colorRange);
-        
-        if (debug) {
-            // cv::imshow is not supported on Android platform
-            std::cout << "Debug: Processing " << colorName << " color mask" << std::endl;
+        // 轮廓面积不超过外接矩形面积，且（由Pick定理）不小于像素数的一半减1：
+        // 据此先按像素统计排除不可能落入面积范围的区域，只对剩余区域提取轮廓
+        if (blob.boundingRect.area() < minArea || blob.area > 2.0 * (maxArea + 1.0)) {
+            continue;
         }
         
-        // 查找轮廓
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(colorMask, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+        std::vector<cv::Point> contour = blobContour(blobs, blob);
+        if (contour.empty()) continue;
+        double area = cv::contourArea(contour);  // 旋转不改变面积
         
-        // 分析每个轮廓
-        for (const auto& contour : contours) {
-            double area = cv::contourArea(contour);
-            
-            // 过滤不合适的轮廓 - 使用test_realtime_camera.cpp中的合理面积范围
-            if (area < 900 || area > 1400) {  // 使用合理的面积范围，过滤太小和太大的形状
-                continue;
-            }
-            
-            DetectedShape shape;
-            shape.color = colorName;
-            shape.contour = contour;
-            shape.boundingRect = cv::boundingRect(contour);
-            shape.area = area;
-            shape.type = analyzeContourShape(contour);
-            shape.shapeId = shapeIdCounter++;
-            
-            // 计算中心点
-            cv::Moments moments = cv::moments(contour);
-            if (moments.m00 != 0) {
-                shape.center.x = moments.m10 / moments.m00;
-                shape.center.y = moments.m01 / moments.m00;
-            }
-            
-            // 计算长宽比
-            shape.aspectRatio = (double)shape.boundingRect.width / shape.boundingRect.height;
-            if (shape.aspectRatio < 1.0) {
-                shape.aspectRatio = 1.0 / shape.aspectRatio;
-            }
-            
-            // 计算置信度分数
-            double confidence = calculateShapeConfidence(contour, shape.type);
-            
-            // 过滤低置信度的检测结果 - 降低阈值以提高检测敏感度
-            if (confidence < 0.3) {  // 大幅降低置信度阈值，提高检测敏感度
-                continue;
-            }
-            
-            // 计算方向角和方向线
-            if (shape.type == ShapeType::LONG_RECTANGLE) {
-                calculateLongRectangleOrientation(contour, shape);
-            } else if (shape.type == ShapeType::TRIANGLE) {
-                calculateTriangleOrientation(contour, shape);
-            } else {
-                // 普通矩形默认方向角为0
-                shape.orientationAngle = 0.0;
-                shape.directionLineStart = shape.center;
-                shape.directionLineEnd = cv::Point2f(shape.center.x, shape.center.y - 30);
+        // 过滤不合适的轮廓 - 使用test_realtime_camera.cpp中的合理面积范围
+        // （removeSmallRegions去除的面积不超过100的区域也一并被排除）
+        if (area < minArea || area > maxArea) {
+            continue;
+        }
+        
+        // 换算到校正后的坐标，之后的形状分析、方向角与输出都在校正后坐标系中
+        if (options.upright) {
+            for (auto& point : contour) {
+                point = sensorToUpright(point, image.size());
             }
-            
-            result.shapes.push_back(shape);
+        }
+        
+        // 轮廓特征只计算一次，分类、置信度与方向计算共用
+        const ContourFeatures features(contour);
+        const ShapeType type = analyzeContourShape(features);
+        
+        // 计算置信度分数，过滤低置信度的检测结果 - 降低阈值以提高检测敏感度
+        double confidence = calculateShapeConfidence(features, type);
+        if (confidence < options.minConfidence) {  // 默认0.3：大幅降低置信度阈值，提高检测敏感度
+            continue;
+        }
+        
+        DetectedShape& shape = acquireShape(result);
+        shape.color.assign(colorName);
+        shape.contour.assign(contour.begin(), contour.end());
+        shape.hull.assign(features.hull.begin(), features.hull.end());
+        shape.boundingRect = features.boundingRect;
+        shape.area = area;
+        shape.type = type;
+        shape.shapeId = shapeIdCounter++;
+        
+        // 计算中心点
+        const cv::Moments& moments = features.moments;
+        if (moments.m00 != 0) {
+            shape.center.x = moments.m10 / moments.m00;
+            shape.center.y = moments.m01 / moments.m00;
+        }
+        
+        // 计算长宽比
+        shape.aspectRatio = (double)shape.boundingRect.width / shape.boundingRect.height;
+        if (shape.aspectRatio < 1.0) {
+            shape.aspectRatio = 1.0 / shape.aspectRatio;
+        }
+        
+        // 计算方向角和方向线
+        if (shape.type == ShapeType::LONG_RECTANGLE) {
+            calculateLongRectangleOrientation(features, shape);
+        } else if (shape.type == ShapeType::TRIANGLE) {
+            calculateTriangleOrientation(features, shape);
+        } else {
+            // 普通矩形默认方向角为0
+            shape.orientationAngle = 0.0;
+            shape.directionLineStart = shape.center;
+            shape.directionLineEnd = cv::Point2f(shape.center.x, shape.center.y - 30);
         }
     }
     
-    // 创建标注图像
-    result.annotatedImage = annotateShapes(image, result.shapes);
     result.success = !result.shapes.empty();
     
+    // 标注需要复制整帧，只在调用方要求时生成
+    if (options.annotate) {
+        annotate(result, image);
+    }
+    
     // Note: cv::imshow is not supported on Android platform
     // Debug visualization should be handled by the calling application
-    if (debug) {
+    if (debug && options.annotate) {
         // On Android, the annotated image will be returned to the calling application
         // for display purposes instead of using cv::imshow
         std::cout << "Debug mode: annotated image generated for display" << std::endl;
     }
-    
-    return result;
+}
+
+void annotate(DetectionResult& result, const cv::Mat& image) {
+    result.annotatedImage = annotateShapes(image, result.shapes);
 }
 
 cv::Mat annotateShapes(const cv::Mat& image, const std::vector<DetectedShape>& shapes) {
     cv::Mat annotated = image.clone();
-    
+    drawShapes(annotated, shapes);
+    return annotated;
+}
+
+void drawShapes(cv::Mat& annotated, const std::vector<DetectedShape>& shapes) {
+
     // 定义颜色映射
     std::map<std::string, cv::Scalar> colorMap;
     colorMap["Blue"] = cv::Scalar(255, 0, 0);      // 蓝色
@@ -566,81 +903,29 @@ cv::Mat annotateShapes(const cv::Mat& image, const std::vector<DetectedShape>& s
         // 绘制颜色
         cv::Scalar color = colorMap.count(shape.color) ? colorMap[shape.color] : cv::Scalar(128, 128, 128);
         
-        // 计算凸包
-        std::vector<cv::Point> hull;
-        cv::convexHull(shape.contour, hull);
+        // 使用检测时的凸包，缺失时（例如由C接口结果构造的形状）再计算
+        std::vector<cv::Point> hull = shape.hull;
+        if (hull.empty() && !shape.contour.empty()) {
+            cv::convexHull(shape.contour, hull);
+        }
         
         // 绘制凸包轮廓
-        cv::drawContours(annotated, std::vector<std::vector<cv::Point>>{hull}, -1, color, 3);
+        if (!hull.empty()) {
+            cv::polylines(annotated, hull, true, color, 3);
+        }
         
         // 绘制中心点
         cv::circle(annotated, shape.center, 3, color, -1);
     }
-    
-    return annotated;
 }
 
 std::string generateJsonOutput(const DetectionResult& result) {
-    std::string json = "{\n  \"shapes\": [\n";
-    
-    for (size_t i = 0; i < result.shapes.size(); i++) {
-        const auto& shape = result.shapes[i];
-        
-        std::string shapeTypeName;
-        std::string shapeCode;
-        switch (shape.type) {
-            case ShapeType::LONG_RECTANGLE:
-                shapeTypeName = "Long Rectangle";
-                shapeCode = "LR";
-                break;
-            case ShapeType::TRIANGLE:
-                shapeTypeName = "Triangle";
-                shapeCode = "TR";
-                break;
-            case ShapeType::RECTANGLE:
-                shapeTypeName = "Rectangle";
-                shapeCode = "RE";
-                break;
-        }
-        
-        // 颜色编码
-        std::string colorCode;
-        if (shape.color == "Blue") colorCode = "B";
-        else if (shape.color == "Black") colorCode = "K";
-        else if (shape.color == "Cyan") colorCode = "C";
-        else if (shape.color == "Yellow") colorCode = "Y";
-        else if (shape.color == "Green") colorCode = "G";
-        else colorCode = "U"; // Unknown
-        
-        json += "    {\n";
-        json += "      \"shape_code\": \"" + colorCode + shapeCode + "\",\n";
-        json += "      \"id\": " + std::to_string(shape.shapeId) + ",\n";
-        json += "      \"position\": {\n";
-        json += "        \"x\": " + std::to_string((int)shape.center.x) + ",\n";
-        json += "        \"y\": " + std::to_string((int)shape.center.y) + "\n";
-        json += "      },\n";
-        json += "      \"orientation_angle\": " + std::to_string(shape.orientationAngle) + ",\n";
-        json += "      \"color\": \"" + shape.color + "\",\n";
-        json += "      \"type\": \"" + shapeTypeName + "\",\n";
-        json += "      \"area\": " + std::to_string((int)shape.area) + ",\n";
-        json += "      \"aspect_ratio\": " + std::to_string(shape.aspectRatio) + ",\n";
-        json += "      \"direction_line\": {\n";
-        json += "        \"start\": {\"x\": " + std::to_string(shape.directionLineStart.x) + ", \"y\": " + std::to_string(shape.directionLineStart.y) + "},\n";
-        json += "        \"end\": {\"x\": " + std::to_string(shape.directionLineEnd.x) + ", \"y\": " + std::to_string(shape.directionLineEnd.y) + "}\n";
-        json += "      }\n";
-        json += "    }";
-        
-        if (i < result.shapes.size() - 1) {
-            json += ",";
-        }
-        json += "\n";
-    }
-    
-    json += "  ],\n";
-    json += "  \"total_count\": " + std::to_string(result.shapes.size()) + "\n";
-    json += "}";
-    
-    return json;
+    // 逐帧调用时复用线程内的写入缓冲区
+    static thread_local JsonOutput::JsonWriter json(JsonOutput::JsonStyle::PRETTY);
+    writeDetectionJson(json, result.shapes.size(), [&result](size_t i) {
+        return shapeJsonFields(result.shapes[i], result.shapes[i].shapeId);
+    });
+    return json.str();
 }
 
 void printDetectionResults(const DetectionResult& result) {
@@ -5,9 +5,11 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/highgui.hpp>
+#include <deque>
 #include <vector>
 #include <string>
 #include <map>
+#include <utility>
 
 namespace ShapeDetector {
 
@@ -32,6 +34,7 @@ struct DetectedShape {
     ShapeType type;                    // 形状类型
     std::string color;                 // 颜色名称
     std::vector<cv::Point> contour;    // 轮廓点
+    std::vector<cv::Point> hull;       // 凸包（检测时已算出，标注时直接使用）
     cv::Rect boundingRect;             // 边界矩形
     cv::Point2f center;                // 中心点
     double area;                       // 面积
@@ -40,15 +43,43 @@ struct DetectedShape {
     cv::Point2f directionLineStart;    // 方向线起点
     cv::Point2f directionLineEnd;      // 方向线终点
     int shapeId;                       // 形状编码ID
+    int trackId = -1;                  // 跨帧轨迹ID（由ShapeSession/ShapeTracker赋值，单帧检测为-1）
     
     DetectedShape() = default;
 };
 
+// 颜色标签平面（CV_8UC1，每种颜色一位）最多容纳的颜色数，超出的颜色范围不参与分割
+constexpr int MAX_LABEL_COLORS = 8;
+
+// 分割前的降噪滤波
+enum class BlurMode {
+    GAUSSIAN,          // 5x5高斯模糊（默认）
+    BOX,               // 5x5均值滤波，代价更低
+    NONE               // 不滤波
+};
+
+// 检测选项
+struct DetectionOptions {
+    bool debug;                         // 是否输出调试信息
+    BlurMode blur;                      // 分割前的滤波方式
+    bool annotate;                      // 是否生成标注图像（需要复制整帧，默认关闭）
+    bool upright;                       // 是否把输出坐标换算到旋转校正后（逆时针90度）的坐标系
+    double minArea;                     // 轮廓面积下限
+    double maxArea;                     // 轮廓面积上限，<=0表示不限制
+    double minConfidence;               // 形状置信度下限
+    std::map<std::string, ColorRange> colorRanges;  // 颜色范围，为空时使用getDefaultColorRanges()
+
+    DetectionOptions()
+        : debug(false), blur(BlurMode::GAUSSIAN), annotate(false), upright(true),
+          minArea(900.0), maxArea(1400.0), minConfidence(0.3) {}
+};
+
 // 检测结果结构体
 struct DetectionResult {
     std::vector<DetectedShape> shapes;  // 检测到的所有形状
-    cv::Mat annotatedImage;             // 标注后的图像
+    cv::Mat annotatedImage;             // 标注后的图像（仅在DetectionOptions::annotate或调用annotate后生成）
     bool success;                       // 检测是否成功
+    std::vector<DetectedShape> recycled; // 复用检测时暂存的多余形状（保留轮廓、凸包与颜色字符串的容量）
     
     DetectionResult() : success(false) {}
 };
@@ -66,45 +97,194 @@ cv::Mat loadImage(const std::string& path);
 std::map<std::string, ColorRange> getDefaultColorRanges();
 
 /**
- * 预处理图像
+ * 预处理图像：在传感器原始方向上降噪，不再旋转像素
+ * 相机画面的旋转校正只作用于输出坐标（见sensorToUpright）
+ * @param image 传感器方向的BGR图像
+ * @param blur 滤波方式
  */
-cv::Mat preprocessImage(const cv::Mat& image);
+cv::Mat preprocessImage(const cv::Mat& image, BlurMode blur = BlurMode::GAUSSIAN);
+
+/**
+ * 将传感器方向的坐标换算为旋转校正后（逆时针旋转90度）的坐标
+ * @param p 传感器方向的坐标
+ * @param sensorSize 传感器方向的图像尺寸
+ */
+inline cv::Point sensorToUpright(const cv::Point& p, const cv::Size& sensorSize) {
+    return cv::Point(p.y, sensorSize.width - 1 - p.x);
+}
 
 /**
  * 检测指定颜色的区域
  */
 cv::Mat detectColorRegions(const cv::Mat& hsv, const ColorRange& colorRange);
 
+/**
+ * 去除面积不超过100的小连通区域
+ */
+cv::Mat removeSmallRegions(const cv::Mat& mask);
+
+/**
+ * 按缓存大小的水平条带完成模糊、HSV转换、饱和度/亮度筛选、颜色分割与形态学处理
+ * 条带分配到多个线程，中间平面只在条带内存在；结果与preprocessImage
+ * 加detectColorRegions的形态学部分逐像素一致（尚未去除小区域）
+ * @param image BGR图像
+ * @param colorRanges 颜色范围
+ * @return 每种颜色的掩码
+ */
+std::map<std::string, cv::Mat> segmentColorRegions(const cv::Mat& image,
+                                                   const std::map<std::string, ColorRange>& colorRanges);
+
+// 颜色标签平面中的一段连续像素（同一行，列区间[x0, x1)）
+struct ColorRun {
+    int y;
+    int x0;
+    int x1;
+};
+
+// 单一颜色的8连通区域
+struct ColorBlob {
+    int colorIndex;          // 颜色序号（与colorNames对应，即标签平面中的位）
+    int area;                // 像素数
+    cv::Rect boundingRect;   // 外接矩形
+    double m10;              // 一阶矩
+    double m01;
+    int firstRun;            // 在ColorBlobs::runs中的起始下标
+    int runCount;            // 游程数
+
+    ColorBlob() : colorIndex(0), area(0), m10(0.0), m01(0.0), firstRun(0), runCount(0) {}
+    cv::Point2f centroid() const {
+        return area > 0 ? cv::Point2f(static_cast<float>(m10 / area), static_cast<float>(m01 / area)) : cv::Point2f();
+    }
+};
+
+// 全部颜色的连通区域，游程按区域连续存放
+struct ColorBlobs {
+    std::vector<ColorRun> runs;
+    std::vector<ColorBlob> blobs;
+};
+
+/**
+ * 按条带完成模糊、HSV转换、饱和度/亮度筛选与全部颜色的分割，输出单一的颜色标签平面：
+ * 第i位表示像素属于colorRanges中第i种颜色（按map顺序，最多MAX_LABEL_COLORS种），
+ * 开运算与闭运算直接在标签平面上逐位进行，与逐颜色的3x3椭圆核形态学结果一致
+ * 各步骤均与图像方向无关，可直接在传感器方向上运行
+ * @param image 三通道按BGR、四通道按RGBA（Android位图）解释
+ * @param colorRanges 颜色范围
+ * @param blur 滤波方式，与分割在同一条带内完成
+ * @return 颜色标签平面（CV_8UC1）
+ */
+cv::Mat segmentColorLabels(const cv::Mat& image, const std::map<std::string, ColorRange>& colorRanges,
+                           BlurMode blur = BlurMode::GAUSSIAN);
+
+/**
+ * 对颜色标签平面做一次游程扫描与并查集合并，得到每种颜色的8连通区域及其面积与一阶矩
+ * @param labels segmentColorLabels的输出
+ * @param colorCount 颜色数
+ * @return 全部颜色的连通区域（按颜色、再按首行顺序排列）
+ */
+ColorBlobs labelColorBlobs(const cv::Mat& labels, int colorCount);
+
+/**
+ * 提取连通区域的外轮廓（与对该颜色掩码执行RETR_EXTERNAL/CHAIN_APPROX_SIMPLE的结果一致）
+ * @param blobs labelColorBlobs的输出
+ * @param blob 其中一个区域
+ * @return 外轮廓点（原图坐标）
+ */
+std::vector<cv::Point> blobContour(const ColorBlobs& blobs, const ColorBlob& blob);
+
+// 单个轮廓的几何特征：每项只计算一次，供形状分类、置信度与方向计算共用
+struct ContourFeatures {
+    const std::vector<cv::Point>* contour;  // 轮廓点，不持有：调用方须保证轮廓在特征对象生存期内有效且不被修改
+    double area;                            // 轮廓面积
+    double perimeter;                       // 闭合周长
+    std::vector<cv::Point> hull;            // 凸包
+    double hullArea;                        // 凸包面积
+    cv::Rect boundingRect;                  // 外接矩形
+    cv::RotatedRect minAreaRect;            // 最小外接矩形
+    cv::Moments moments;                    // 矩
+
+    explicit ContourFeatures(const std::vector<cv::Point>& points);
+    ContourFeatures(std::vector<cv::Point>&&) = delete;  // 临时轮廓会立即失效
+
+    /**
+     * 多边形逼近（按需计算并缓存）
+     * @param epsilonRatio 逼近精度与周长的比例
+     * @return 逼近结果，在特征对象生存期内有效（之后以其他精度调用不会使其失效）
+     */
+    const std::vector<cv::Point>& approxPoly(double epsilonRatio) const;
+
+private:
+    // deque尾部追加不移动已有元素，先前返回的引用保持有效
+    mutable std::deque<std::pair<double, std::vector<cv::Point>>> approxCache_;
+};
+
 /**
  * 分析轮廓形状
  */
+ShapeType analyzeContourShape(const ContourFeatures& features);
 ShapeType analyzeContourShape(const std::vector<cv::Point>& contour);
 
 /**
  * 检测长矩形（长边是短边的2倍）
  */
-bool isLongRectangle(const std::vector<cv::Point>& contour, double& aspectRatio);
+bool isLongRectangle(const ContourFeatures& features, double& aspectRatio);
 
 /**
  * 检测三角形
  */
-bool isTriangle(const std::vector<cv::Point>& contour);
+bool isTriangle(const ContourFeatures& features);
 
 /**
  * 检测普通矩形
  */
-bool isRectangle(const std::vector<cv::Point>& contour, double& aspectRatio);
+bool isRectangle(const ContourFeatures& features, double& aspectRatio);
 
 /**
- * 主检测函数
+ * 主检测函数：分割与连通区域分析在传感器方向上进行，
+ * 只把通过面积筛选的轮廓换算到旋转校正后的坐标（options.upright），中心点、方向角等输出均为校正后坐标
+ * 检测路径不复制输入帧；只有options.annotate为真时才生成标注图像
+ * @param image 传感器方向的图像：三通道BGR或四通道RGBA
+ * @param options 检测选项
  */
-DetectionResult detectShapes(const cv::Mat& image, bool debug = false);
+DetectionResult detectShapes(const cv::Mat& image, const DetectionOptions& options);
 
 /**
- * 在图像上标注检测结果
+ * 主检测函数（复用result）：逐帧以同一个result调用时，形状数组以及各形状轮廓、凸包、颜色字符串的容量
+ * 被复用，只在形状数或点数超过此前最大值时增长；分割平面、连通区域、findContours与轮廓特征
+ * （凸包、多边形近似）仍在每帧内部分配
+ * @param image 传感器方向的图像：三通道BGR或四通道RGBA
+ * @param options 检测选项
+ * @param result 输出结果（原有内容被替换）
+ */
+void detectShapes(const cv::Mat& image, const DetectionOptions& options, DetectionResult& result);
+
+/**
+ * 主检测函数（不生成标注图像，需要时调用annotate）
+ * @param image 传感器方向的BGR图像
+ * @param debug 是否输出调试信息
+ * @param blur 滤波方式
+ */
+DetectionResult detectShapes(const cv::Mat& image, bool debug = false, BlurMode blur = BlurMode::GAUSSIAN);
+
+/**
+ * 按需生成标注图像，写入result.annotatedImage
+ * @param result 检测结果
+ * @param image 检测时使用的图像
+ */
+void annotate(DetectionResult& result, const cv::Mat& image);
+
+/**
+ * 在图像上标注检测结果（返回副本）
  */
 cv::Mat annotateShapes(const cv::Mat& image, const std::vector<DetectedShape>& shapes);
 
+/**
+ * 直接在图像上绘制检测结果，不复制图像
+ * @param image 待绘制的图像
+ * @param shapes 检测到的形状
+ */
+void drawShapes(cv::Mat& image, const std::vector<DetectedShape>& shapes);
+
 /**
  * 打印检测结果
  */
@@ -1,9 +1,16 @@
 #include "shape_detector_c_api.h"
 #include "shape_detector.h"
+#include "shape_session.h"
+#include "shape_tracker.h"
+#include "shape_records.h"
+#include "shape_json.h"
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <cstring>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
 
 #ifdef ANDROID_NDK
 #include <android/log.h>
@@ -48,6 +55,76 @@ static ShapeType convert_cpp_shape_type(const ShapeDetector::ShapeType& cpp_type
     }
 }
 
+static void convert_cpp_shape(const ShapeDetector::DetectedShape& cpp_shape, DetectedShape& c_shape) {
+    c_shape.id = cpp_shape.shapeId;
+    c_shape.type = convert_cpp_shape_type(cpp_shape.type);
+    c_shape.color = convert_color_type(cpp_shape.color);
+    c_shape.center.x = cpp_shape.center.x;
+    c_shape.center.y = cpp_shape.center.y;
+    c_shape.area = cpp_shape.area;
+    c_shape.aspect_ratio = cpp_shape.aspectRatio;
+    c_shape.orientation_angle = cpp_shape.orientationAngle;
+    c_shape.direction_line_start.x = cpp_shape.directionLineStart.x;
+    c_shape.direction_line_start.y = cpp_shape.directionLineStart.y;
+    c_shape.direction_line_end.x = cpp_shape.directionLineEnd.x;
+    c_shape.direction_line_end.y = cpp_shape.directionLineEnd.y;
+    
+    // Generate shape code (first letter of the color + type code)
+    const char* type_code = "UN";
+    if (cpp_shape.type == ShapeDetector::ShapeType::LONG_RECTANGLE) {
+        type_code = "LR";
+    } else if (cpp_shape.type == ShapeDetector::ShapeType::RECTANGLE) {
+        type_code = "RE";
+    } else if (cpp_shape.type == ShapeDetector::ShapeType::TRIANGLE) {
+        type_code = "TR";
+    }
+    
+    size_t length = 0;
+    if (!cpp_shape.color.empty()) {
+        c_shape.shape_code[length++] = cpp_shape.color[0];
+    }
+    c_shape.shape_code[length++] = type_code[0];
+    c_shape.shape_code[length++] = type_code[1];
+    c_shape.shape_code[length] = '\0';
+}
+
+static const char* color_type_name(ColorType color) {
+    switch (color) {
+        case COLOR_RED: return "Red";
+        case COLOR_GREEN: return "Green";
+        case COLOR_BLUE: return "Blue";
+        case COLOR_YELLOW: return "Yellow";
+        case COLOR_CYAN: return "Cyan";
+        case COLOR_MAGENTA: return "Magenta";
+        case COLOR_BLACK: return "Black";
+        case COLOR_WHITE: return "White";
+        default: return nullptr;
+    }
+}
+
+// Write the record header and return the number of records that fit, -1 if the header does not fit
+static int begin_records(void* buffer, size_t capacity, int total_count) {
+    if (!buffer || capacity < sizeof(ShapeRecordHeader)) {
+        return -1;
+    }
+    const int fit = static_cast<int>((capacity - sizeof(ShapeRecordHeader)) / sizeof(ShapeRecord));
+    ShapeRecordHeader header;
+    header.magic = SHAPE_RECORD_MAGIC;
+    header.version = SHAPE_RECORD_VERSION;
+    header.header_size = sizeof(ShapeRecordHeader);
+    header.record_size = sizeof(ShapeRecord);
+    header.reserved = 0;
+    header.count = std::min(fit, total_count);
+    header.total_count = total_count;
+    memcpy(buffer, &header, sizeof(header));
+    return header.count;
+}
+
+static void put_record(void* buffer, int index, const ShapeRecord& record) {
+    memcpy(static_cast<uint8_t*>(buffer) + sizeof(ShapeRecordHeader) + index * sizeof(ShapeRecord),
+           &record, sizeof(record));
+}
+
 static cv::Mat image_data_to_mat(const ImageData* image_data) {
     if (!image_data || !image_data->data) {
         return cv::Mat();
@@ -56,26 +133,112 @@ static cv::Mat image_data_to_mat(const ImageData* image_data) {
     return cv::Mat(image_data->height, image_data->width, CV_8UC3, image_data->data);
 }
 
-static bool mat_to_image_data(const cv::Mat& mat, ImageData* output_data) {
-    if (mat.empty() || !output_data) {
+// Annotation color of a shape (same palette as ShapeDetector::drawShapes)
+static cv::Scalar color_type_bgr(ColorType color) {
+    switch (color) {
+        case COLOR_BLUE: return cv::Scalar(255, 0, 0);
+        case COLOR_BLACK: return cv::Scalar(0, 0, 0);
+        case COLOR_CYAN: return cv::Scalar(255, 255, 0);
+        case COLOR_YELLOW: return cv::Scalar(0, 255, 255);
+        case COLOR_GREEN: return cv::Scalar(0, 255, 0);
+        default: return cv::Scalar(128, 128, 128);
+    }
+}
+
+// Run detection on C image data into a reused C++ result; false (with g_last_error set) on failure.
+// Reusing cpp_result keeps the shape array and each shape's contour, hull and color string across
+// frames; segmentation planes, findContours and contour features still allocate inside the detector.
+static bool run_detection(const ImageData* image_data, bool debug, ShapeDetector::DetectionResult& cpp_result) {
+    cv::Mat image = image_data_to_mat(image_data);
+    if (image.empty()) {
+        g_last_error = "Invalid image data";
+        LOGE("Invalid image data");
         return false;
     }
-    
-    output_data->width = mat.cols;
-    output_data->height = mat.rows;
-    output_data->channels = mat.channels();
-    
-    size_t data_size = mat.total() * mat.elemSize();
-    output_data->data = (uint8_t*)malloc(data_size);
-    if (!output_data->data) {
+    ShapeDetector::DetectionOptions options;
+    options.debug = debug;
+    ShapeDetector::detectShapes(image, options, cpp_result);
+    return true;
+}
+
+// Per-thread C++ result reused by shape_detector_detect_into
+static ShapeDetector::DetectionResult& thread_result() {
+    static thread_local ShapeDetector::DetectionResult result;
+    return result;
+}
+
+static ShapeDetector::ShapeType to_cpp_shape_type(ShapeType type) {
+    switch (type) {
+        case SHAPE_TYPE_LONG_RECTANGLE: return ShapeDetector::ShapeType::LONG_RECTANGLE;
+        case SHAPE_TYPE_TRIANGLE: return ShapeDetector::ShapeType::TRIANGLE;
+        default: return ShapeDetector::ShapeType::RECTANGLE;
+    }
+}
+
+// Write the C structs through the shared layout in shape_json.h (same as ShapeDetector::generateJsonOutput)
+static void write_json(const DetectionResult* result, JsonOutput::JsonWriter& json) {
+    ShapeDetector::writeDetectionJson(json, static_cast<size_t>(result->shape_count), [result](size_t i) {
+        const DetectedShape& shape = result->shapes[i];
+        const char* color_name = color_type_name(shape.color);
+        ShapeDetector::ShapeJsonFields fields;
+        ShapeDetector::describeShape(to_cpp_shape_type(shape.type), color_name ? color_name : "Unknown", fields);
+        fields.id = shape.id;
+        fields.center = cv::Point2f(shape.center.x, shape.center.y);
+        fields.orientationAngle = shape.orientation_angle;
+        fields.area = shape.area;
+        fields.aspectRatio = shape.aspect_ratio;
+        fields.directionLineStart = cv::Point2f(shape.direction_line_start.x, shape.direction_line_start.y);
+        fields.directionLineEnd = cv::Point2f(shape.direction_line_end.x, shape.direction_line_end.y);
+        return fields;
+    });
+}
+
+// Per-thread writer reused by shape_detector_write_json / shape_detector_generate_json
+static JsonOutput::JsonWriter& thread_json() {
+    static thread_local JsonOutput::JsonWriter json(JsonOutput::JsonStyle::PRETTY);
+    return json;
+}
+
+static bool valid_result(const DetectionResult* result) {
+    if (!result || (result->shape_count > 0 && !result->shapes) || result->shape_count < 0) {
+        g_last_error = "Invalid detection result";
+        LOGE("Invalid detection result");
         return false;
     }
-    
-    memcpy(output_data->data, mat.data, data_size);
     return true;
 }
 
+struct ShapeResultPoolImpl {
+    ShapeDetector::DetectionResult cpp_result;   // Reused C++ result (see run_detection)
+    std::vector<DetectedShape> shapes;
+    DetectionResult result;
+    JsonOutput::JsonWriter json{JsonOutput::JsonStyle::PRETTY};
+    std::vector<uint8_t> pixels;
+    ImageData image;
+};
+
 // API implementations
+namespace ShapeDetector {
+
+int writeShapeRecords(const std::vector<DetectedShape>& shapes, void* buffer, size_t capacity) {
+    const int count = begin_records(buffer, capacity, static_cast<int>(shapes.size()));
+    for (int i = 0; i < count; i++) {
+        const DetectedShape& shape = shapes[i];
+        ShapeRecord record;
+        record.id = shape.trackId >= 0 ? shape.trackId : shape.shapeId;
+        record.color = convert_color_type(shape.color);
+        record.type = convert_cpp_shape_type(shape.type);
+        record.center_x = shape.center.x;
+        record.center_y = shape.center.y;
+        record.angle = static_cast<float>(shape.orientationAngle);
+        record.area = static_cast<float>(shape.area);
+        put_record(buffer, i, record);
+    }
+    return count;
+}
+
+} // namespace ShapeDetector
+
 extern "C" {
 
 bool shape_detector_init() {
@@ -94,24 +257,12 @@ void shape_detector_cleanup() {
 }
 
 DetectionResult* shape_detector_detect(const ImageData* image_data, bool debug) {
-    if (!image_data) {
-        g_last_error = "Invalid image data";
-        LOGE("Invalid image data");
-        return nullptr;
-    }
-    
     try {
-        // Convert ImageData to cv::Mat
-        cv::Mat image = image_data_to_mat(image_data);
-        if (image.empty()) {
-            g_last_error = "Failed to convert image data";
-            LOGE("Failed to convert image data");
+        ShapeDetector::DetectionResult cpp_result;
+        if (!run_detection(image_data, debug, cpp_result)) {
             return nullptr;
         }
         
-        // Detect shapes
-        ShapeDetector::DetectionResult cpp_result = ShapeDetector::detectShapes(image, debug);
-        
         // Allocate C result structure
         DetectionResult* result = (DetectionResult*)malloc(sizeof(DetectionResult));
         if (!result) {
@@ -134,36 +285,7 @@ DetectionResult* shape_detector_detect(const ImageData* image_data, bool debug)
             
             // Convert shapes
             for (int i = 0; i < result->shape_count; i++) {
-                const auto& cpp_shape = cpp_result.shapes[i];
-                DetectedShape& c_shape = result->shapes[i];
-                
-                c_shape.id = cpp_shape.shapeId;
-                c_shape.type = convert_cpp_shape_type(cpp_shape.type);
-                c_shape.color = convert_color_type(cpp_shape.color);
-                c_shape.center.x = cpp_shape.center.x;
-                c_shape.center.y = cpp_shape.center.y;
-                c_shape.area = cpp_shape.area;
-                c_shape.aspect_ratio = cpp_shape.aspectRatio;
-                c_shape.orientation_angle = cpp_shape.orientationAngle;
-                c_shape.direction_line_start.x = cpp_shape.directionLineStart.x;
-                c_shape.direction_line_start.y = cpp_shape.directionLineStart.y;
-                c_shape.direction_line_end.x = cpp_shape.directionLineEnd.x;
-                c_shape.direction_line_end.y = cpp_shape.directionLineEnd.y;
-                
-                // Generate shape code
-                std::string shape_code = cpp_shape.color.substr(0, 1);
-                if (cpp_shape.type == ShapeDetector::ShapeType::LONG_RECTANGLE) {
-                    shape_code += "LR";
-                } else if (cpp_shape.type == ShapeDetector::ShapeType::RECTANGLE) {
-                    shape_code += "RE";
-                } else if (cpp_shape.type == ShapeDetector::ShapeType::TRIANGLE) {
-                    shape_code += "TR";
-                } else {
-                    shape_code += "UN";
-                }
-                
-                strncpy(c_shape.shape_code, shape_code.c_str(), sizeof(c_shape.shape_code) - 1);
-                c_shape.shape_code[sizeof(c_shape.shape_code) - 1] = '\0';
+                convert_cpp_shape(cpp_result.shapes[i], result->shapes[i]);
             }
         } else {
             result->shapes = nullptr;
@@ -179,80 +301,106 @@ DetectionResult* shape_detector_detect(const ImageData* image_data, bool debug)
     }
 }
 
-char* shape_detector_generate_json(const DetectionResult* result) {
-    if (!result) {
-        g_last_error = "Invalid detection result";
-        LOGE("Invalid detection result");
-        return nullptr;
-    }
-    
+int shape_detector_detect_into(const ImageData* image_data, bool debug,
+                               DetectedShape* out_shapes, int max_shapes) {
     try {
-        // Convert C result back to C++ result for JSON generation
-        ShapeDetector::DetectionResult cpp_result;
-        
-        for (int i = 0; i < result->shape_count; i++) {
-            const DetectedShape& c_shape = result->shapes[i];
-            ShapeDetector::DetectedShape cpp_shape;
-            
-            cpp_shape.shapeId = c_shape.id;
-            cpp_shape.center = cv::Point2f(c_shape.center.x, c_shape.center.y);
-            cpp_shape.area = c_shape.area;
-            cpp_shape.aspectRatio = c_shape.aspect_ratio;
-            cpp_shape.orientationAngle = c_shape.orientation_angle;
-            cpp_shape.directionLineStart = cv::Point2f(c_shape.direction_line_start.x, c_shape.direction_line_start.y);
-            cpp_shape.directionLineEnd = cv::Point2f(c_shape.direction_line_end.x, c_shape.direction_line_end.y);
-            
-            // Convert C enums to C++ enums
-            switch (c_shape.type) {
-                case SHAPE_TYPE_RECTANGLE: cpp_shape.type = ShapeDetector::ShapeType::RECTANGLE; break;
-                case SHAPE_TYPE_LONG_RECTANGLE: cpp_shape.type = ShapeDetector::ShapeType::LONG_RECTANGLE; break;
-                case SHAPE_TYPE_TRIANGLE: cpp_shape.type = ShapeDetector::ShapeType::TRIANGLE; break;
-                default: cpp_shape.type = ShapeDetector::ShapeType::RECTANGLE; break;
-            }
-            
-            switch (c_shape.color) {
-                case COLOR_RED: cpp_shape.color = "Red"; break;
-                case COLOR_GREEN: cpp_shape.color = "Green"; break;
-                case COLOR_BLUE: cpp_shape.color = "Blue"; break;
-                case COLOR_YELLOW: cpp_shape.color = "Yellow"; break;
-                case COLOR_CYAN: cpp_shape.color = "Cyan"; break;
-                case COLOR_MAGENTA: cpp_shape.color = "Magenta"; break;
-                case COLOR_BLACK: cpp_shape.color = "Black"; break;
-                case COLOR_WHITE: cpp_shape.color = "White"; break;
-                default: cpp_shape.color = "Unknown"; break;
-            }
-            
-            cpp_result.shapes.push_back(cpp_shape);
+        ShapeDetector::DetectionResult& cpp_result = thread_result();
+        if (!run_detection(image_data, debug, cpp_result)) {
+            return -1;
         }
         
-        std::string json_str = ShapeDetector::generateJsonOutput(cpp_result);
-        
-        // Allocate C string
-        char* c_json = (char*)malloc(json_str.length() + 1);
-        if (!c_json) {
-            g_last_error = "Memory allocation failed for JSON";
-            LOGE("Memory allocation failed for JSON");
-            return nullptr;
+        const int total = static_cast<int>(cpp_result.shapes.size());
+        if (!out_shapes) return total;
+        const int count = std::min(total, std::max(0, max_shapes));
+        for (int i = 0; i < count; i++) {
+            convert_cpp_shape(cpp_result.shapes[i], out_shapes[i]);
         }
-        
-        strcpy(c_json, json_str.c_str());
-        return c_json;
-        
+        return count;
     } catch (const std::exception& e) {
-        g_last_error = std::string("JSON generation failed: ") + e.what();
-        LOGE("JSON generation failed: %s", e.what());
+        g_last_error = std::string("Detection failed: ") + e.what();
+        LOGE("Detection failed: %s", e.what());
+        return -1;
+    }
+}
+
+char* shape_detector_generate_json(const DetectionResult* result) {
+    if (!valid_result(result)) {
+        return nullptr;
+    }
+    JsonOutput::JsonWriter& json = thread_json();
+    write_json(result, json);
+    
+    // Allocate C string
+    char* c_json = (char*)malloc(json.size() + 1);
+    if (!c_json) {
+        g_last_error = "Memory allocation failed for JSON";
+        LOGE("Memory allocation failed for JSON");
         return nullptr;
     }
+    
+    memcpy(c_json, json.data(), json.size() + 1);
+    return c_json;
+}
+
+int shape_detector_write_json(const DetectionResult* result, char* buffer, int capacity) {
+    if (!valid_result(result)) {
+        return -1;
+    }
+    if (capacity < 0 || (!buffer && capacity > 0)) {
+        g_last_error = "Invalid JSON buffer";
+        return -1;
+    }
+    
+    JsonOutput::JsonWriter& json = thread_json();
+    write_json(result, json);
+    if (capacity > 0) {
+        // snprintf semantics: truncate, always terminate, return the full length
+        const size_t copied = std::min(json.size(), static_cast<size_t>(capacity) - 1);
+        memcpy(buffer, json.data(), copied);
+        buffer[copied] = '\0';
+    }
+    return static_cast<int>(json.size());
 }
 
 bool shape_detector_annotate_image(const ImageData* image_data, 
                                    const DetectionResult* result, 
                                    ImageData* output_data) {
-    if (!image_data || !result || !output_data) {
+    if (!image_data || !image_data->data || !result || !output_data) {
+        g_last_error = "Invalid parameters for image annotation";
+        LOGE("Invalid parameters for image annotation");
+        return false;
+    }
+    
+    const size_t stride = static_cast<size_t>(image_data->width) * 3;
+    output_data->data = (uint8_t*)malloc(stride * image_data->height);
+    if (!output_data->data) {
+        g_last_error = "Memory allocation failed for image";
+        LOGE("Memory allocation failed for image");
+        return false;
+    }
+    output_data->width = image_data->width;
+    output_data->height = image_data->height;
+    output_data->channels = 3;
+    
+    if (!shape_detector_annotate_into(image_data, result, output_data->data, static_cast<int>(stride))) {
+        shape_detector_free_image(output_data);
+        return false;
+    }
+    return true;
+}
+
+bool shape_detector_annotate_into(const ImageData* image_data, const DetectionResult* result,
+                                  uint8_t* out_data, int out_stride) {
+    if (!image_data || !result || !out_data || (result->shape_count > 0 && !result->shapes)) {
         g_last_error = "Invalid parameters for image annotation";
         LOGE("Invalid parameters for image annotation");
         return false;
     }
+    if (out_stride > 0 && out_stride < image_data->width * 3) {
+        g_last_error = "Output stride smaller than a row of pixels";
+        LOGE("Output stride %d smaller than a row of %d pixels", out_stride, image_data->width);
+        return false;
+    }
     
     try {
         cv::Mat image = image_data_to_mat(image_data);
@@ -262,46 +410,20 @@ bool shape_detector_annotate_image(const ImageData* image_data,
             return false;
         }
         
-        // Convert C result to C++ result
-        std::vector<ShapeDetector::DetectedShape> cpp_shapes;
-        for (int i = 0; i < result->shape_count; i++) {
-            const DetectedShape& c_shape = result->shapes[i];
-            ShapeDetector::DetectedShape cpp_shape;
-            
-            cpp_shape.shapeId = c_shape.id;
-            cpp_shape.center = cv::Point2f(c_shape.center.x, c_shape.center.y);
-            cpp_shape.area = c_shape.area;
-            cpp_shape.aspectRatio = c_shape.aspect_ratio;
-            cpp_shape.orientationAngle = c_shape.orientation_angle;
-            cpp_shape.directionLineStart = cv::Point2f(c_shape.direction_line_start.x, c_shape.direction_line_start.y);
-            cpp_shape.directionLineEnd = cv::Point2f(c_shape.direction_line_end.x, c_shape.direction_line_end.y);
-            
-            // Convert enums to C++ enum class
-            switch (c_shape.type) {
-                case SHAPE_TYPE_RECTANGLE: cpp_shape.type = ShapeDetector::ShapeType::RECTANGLE; break;
-                case SHAPE_TYPE_LONG_RECTANGLE: cpp_shape.type = ShapeDetector::ShapeType::LONG_RECTANGLE; break;
-                case SHAPE_TYPE_TRIANGLE: cpp_shape.type = ShapeDetector::ShapeType::TRIANGLE; break;
-                default: cpp_shape.type = ShapeDetector::ShapeType::RECTANGLE; break;
-            }
-            
-            switch (c_shape.color) {
-                case COLOR_RED: cpp_shape.color = "Red"; break;
-                case COLOR_GREEN: cpp_shape.color = "Green"; break;
-                case COLOR_BLUE: cpp_shape.color = "Blue"; break;
-                case COLOR_YELLOW: cpp_shape.color = "Yellow"; break;
-                case COLOR_CYAN: cpp_shape.color = "Cyan"; break;
-                case COLOR_MAGENTA: cpp_shape.color = "Magenta"; break;
-                case COLOR_BLACK: cpp_shape.color = "Black"; break;
-                case COLOR_WHITE: cpp_shape.color = "White"; break;
-                default: cpp_shape.color = "Unknown"; break;
-            }
-            
-            cpp_shapes.push_back(cpp_shape);
+        // Wrap the caller's buffer; copyTo into a Mat of the same size and type does not reallocate
+        const size_t step = out_stride > 0 ? static_cast<size_t>(out_stride) : image.cols * image.elemSize();
+        cv::Mat annotated(image.rows, image.cols, image.type(), out_data, step);
+        if (annotated.data != image.data) {
+            image.copyTo(annotated);
         }
         
-        cv::Mat annotated = ShapeDetector::annotateShapes(image, cpp_shapes);
-        
-        return mat_to_image_data(annotated, output_data);
+        // C results carry no contour, so (as with ShapeDetector::drawShapes) only the centers are drawn
+        for (int i = 0; i < result->shape_count; i++) {
+            const DetectedShape& shape = result->shapes[i];
+            cv::circle(annotated, cv::Point2f(shape.center.x, shape.center.y), 3,
+                       color_type_bgr(shape.color), -1);
+        }
+        return true;
         
     } catch (const std::exception& e) {
         g_last_error = std::string("Image annotation failed: ") + e.what();
@@ -310,6 +432,100 @@ bool shape_detector_annotate_image(const ImageData* image_data,
     }
 }
 
+ShapeResultPoolHandle shape_result_pool_create(int max_shapes) {
+    try {
+        ShapeResultPoolImpl* pool = new ShapeResultPoolImpl();
+        pool->shapes.resize(std::max(1, max_shapes));
+        pool->result.shapes = pool->shapes.data();
+        pool->result.shape_count = 0;
+        pool->result.total_count = 0;
+        pool->image = ImageData();
+        return pool;
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Pool creation failed: ") + e.what();
+        LOGE("Pool creation failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void shape_result_pool_destroy(ShapeResultPoolHandle pool) {
+    delete pool;
+}
+
+const DetectionResult* shape_result_pool_detect(ShapeResultPoolHandle pool, const ImageData* image_data, bool debug) {
+    if (!pool) {
+        g_last_error = "Invalid result pool";
+        return nullptr;
+    }
+    
+    try {
+        const ShapeDetector::DetectionResult& cpp_result = pool->cpp_result;
+        if (!run_detection(image_data, debug, pool->cpp_result)) {
+            return nullptr;
+        }
+        
+        // 仅在超过历史最大形状数时扩容
+        const size_t count = cpp_result.shapes.size();
+        if (pool->shapes.size() < count) {
+            pool->shapes.resize(count);
+        }
+        for (size_t i = 0; i < count; i++) {
+            convert_cpp_shape(cpp_result.shapes[i], pool->shapes[i]);
+        }
+        pool->result.shapes = pool->shapes.data();
+        pool->result.shape_count = static_cast<int>(count);
+        pool->result.total_count = static_cast<int>(count);
+        return &pool->result;
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Detection failed: ") + e.what();
+        LOGE("Detection failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+const char* shape_result_pool_json(ShapeResultPoolHandle pool) {
+    if (!pool) {
+        g_last_error = "Invalid result pool";
+        return nullptr;
+    }
+    
+    try {
+        write_json(&pool->result, pool->json);
+        return pool->json.data();
+    } catch (const std::exception& e) {
+        g_last_error = std::string("JSON generation failed: ") + e.what();
+        LOGE("JSON generation failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+const ImageData* shape_result_pool_annotate(ShapeResultPoolHandle pool, const ImageData* image_data) {
+    if (!pool || !image_data || !image_data->data || image_data->width <= 0 || image_data->height <= 0) {
+        g_last_error = "Invalid parameters for image annotation";
+        return nullptr;
+    }
+    
+    try {
+        const size_t stride = static_cast<size_t>(image_data->width) * 3;
+        const size_t size = stride * image_data->height;
+        if (pool->pixels.size() < size) {
+            pool->pixels.resize(size);
+        }
+        if (!shape_detector_annotate_into(image_data, &pool->result, pool->pixels.data(), static_cast<int>(stride))) {
+            return nullptr;
+        }
+        pool->image.data = pool->pixels.data();
+        pool->image.width = image_data->width;
+        pool->image.height = image_data->height;
+        pool->image.channels = 3;
+        return &pool->image;
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Image annotation failed: ") + e.what();
+        LOGE("Image annotation failed: %s", e.what());
+        return nullptr;
+    }
+}
+
 void shape_detector_free_result(DetectionResult* result) {
     if (result) {
         if (result->shapes) {
@@ -332,6 +548,170 @@ void shape_detector_free_image(ImageData* image_data) {
     }
 }
 
+struct ShapeSessionImpl {
+    ShapeDetector::ShapeSession session;
+};
+
+ShapeSessionHandle shape_session_create() {
+    try {
+        return new ShapeSessionImpl();
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Session creation failed: ") + e.what();
+        LOGE("Session creation failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void shape_session_destroy(ShapeSessionHandle session) {
+    delete session;
+}
+
+bool shape_session_set_color_range(ShapeSessionHandle session, ColorType color,
+                                   const int lower[3], const int upper[3]) {
+    const char* name = color_type_name(color);
+    if (!session || !name || !lower || !upper) {
+        g_last_error = "Invalid color range";
+        return false;
+    }
+    if (!session->session.setColorRange(name, ShapeDetector::ColorRange(
+            cv::Scalar(lower[0], lower[1], lower[2]), cv::Scalar(upper[0], upper[1], upper[2])))) {
+        g_last_error = "Too many color ranges (at most 8 per session)";
+        LOGE("Too many color ranges (at most 8 per session)");
+        return false;
+    }
+    return true;
+}
+
+void shape_session_set_area_range(ShapeSessionHandle session, float min_area, float max_area) {
+    if (session) session->session.setAreaRange(min_area, max_area);
+}
+
+void shape_session_set_stability(ShapeSessionHandle session, int window, int max_misses, float max_distance) {
+    if (session) session->session.setStability(window, max_misses, max_distance);
+}
+
+void shape_session_reset(ShapeSessionHandle session) {
+    if (session) session->session.reset();
+}
+
+int shape_session_process(ShapeSessionHandle session, const uint8_t* data, int width, int height,
+                          int channels, int stride, DetectedShape* out_shapes, int max_shapes) {
+    if (!session || !data || width <= 0 || height <= 0 || (channels != 3 && channels != 4)) {
+        g_last_error = "Invalid image data";
+        return -1;
+    }
+    
+    try {
+        const size_t step = stride > 0 ? static_cast<size_t>(stride) : static_cast<size_t>(width) * channels;
+        cv::Mat image(height, width, channels == 4 ? CV_8UC4 : CV_8UC3, const_cast<uint8_t*>(data), step);
+        const auto& stable = session->session.process(image);
+        
+        const int count = std::min(static_cast<int>(stable.size()), max_shapes);
+        for (int i = 0; out_shapes && i < count; i++) {
+            convert_cpp_shape(stable[i], out_shapes[i]);
+            out_shapes[i].id = stable[i].trackId;
+        }
+        return out_shapes ? count : static_cast<int>(stable.size());
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Session processing failed: ") + e.what();
+        LOGE("Session processing failed: %s", e.what());
+        return -1;
+    }
+}
+
+struct ShapeTrackerImpl {
+    ShapeDetector::ShapeTracker tracker;
+    std::vector<ShapeDetector::TrackInput> inputs;
+};
+
+ShapeTrackerHandle shape_tracker_create(int window, int max_misses, float max_distance) {
+    try {
+        ShapeDetector::ShapeTrackerConfig config;
+        config.window = window;
+        config.maxMisses = max_misses;
+        config.maxDistance = max_distance;
+        ShapeTrackerImpl* impl = new ShapeTrackerImpl();
+        impl->tracker.setConfig(config);
+        return impl;
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Tracker creation failed: ") + e.what();
+        LOGE("Tracker creation failed: %s", e.what());
+        return nullptr;
+    }
+}
+
+void shape_tracker_destroy(ShapeTrackerHandle tracker) {
+    delete tracker;
+}
+
+int shape_tracker_update(ShapeTrackerHandle tracker, const DetectedShape* shapes, int shape_count,
+                         ShapeTrack* out_tracks, int max_tracks) {
+    if (!tracker || (shape_count > 0 && !shapes)) {
+        g_last_error = "Invalid tracker input";
+        return -1;
+    }
+    
+    try {
+        // C接口颜色直接作为跟踪器颜色编号，不经过字符串
+        tracker->inputs.clear();
+        for (int i = 0; i < shape_count; i++) {
+            tracker->inputs.push_back({static_cast<int>(shapes[i].color),
+                                       cv::Point2f(shapes[i].center.x, shapes[i].center.y)});
+        }
+        const auto& tracks = tracker->tracker.update(tracker->inputs);
+        
+        if (!out_tracks) return static_cast<int>(tracks.size());
+        const int count = std::min(static_cast<int>(tracks.size()), max_tracks);
+        for (int i = 0; i < count; i++) {
+            const auto& track = tracks[i];
+            ShapeTrack& out = out_tracks[i];
+            out.track_id = track.trackId;
+            out.color = static_cast<ColorType>(track.colorId);
+            out.center.x = track.center.x;
+            out.center.y = track.center.y;
+            out.hits = track.hits;
+            out.misses = track.misses;
+            out.age = track.age;
+            out.detection = track.detection;
+            out.stable = track.stable();
+        }
+        return count;
+    } catch (const std::exception& e) {
+        g_last_error = std::string("Tracker update failed: ") + e.what();
+        LOGE("Tracker update failed: %s", e.what());
+        return -1;
+    }
+}
+
+void shape_tracker_reset(ShapeTrackerHandle tracker) {
+    if (tracker) tracker->tracker.reset();
+}
+
+int shape_detector_write_records(const DetectedShape* shapes, int shape_count, void* buffer, int capacity) {
+    if ((!shapes && shape_count > 0) || shape_count < 0 || capacity < 0) {
+        g_last_error = "Invalid parameters";
+        return -1;
+    }
+    
+    const int count = begin_records(buffer, static_cast<size_t>(capacity), shape_count);
+    if (count < 0) {
+        g_last_error = "Buffer too small for the record header";
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        ShapeRecord record;
+        record.id = shapes[i].id;
+        record.color = shapes[i].color;
+        record.type = shapes[i].type;
+        record.center_x = shapes[i].center.x;
+        record.center_y = shapes[i].center.y;
+        record.angle = shapes[i].orientation_angle;
+        record.area = shapes[i].area;
+        put_record(buffer, i, record);
+    }
+    return count;
+}
+
 const char* shape_detector_get_version() {
     return VERSION;
 }
@@ -119,6 +119,233 @@ void shape_detector_free_json(char* json_str);
  */
 void shape_detector_free_image(ImageData* image_data);
 
+// Caller-owned variants: every output buffer is owned by the caller. The C++ detection result
+// behind them is reused per thread (per pool for shape_result_pool_*), so shape arrays, contours,
+// hulls and color strings stop allocating once the largest frame has been seen. OpenCV still
+// allocates per frame inside the detector (segmentation planes, findContours, convex hulls).
+
+/**
+ * Detect shapes into a caller-provided array
+ * @param image_data Input image data
+ * @param debug Enable debug mode
+ * @param out_shapes Output array (may be NULL to query the count)
+ * @param max_shapes Output array capacity
+ * @return Number of shapes written (or detected if out_shapes is NULL), -1 on error
+ */
+int shape_detector_detect_into(const ImageData* image_data, bool debug,
+                               DetectedShape* out_shapes, int max_shapes);
+
+/**
+ * Write the JSON of a detection result into a caller-provided buffer (snprintf semantics)
+ * @param result Detection result
+ * @param buffer Output buffer (may be NULL when capacity is 0 to query the length)
+ * @param capacity Buffer size in bytes including the terminator
+ * @return Length of the full JSON excluding the terminator (output is truncated if >= capacity), -1 on error
+ */
+int shape_detector_write_json(const DetectionResult* result, char* buffer, int capacity);
+
+/**
+ * Annotate into a caller-provided image buffer of the same size and channel count as the input
+ * @param image_data Input image data
+ * @param result Detection result
+ * @param out_data Output pixels (may be image_data->data to annotate in place)
+ * @param out_stride Output row stride in bytes (at least width * 3), <= 0 for tightly packed rows
+ * @return true if successful, false otherwise (including a stride smaller than one row)
+ */
+bool shape_detector_annotate_into(const ImageData* image_data, const DetectionResult* result,
+                                  uint8_t* out_data, int out_stride);
+
+// Result pool: library-owned result, JSON and image buffers reused across frames; they only grow
+// when a frame needs more than any previous one
+typedef struct ShapeResultPoolImpl* ShapeResultPoolHandle;
+
+/**
+ * Create a result pool
+ * @param max_shapes Initial shape capacity
+ * @return Pool handle (destroy with shape_result_pool_destroy), or NULL on failure
+ */
+ShapeResultPoolHandle shape_result_pool_create(int max_shapes);
+
+/**
+ * Destroy a result pool and every buffer it owns
+ * @param pool Pool handle
+ */
+void shape_result_pool_destroy(ShapeResultPoolHandle pool);
+
+/**
+ * Detect shapes into the pooled result
+ * @param pool Pool handle
+ * @param image_data Input image data
+ * @param debug Enable debug mode
+ * @return Pooled result (valid until the next detection on this pool; do not free), NULL on error
+ */
+const DetectionResult* shape_result_pool_detect(ShapeResultPoolHandle pool, const ImageData* image_data, bool debug);
+
+/**
+ * Generate the JSON of the last pooled result
+ * @param pool Pool handle
+ * @return Pooled JSON string (valid until the next call on this pool; do not free), NULL on error
+ */
+const char* shape_result_pool_json(ShapeResultPoolHandle pool);
+
+/**
+ * Annotate an image with the last pooled result
+ * @param pool Pool handle
+ * @param image_data Input image data
+ * @return Pooled annotated image (valid until the next call on this pool; do not free), NULL on error
+ */
+const ImageData* shape_result_pool_annotate(ShapeResultPoolHandle pool, const ImageData* image_data);
+
+// Shape detection session: per-frame detection plus multi-frame stability filtering
+typedef struct ShapeSessionImpl* ShapeSessionHandle;
+
+/**
+ * Create a shape detection session with the default color ranges
+ * @return Session handle (destroy with shape_session_destroy), or NULL on failure
+ */
+ShapeSessionHandle shape_session_create();
+
+/**
+ * Destroy a shape detection session
+ * @param session Session handle
+ */
+void shape_session_destroy(ShapeSessionHandle session);
+
+/**
+ * Set (or add) the HSV range of one color
+ * @param session Session handle
+ * @param color Color to configure
+ * @param lower Lower HSV bound (H in [0, 180], S/V in [0, 255])
+ * @param upper Upper HSV bound
+ * @return true if successful, false on invalid arguments or when the session already has 8 colors (label plane limit)
+ */
+bool shape_session_set_color_range(ShapeSessionHandle session, ColorType color,
+                                   const int lower[3], const int upper[3]);
+
+/**
+ * Set the accepted contour area range
+ * @param session Session handle
+ * @param min_area Minimum contour area
+ * @param max_area Maximum contour area, <= 0 for no limit
+ */
+void shape_session_set_area_range(ShapeSessionHandle session, float min_area, float max_area);
+
+/**
+ * Configure the stability tracker (existing tracks are kept)
+ * @param session Session handle
+ * @param window A track is confirmed once hit in this many consecutive frames (<= 1 disables filtering)
+ * @param max_misses Consecutive missed frames before a track is dropped
+ * @param max_distance Maximum center distance between frames for the same color
+ */
+void shape_session_set_stability(ShapeSessionHandle session, int window, int max_misses, float max_distance);
+
+/**
+ * Drop all tracks of the session
+ * @param session Session handle
+ */
+void shape_session_reset(ShapeSessionHandle session);
+
+/**
+ * Process one frame and return the stable shapes
+ * @param session Session handle
+ * @param data Pixel data: 3 channels BGR or 4 channels RGBA
+ * @param width Image width
+ * @param height Image height
+ * @param channels 3 or 4
+ * @param stride Row stride in bytes, <= 0 for tightly packed rows
+ * @param out_shapes Output array (may be NULL to query the count); id holds the persistent track ID
+ * @param max_shapes Output array capacity
+ * @return Number of shapes written (or stable shapes if out_shapes is NULL), -1 on error
+ */
+int shape_session_process(ShapeSessionHandle session, const uint8_t* data, int width, int height,
+                          int channels, int stride, DetectedShape* out_shapes, int max_shapes);
+
+// Multi-frame shape tracker: per-color uniform grid spatial hash, O(n) per frame
+typedef struct ShapeTrackerImpl* ShapeTrackerHandle;
+
+// Shape track
+typedef struct {
+    int track_id;                    // Persistent track ID
+    ColorType color;                 // Track color
+    Point2f center;                  // Center at the last hit
+    int hits;                        // Consecutive frames hit
+    int misses;                      // Consecutive frames missed
+    int age;                         // Frames since the track was created
+    int detection;                   // Index of the matched input shape in this frame, -1 if missed
+    bool stable;                     // Confirmed and hit in this frame
+} ShapeTrack;
+
+/**
+ * Create a shape tracker
+ * @param window A track is confirmed once hit in this many consecutive frames
+ * @param max_misses Consecutive missed frames before a track is dropped
+ * @param max_distance Maximum center distance between frames for the same color
+ * @return Tracker handle (destroy with shape_tracker_destroy), or NULL on failure
+ */
+ShapeTrackerHandle shape_tracker_create(int window, int max_misses, float max_distance);
+
+/**
+ * Destroy a shape tracker
+ * @param tracker Tracker handle
+ */
+void shape_tracker_destroy(ShapeTrackerHandle tracker);
+
+/**
+ * Feed one frame of detections and update the tracks
+ * @param tracker Tracker handle
+ * @param shapes Detected shapes of this frame (color and center are used)
+ * @param shape_count Number of shapes
+ * @param out_tracks Output array for the live tracks (may be NULL)
+ * @param max_tracks Output array capacity
+ * @return Number of tracks written (or live tracks if out_tracks is NULL), -1 on error
+ */
+int shape_tracker_update(ShapeTrackerHandle tracker, const DetectedShape* shapes, int shape_count,
+                         ShapeTrack* out_tracks, int max_tracks);
+
+/**
+ * Drop all tracks
+ * @param tracker Tracker handle
+ */
+void shape_tracker_reset(ShapeTrackerHandle tracker);
+
+// Flat binary result layout: a ShapeRecordHeader followed by `count` packed ShapeRecords,
+// little-endian, every field 4-byte aligned. Readers should honor header_size and record_size
+// so that fields appended in later versions can be skipped.
+#define SHAPE_RECORD_MAGIC 0x52504853u   // "SHPR"
+#define SHAPE_RECORD_VERSION 1
+
+// Binary result header
+typedef struct {
+    uint32_t magic;                  // SHAPE_RECORD_MAGIC
+    uint16_t version;                // SHAPE_RECORD_VERSION
+    uint16_t header_size;            // sizeof(ShapeRecordHeader)
+    uint16_t record_size;            // sizeof(ShapeRecord)
+    uint16_t reserved;               // Zero
+    int32_t count;                   // Number of records that follow
+    int32_t total_count;             // Number of shapes in the frame (> count if the buffer was too small)
+} ShapeRecordHeader;
+
+// Binary shape record
+typedef struct {
+    int32_t id;                      // Shape ID (persistent track ID for session results)
+    int32_t color;                   // ColorType
+    int32_t type;                    // ShapeType
+    float center_x;                  // Center position
+    float center_y;
+    float angle;                     // Orientation angle in degrees
+    float area;                      // Area
+} ShapeRecord;
+
+/**
+ * Write shapes into a caller-provided buffer using the flat binary layout
+ * @param shapes Shapes to write
+ * @param shape_count Number of shapes
+ * @param buffer Output buffer
+ * @param capacity Buffer size in bytes
+ * @return Number of records written (records that do not fit are dropped), -1 if the header does not fit
+ */
+int shape_detector_write_records(const DetectedShape* shapes, int shape_count, void* buffer, int capacity);
+
 /**
  * Get version information
  * @return Version string
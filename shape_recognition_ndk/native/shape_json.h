@@ -0,0 +1,119 @@
+#ifndef SHAPE_JSON_H
+#define SHAPE_JSON_H
+
+#include "shape_detector.h"
+#include "json_writer.h"
+#include <cstddef>
+#include <string_view>
+
+namespace ShapeDetector {
+
+// 单个形状的JSON字段：C++检测结果、C API结构与JNI桥接共用同一布局
+struct ShapeJsonFields {
+    char shapeCode[4];          // 颜色编码 + 类型编码，如"BRE"
+    int id;
+    cv::Point2f center;
+    double orientationAngle;
+    std::string_view color;
+    const char* type;
+    double area;
+    double aspectRatio;
+    cv::Point2f directionLineStart;
+    cv::Point2f directionLineEnd;
+};
+
+/**
+ * 按形状类型与颜色名称填写类型名称与形状编码
+ * @param type 形状类型
+ * @param color 颜色名称
+ * @param fields 输出字段
+ */
+inline void describeShape(ShapeType type, std::string_view color, ShapeJsonFields& fields) {
+    const char* code = "RE";
+    fields.type = "Rectangle";
+    if (type == ShapeType::LONG_RECTANGLE) {
+        fields.type = "Long Rectangle";
+        code = "LR";
+    } else if (type == ShapeType::TRIANGLE) {
+        fields.type = "Triangle";
+        code = "TR";
+    }
+
+    char colorCode = 'U';
+    if (color == "Blue") colorCode = 'B';
+    else if (color == "Black") colorCode = 'K';
+    else if (color == "Cyan") colorCode = 'C';
+    else if (color == "Yellow") colorCode = 'Y';
+    else if (color == "Green") colorCode = 'G';
+
+    fields.shapeCode[0] = colorCode;
+    fields.shapeCode[1] = code[0];
+    fields.shapeCode[2] = code[1];
+    fields.shapeCode[3] = '\0';
+    fields.color = color;
+}
+
+/**
+ * 由C++形状填写JSON字段
+ * @param shape 检测到的形状（引用其颜色字符串，须在写入期间有效）
+ * @param id 输出的ID（单帧结果为shapeId，会话结果为trackId）
+ */
+inline ShapeJsonFields shapeJsonFields(const DetectedShape& shape, int id) {
+    ShapeJsonFields fields;
+    describeShape(shape.type, shape.color, fields);
+    fields.id = id;
+    fields.center = shape.center;
+    fields.orientationAngle = shape.orientationAngle;
+    fields.area = shape.area;
+    fields.aspectRatio = shape.aspectRatio;
+    fields.directionLineStart = shape.directionLineStart;
+    fields.directionLineEnd = shape.directionLineEnd;
+    return fields;
+}
+
+// 写入一个形状对象
+inline void writeShapeJson(JsonOutput::JsonWriter& json, const ShapeJsonFields& shape) {
+    json.beginObject()
+        .key("shape_code").value(shape.shapeCode)
+        .key("id").value(shape.id)
+        .key("position").beginObject()
+            .key("x").value(static_cast<int>(shape.center.x))
+            .key("y").value(static_cast<int>(shape.center.y))
+        .endObject()
+        .key("orientation_angle").value(shape.orientationAngle, 6)
+        .key("color").value(shape.color)
+        .key("type").value(shape.type)
+        .key("area").value(static_cast<int>(shape.area))
+        .key("aspect_ratio").value(shape.aspectRatio, 6)
+        .key("direction_line").beginObject()
+            .key("start").beginObject(true)
+                .key("x").value(shape.directionLineStart.x, 6)
+                .key("y").value(shape.directionLineStart.y, 6)
+            .endObject()
+            .key("end").beginObject(true)
+                .key("x").value(shape.directionLineEnd.x, 6)
+                .key("y").value(shape.directionLineEnd.y, 6)
+            .endObject()
+        .endObject()
+    .endObject();
+}
+
+/**
+ * 写入完整检测结果 {"shapes": [...], "total_count": n}，写入前清空json
+ * @param json 写入器（逐帧复用以保留缓冲区容量）
+ * @param count 形状数
+ * @param fieldsAt 回调 fieldsAt(i) 返回第i个形状的ShapeJsonFields
+ */
+template <typename FieldsAt>
+void writeDetectionJson(JsonOutput::JsonWriter& json, size_t count, FieldsAt&& fieldsAt) {
+    json.clear();
+    json.beginObject().key("shapes").beginArray();
+    for (size_t i = 0; i < count; ++i) {
+        writeShapeJson(json, fieldsAt(i));
+    }
+    json.endArray().key("total_count").value(count).endObject();
+}
+
+} // namespace ShapeDetector
+
+#endif // SHAPE_JSON_H
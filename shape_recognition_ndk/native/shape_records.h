@@ -0,0 +1,31 @@
+#ifndef SHAPE_RECORDS_H
+#define SHAPE_RECORDS_H
+
+#include "shape_detector.h"
+#include "shape_detector_c_api.h"
+#include <cstddef>
+#include <vector>
+
+// 二进制布局固定：记录按本机字节序memcpy写入，因此要求小端目标（Android ABI均为小端）
+static_assert(sizeof(ShapeRecordHeader) == 20, "ShapeRecordHeader layout changed");
+static_assert(sizeof(ShapeRecord) == 28, "ShapeRecord layout changed");
+static_assert(offsetof(ShapeRecord, area) == 24, "ShapeRecord layout changed");
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "ShapeRecord transport is little-endian");
+#endif
+
+namespace ShapeDetector {
+
+/**
+ * 将形状按二进制定长布局（ShapeRecordHeader + ShapeRecord数组）写入调用方提供的缓冲区，
+ * 不分配内存，供JNI直接写入DirectByteBuffer
+ * @param shapes 形状列表（记录ID取trackId，未跟踪时取shapeId）
+ * @param buffer 输出缓冲区
+ * @param capacity 缓冲区字节数
+ * @return 写入的记录数（放不下的记录被丢弃），缓冲区不足以容纳头部时返回-1
+ */
+int writeShapeRecords(const std::vector<DetectedShape>& shapes, void* buffer, size_t capacity);
+
+} // namespace ShapeDetector
+
+#endif // SHAPE_RECORDS_H
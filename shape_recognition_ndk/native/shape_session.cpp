@@ -0,0 +1,79 @@
+#include "shape_session.h"
+
+namespace ShapeDetector {
+
+ShapeSession::ShapeSession(const ShapeSessionConfig& config)
+    : config_(config), tracker_(config.tracker) {
+    if (config_.detection.colorRanges.empty()) {
+        config_.detection.colorRanges = getDefaultColorRanges();
+    }
+    config_.tracker = tracker_.config();
+}
+
+const std::vector<DetectedShape>& ShapeSession::process(const cv::Mat& image) {
+    // 逐帧复用同一个结果对象，形状数组与各形状的轮廓、凸包容量跨帧保留
+    detectShapes(image, config_.detection, lastResult_);
+
+    // 更新轨迹，收集本帧命中且已确认的形状
+    // 逐元素复制赋值：轮廓、凸包与颜色字符串复用上一帧同位置元素的容量，不重新分配
+    const auto& tracks = tracker_.update(lastResult_.shapes);
+    size_t count = 0;
+    for (const auto& track : tracks) {
+        if (!track.stable()) continue;
+        DetectedShape& shape = lastResult_.shapes[track.detection];
+        shape.trackId = track.trackId;
+        if (count == stable_.size()) {
+            if (spare_.empty()) {
+                stable_.emplace_back();
+            } else {
+                stable_.push_back(std::move(spare_.back()));
+                spare_.pop_back();
+            }
+        }
+        stable_[count++] = shape;
+    }
+    // 多出的元素移入备用区而不是销毁
+    while (stable_.size() > count) {
+        spare_.push_back(std::move(stable_.back()));
+        stable_.pop_back();
+    }
+    return stable_;
+}
+
+bool ShapeSession::setColorRange(const std::string& colorName, const ColorRange& range) {
+    auto& colorRanges = config_.detection.colorRanges;
+    auto it = colorRanges.find(colorName);
+    if (it != colorRanges.end()) {
+        it->second = range;
+        return true;
+    }
+    // 标签平面每种颜色占一位，超出的颜色会被分割静默忽略
+    if (colorRanges.size() >= static_cast<size_t>(MAX_LABEL_COLORS)) {
+        return false;
+    }
+    colorRanges.emplace(colorName, range);
+    return true;
+}
+
+void ShapeSession::setAreaRange(double minArea, double maxArea) {
+    config_.detection.minArea = minArea;
+    config_.detection.maxArea = maxArea;
+}
+
+void ShapeSession::setStability(int window, int maxMisses, float distance) {
+    ShapeTrackerConfig tracker;
+    tracker.window = window;
+    tracker.maxMisses = maxMisses;
+    tracker.maxDistance = distance;
+    tracker_.setConfig(tracker);
+    config_.tracker = tracker_.config();
+}
+
+void ShapeSession::reset() {
+    tracker_.reset();
+    lastResult_ = DetectionResult();
+    stable_.clear();
+    spare_.clear();
+}
+
+} // namespace ShapeDetector
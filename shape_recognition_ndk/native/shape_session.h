@@ -0,0 +1,77 @@
+#ifndef SHAPE_SESSION_H
+#define SHAPE_SESSION_H
+
+#include "shape_detector.h"
+#include "shape_tracker.h"
+#include <string>
+#include <vector>
+
+namespace ShapeDetector {
+
+// 形状检测会话配置
+struct ShapeSessionConfig {
+    DetectionOptions detection;     // 单帧检测选项（颜色范围、面积范围、输出坐标系等）
+    ShapeTrackerConfig tracker;     // 稳定性跟踪参数（确认窗口、允许丢失帧数、关联距离）
+};
+
+// 形状检测会话：逐帧检测（一次HSV转换与标签分割），并在库内完成多帧稳定性筛选，
+// 供JNI桥接、测试工具与C接口共用
+class ShapeSession {
+public:
+    explicit ShapeSession(const ShapeSessionConfig& config = ShapeSessionConfig());
+
+    /**
+     * 处理一帧图像
+     * @param image 三通道BGR或四通道RGBA图像
+     * @return 本帧中稳定的形状（trackId为持久轨迹ID）
+     */
+    const std::vector<DetectedShape>& process(const cv::Mat& image);
+
+    // 最近一帧的全部检测结果（含未稳定的形状）
+    const DetectionResult& lastResult() const { return lastResult_; }
+
+    // 最近一帧的稳定形状
+    const std::vector<DetectedShape>& stableShapes() const { return stable_; }
+
+    /**
+     * 设置（或新增）一种颜色的HSV范围
+     * @param colorName 颜色名称
+     * @param range HSV范围
+     * @return 已有MAX_LABEL_COLORS种颜色时新增颜色返回false（不修改配置），否则返回true
+     */
+    bool setColorRange(const std::string& colorName, const ColorRange& range);
+
+    /**
+     * 设置轮廓面积范围
+     * @param minArea 面积下限
+     * @param maxArea 面积上限，<=0表示不限制
+     */
+    void setAreaRange(double minArea, double maxArea);
+
+    /**
+     * 设置稳定性跟踪参数（不清空轨迹）
+     * @param window 轨迹连续命中多少帧后确认，<=1表示不筛选
+     * @param maxMisses 轨迹允许连续丢失的帧数
+     * @param distance 相邻帧同色形状中心点关联距离
+     */
+    void setStability(int window, int maxMisses, float distance);
+
+    // 跟踪器（含全部存活轨迹）
+    const ShapeTracker& tracker() const { return tracker_; }
+
+    // 清空全部轨迹
+    void reset();
+
+    const ShapeSessionConfig& config() const { return config_; }
+
+private:
+    ShapeSessionConfig config_;
+    ShapeTracker tracker_;
+    DetectionResult lastResult_;
+    std::vector<DetectedShape> stable_;
+    std::vector<DetectedShape> spare_;  // 稳定形状减少时移出的元素，保留其轮廓、凸包与颜色字符串容量供后续帧复用
+};
+
+} // namespace ShapeDetector
+
+#endif // SHAPE_SESSION_H
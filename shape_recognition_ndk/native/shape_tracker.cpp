@@ -0,0 +1,135 @@
+#include "shape_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ShapeDetector {
+
+ShapeTracker::ShapeTracker(const ShapeTrackerConfig& config)
+    : nextTrackId_(1) {
+    setConfig(config);
+}
+
+void ShapeTracker::setConfig(const ShapeTrackerConfig& config) {
+    config_ = config;
+    config_.window = std::max(1, config_.window);
+    config_.maxMisses = std::max(0, config_.maxMisses);
+    config_.maxDistance = std::max(1.0f, config_.maxDistance);
+}
+
+void ShapeTracker::reset() {
+    tracks_.clear();
+    grid_.clear();
+    nextTrackId_ = 1;
+}
+
+uint64_t ShapeTracker::cellKey(int colorId, int cx, int cy) const {
+    // 颜色16位，格子坐标各24位（加偏移以容纳负坐标）
+    return (static_cast<uint64_t>(colorId & 0xFFFF) << 48) |
+           (static_cast<uint64_t>((cx + (1 << 23)) & 0xFFFFFF) << 24) |
+           static_cast<uint64_t>((cy + (1 << 23)) & 0xFFFFFF);
+}
+
+int ShapeTracker::colorIdOf(const std::string& colorName) {
+    auto it = colorIds_.find(colorName);
+    if (it != colorIds_.end()) return it->second;
+    const int id = static_cast<int>(colorIds_.size());
+    colorIds_.emplace(colorName, id);
+    return id;
+}
+
+const std::vector<ShapeTrack>& ShapeTracker::update(const std::vector<DetectedShape>& shapes) {
+    inputScratch_.clear();
+    inputScratch_.reserve(shapes.size());
+    for (const auto& shape : shapes) {
+        inputScratch_.push_back({colorIdOf(shape.color), shape.center});
+    }
+    return update(inputScratch_);
+}
+
+const std::vector<ShapeTrack>& ShapeTracker::update(const std::vector<TrackInput>& inputs) {
+    const float cellSize = config_.maxDistance;
+    const float maxDistanceSq = config_.maxDistance * config_.maxDistance;
+
+    // 以上一帧的轨迹位置建立网格哈希
+    grid_.clear();
+    next_.assign(tracks_.size(), -1);
+    matched_.assign(tracks_.size(), 0);
+    for (size_t i = 0; i < tracks_.size(); ++i) {
+        ShapeTrack& track = tracks_[i];
+        track.detection = -1;
+        const int cx = static_cast<int>(std::floor(track.center.x / cellSize));
+        const int cy = static_cast<int>(std::floor(track.center.y / cellSize));
+        auto it = grid_.emplace(cellKey(track.colorId, cx, cy), -1).first;
+        next_[i] = it->second;
+        it->second = static_cast<int>(i);
+    }
+
+    // 每个检测在相邻3x3格子中寻找最近的未关联同色轨迹
+    const size_t existing = tracks_.size();
+    for (size_t d = 0; d < inputs.size(); ++d) {
+        const TrackInput& input = inputs[d];
+        const int cx = static_cast<int>(std::floor(input.center.x / cellSize));
+        const int cy = static_cast<int>(std::floor(input.center.y / cellSize));
+
+        int best = -1;
+        float bestDistanceSq = maxDistanceSq;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                auto it = grid_.find(cellKey(input.colorId, cx + dx, cy + dy));
+                if (it == grid_.end()) continue;
+                for (int t = it->second; t >= 0; t = next_[t]) {
+                    if (matched_[t]) continue;
+                    const float ddx = tracks_[t].center.x - input.center.x;
+                    const float ddy = tracks_[t].center.y - input.center.y;
+                    const float distanceSq = ddx * ddx + ddy * ddy;
+                    if (distanceSq <= bestDistanceSq) {
+                        bestDistanceSq = distanceSq;
+                        best = t;
+                    }
+                }
+            }
+        }
+
+        if (best >= 0) {
+            matched_[best] = 1;
+            ShapeTrack& track = tracks_[best];
+            track.center = input.center;
+            track.hits++;
+            track.misses = 0;
+            track.detection = static_cast<int>(d);
+        } else {
+            // 新轨迹
+            ShapeTrack track;
+            track.trackId = nextTrackId_++;
+            track.colorId = input.colorId;
+            track.center = input.center;
+            track.hits = 1;
+            track.misses = 0;
+            track.age = 0;
+            track.detection = static_cast<int>(d);
+            track.confirmed = false;
+            tracks_.push_back(track);
+        }
+    }
+
+    // 未关联的轨迹计为丢失，超过上限后删除
+    for (size_t i = 0; i < existing; ++i) {
+        if (!matched_[i]) {
+            tracks_[i].hits = 0;
+            tracks_[i].misses++;
+        }
+    }
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [this](const ShapeTrack& track) {
+        return track.misses > config_.maxMisses;
+    }), tracks_.end());
+
+    for (auto& track : tracks_) {
+        track.age++;
+        if (track.hits >= config_.window) {
+            track.confirmed = true;
+        }
+    }
+    return tracks_;
+}
+
+} // namespace ShapeDetector
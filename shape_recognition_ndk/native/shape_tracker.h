@@ -0,0 +1,93 @@
+#ifndef SHAPE_TRACKER_H
+#define SHAPE_TRACKER_H
+
+#include "shape_detector.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ShapeDetector {
+
+// 跟踪器配置
+struct ShapeTrackerConfig {
+    int window;             // 轨迹连续命中多少帧后确认为稳定
+    int maxMisses;          // 轨迹连续丢失超过该帧数后删除
+    float maxDistance;      // 相邻帧同色形状中心点的最大关联距离（像素）
+
+    ShapeTrackerConfig() : window(3), maxMisses(2), maxDistance(80.0f) {}
+};
+
+// 跟踪器输入：一帧中的一个检测
+struct TrackInput {
+    int colorId;            // 颜色编号（同色才会关联）
+    cv::Point2f center;     // 中心点
+};
+
+// 形状轨迹
+struct ShapeTrack {
+    int trackId;            // 持久轨迹ID
+    int colorId;            // 颜色编号
+    cv::Point2f center;     // 最近一次命中时的中心点
+    int hits;               // 连续命中帧数
+    int misses;             // 连续丢失帧数
+    int age;                // 轨迹存在的帧数
+    int detection;          // 本帧关联的检测下标，-1表示本帧丢失
+    bool confirmed;         // 是否已确认（连续命中达到窗口后保持，直到轨迹被删除）
+
+    // 本帧命中且已确认
+    bool stable() const { return confirmed && detection >= 0; }
+};
+
+// 多帧稳定性跟踪器：每种颜色一张均匀网格空间哈希（格子边长为关联距离），
+// 每个检测只查询相邻3x3个格子，每帧代价与检测数、轨迹数成线性关系
+class ShapeTracker {
+public:
+    explicit ShapeTracker(const ShapeTrackerConfig& config = ShapeTrackerConfig());
+
+    /**
+     * 输入一帧的检测结果并更新轨迹
+     * @param inputs 本帧检测
+     * @return 全部存活轨迹（detection字段指向inputs中的下标）
+     */
+    const std::vector<ShapeTrack>& update(const std::vector<TrackInput>& inputs);
+
+    /**
+     * 输入一帧的形状检测结果（颜色名称映射为内部编号）
+     * @param shapes 本帧检测到的形状
+     * @return 全部存活轨迹（detection字段指向shapes中的下标）
+     */
+    const std::vector<ShapeTrack>& update(const std::vector<DetectedShape>& shapes);
+
+    // 当前存活轨迹
+    const std::vector<ShapeTrack>& tracks() const { return tracks_; }
+
+    /**
+     * 修改配置（不清空轨迹）
+     * @param config 新配置
+     */
+    void setConfig(const ShapeTrackerConfig& config);
+    const ShapeTrackerConfig& config() const { return config_; }
+
+    // 清空全部轨迹
+    void reset();
+
+private:
+    uint64_t cellKey(int colorId, int cx, int cy) const;
+    int colorIdOf(const std::string& colorName);
+
+    ShapeTrackerConfig config_;
+    std::vector<ShapeTrack> tracks_;
+    int nextTrackId_;
+
+    // 网格哈希：格子 -> 链表头（轨迹下标），next_为链表后继；跨帧复用以避免重复分配
+    std::unordered_map<uint64_t, int> grid_;
+    std::vector<int> next_;
+    std::vector<char> matched_;
+    std::vector<TrackInput> inputScratch_;
+    std::unordered_map<std::string, int> colorIds_;
+};
+
+} // namespace ShapeDetector
+
+#endif // SHAPE_TRACKER_H
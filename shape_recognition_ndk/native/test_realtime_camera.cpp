@@ -7,6 +7,7 @@
 #include <string>
 #include <cstring>
 #include "shape_detector_c_api.h"
+#include "shape_tracker.h"
 
 using namespace cv;
 using namespace std;
@@ -22,11 +23,6 @@ struct HullInfo {
         : hull(h), center(c), area(a), color(col) {}
 };
 
-// 计算两个中心点之间的距离
-double calculateDistance(const Point& p1, const Point& p2) {
-    return sqrt(pow(p1.x - p2.x, 2) + pow(p1.y - p2.y, 2));
-}
-
 // 将cv::Mat转换为ImageData
 ImageData matToImageData(const Mat& mat) {
     ImageData imageData;
@@ -164,9 +160,9 @@ int main() {
     cout << "  's' - 保存当前帧" << endl;
     cout << "===================" << endl;
     
-    // 5帧缓冲区，存储每一帧检测到的凸包信息
-    vector<vector<HullInfo>> frameBuffer(5);
-    int currentFrameIndex = 0;
+    // 当前帧检测到的凸包信息
+    vector<HullInfo> hulls;
+    vector<ShapeDetector::TrackInput> trackInputs;
     int frameCount = 0;
     
     // 颜色定义
@@ -179,9 +175,12 @@ int main() {
         {"Black", Scalar(128, 128, 128)}
     };
     
-    // 稳定性检测参数
-    const double DISTANCE_THRESHOLD = 50.0;  // 中心点距离阈值
-    const int REQUIRED_FRAMES = 5;           // 需要连续检测到的帧数
+    // 稳定性跟踪：同色凸包中心点在50像素内连续出现5帧视为稳定
+    ShapeDetector::ShapeTrackerConfig trackerConfig;
+    trackerConfig.window = 5;
+    trackerConfig.maxMisses = 0;
+    trackerConfig.maxDistance = 50.0f;
+    ShapeDetector::ShapeTracker tracker(trackerConfig);
     
     Mat frame;
     
@@ -196,13 +195,15 @@ int main() {
         frameCount++;
         
         // 清空当前帧的检测结果
-        frameBuffer[currentFrameIndex].clear();
+        hulls.clear();
+        trackInputs.clear();
         
         // 创建显示帧
         Mat displayFrame = frame.clone();
         
         // 对每种颜色进行检测
-        for (const string& colorName : colorNames) {
+        for (size_t colorIndex = 0; colorIndex < colorNames.size(); colorIndex++) {
+            const string& colorName = colorNames[colorIndex];
             Mat mask = createColorMask(frame, colorName);
             
             // 找到轮廓
@@ -225,57 +226,30 @@ int main() {
                         Point center(m.m10 / m.m00, m.m01 / m.m00);
                         
                         // 存储当前帧的凸包信息
-                        frameBuffer[currentFrameIndex].emplace_back(hull, center, area, colorName);
+                        hulls.emplace_back(hull, center, area, colorName);
+                        trackInputs.push_back({static_cast<int>(colorIndex), cv::Point2f(center)});
                     }
                 }
             }
         }
         
-        // 如果已经有足够的帧数，进行稳定性检测
-        if (frameCount >= REQUIRED_FRAMES) {
-            // 检查当前帧的每个凸包是否在过去的帧中都有相似位置的凸包
-            for (const auto& currentHull : frameBuffer[currentFrameIndex]) {
-                bool isStable = true;
-                
-                // 检查过去的帧
-                for (int i = 1; i < REQUIRED_FRAMES; i++) {
-                    int prevFrameIndex = (currentFrameIndex - i + 5) % 5;
-                    bool foundSimilar = false;
-                    
-                    // 在前一帧中寻找相似位置和颜色的凸包
-                    for (const auto& prevHull : frameBuffer[prevFrameIndex]) {
-                        if (prevHull.color == currentHull.color) {
-                            double distance = calculateDistance(currentHull.center, prevHull.center);
-                            if (distance <= DISTANCE_THRESHOLD) {
-                                foundSimilar = true;
-                                break;
-                            }
-                        }
-                    }
-                    
-                    if (!foundSimilar) {
-                        isStable = false;
-                        break;
-                    }
-                }
-                
-                // 如果稳定，则绘制凸包
-                if (isStable) {
-                    Scalar color = colorMap[currentHull.color];
-                    
-                    // 绘制凸包轮廓
-                    vector<vector<Point>> hullContours = {currentHull.hull};
-                    drawContours(displayFrame, hullContours, -1, color, 3);
-                    
-                    // 绘制中心点
-                    circle(displayFrame, currentHull.center, 5, color, -1);
-                    
-                    // 添加标签
-                    putText(displayFrame, currentHull.color, 
-                           Point(currentHull.center.x - 20, currentHull.center.y - 10),
-                           FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
-                }
-            }
+        // 更新轨迹，绘制本帧命中且已稳定的凸包
+        for (const auto& track : tracker.update(trackInputs)) {
+            if (!track.stable()) continue;
+            const HullInfo& currentHull = hulls[track.detection];
+            Scalar color = colorMap[currentHull.color];
+            
+            // 绘制凸包轮廓
+            vector<vector<Point>> hullContours = {currentHull.hull};
+            drawContours(displayFrame, hullContours, -1, color, 3);
+            
+            // 绘制中心点
+            circle(displayFrame, currentHull.center, 5, color, -1);
+            
+            // 添加标签（含轨迹ID）
+            putText(displayFrame, currentHull.color + " #" + to_string(track.trackId), 
+                   Point(currentHull.center.x - 20, currentHull.center.y - 10),
+                   FONT_HERSHEY_SIMPLEX, 0.5, color, 2);
         }
         
         // 显示帧信息
@@ -285,9 +259,6 @@ int main() {
         // 显示结果
         imshow("Video Stream Analysis", displayFrame);
         
-        // 更新帧索引
-        currentFrameIndex = (currentFrameIndex + 1) % 5;
-        
         // 处理按键
         char key = waitKey(1) & 0xFF;
         if (key == 27) { // ESC键
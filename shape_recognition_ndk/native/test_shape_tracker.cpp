@@ -0,0 +1,168 @@
+#include "shape_tracker.h"
+#include <iostream>
+#include <vector>
+
+/**
+ * 测试程序：验证ShapeTracker在网格空间哈希下的轨迹ID持久性
+ *
+ * 编译命令:
+ * g++ -std=c++17 test_shape_tracker.cpp shape_tracker.cpp \
+ *     `pkg-config --cflags --libs opencv4` -o test_shape_tracker
+ */
+
+using namespace ShapeDetector;
+
+// 测试计数器
+int tests_passed = 0;
+int tests_failed = 0;
+
+// 测试宏
+#define TEST_ASSERT(condition, message) \
+    do { \
+        if (condition) { \
+            std::cout << "✓ PASS: " << message << std::endl; \
+            tests_passed++; \
+        } else { \
+            std::cout << "✗ FAIL: " << message << std::endl; \
+            tests_failed++; \
+        } \
+    } while(0)
+
+ShapeTrackerConfig makeConfig(int window, int maxMisses, float maxDistance) {
+    ShapeTrackerConfig config;
+    config.window = window;
+    config.maxMisses = maxMisses;
+    config.maxDistance = maxDistance;
+    return config;
+}
+
+// 查找本帧关联到第detection个检测的轨迹
+const ShapeTrack* trackOf(const std::vector<ShapeTrack>& tracks, int detection) {
+    for (const auto& track : tracks) {
+        if (track.detection == detection) return &track;
+    }
+    return nullptr;
+}
+
+// 测试跨格子移动时ID保持不变（格子边长即关联距离）
+void testIdAcrossCells() {
+    std::cout << "\n=== 测试跨格子移动 ===" << std::endl;
+
+    ShapeTracker tracker(makeConfig(3, 2, 50.0f));
+    const float xs[] = {45.0f, 55.0f, 95.0f, 105.0f, 149.0f, 151.0f, 199.0f};
+    int firstId = -1;
+    bool sameId = true;
+    bool confirmedOnTime = true;
+    for (int frame = 0; frame < 7; ++frame) {
+        const auto& tracks = tracker.update(std::vector<TrackInput>{{0, cv::Point2f(xs[frame], 10.0f)}});
+        const ShapeTrack* track = trackOf(tracks, 0);
+        if (!track || tracks.size() != 1) {
+            sameId = false;
+            break;
+        }
+        if (firstId < 0) firstId = track->trackId;
+        sameId = sameId && track->trackId == firstId;
+        confirmedOnTime = confirmedOnTime && track->stable() == (frame + 1 >= 3);
+    }
+    TEST_ASSERT(sameId, "跨越多个格子边界时轨迹ID不变");
+    TEST_ASSERT(confirmedOnTime, "连续命中window帧后确认");
+
+    // 负坐标：格子-1与0之间的边界
+    ShapeTracker negative(makeConfig(1, 0, 20.0f));
+    int id = negative.update(std::vector<TrackInput>{{0, cv::Point2f(3.0f, 3.0f)}})[0].trackId;
+    const auto& tracks = negative.update(std::vector<TrackInput>{{0, cv::Point2f(-5.0f, -4.0f)}});
+    TEST_ASSERT(tracks.size() == 1 && tracks[0].trackId == id, "跨越坐标原点时轨迹ID不变");
+}
+
+// 测试不同颜色与超出关联距离的检测不会共用轨迹
+void testSeparation() {
+    std::cout << "\n=== 测试轨迹区分 ===" << std::endl;
+
+    ShapeTracker tracker(makeConfig(1, 0, 50.0f));
+    tracker.update(std::vector<TrackInput>{{0, cv::Point2f(100.0f, 100.0f)}, {1, cv::Point2f(102.0f, 100.0f)}});
+    const auto& tracks = tracker.update(std::vector<TrackInput>{{1, cv::Point2f(100.0f, 100.0f)},
+                                                                {0, cv::Point2f(102.0f, 100.0f)}});
+    const ShapeTrack* a = trackOf(tracks, 0);
+    const ShapeTrack* b = trackOf(tracks, 1);
+    TEST_ASSERT(tracks.size() == 2 && a && b && a->colorId == 1 && b->colorId == 0 && a->trackId == 2 && b->trackId == 1,
+                "同位置不同颜色的检测按颜色关联");
+
+    ShapeTracker far(makeConfig(1, 0, 50.0f));
+    int id = far.update(std::vector<TrackInput>{{0, cv::Point2f(100.0f, 100.0f)}})[0].trackId;
+    const auto& jumped = far.update(std::vector<TrackInput>{{0, cv::Point2f(160.0f, 100.0f)}});
+    const ShapeTrack* track = trackOf(jumped, 0);
+    TEST_ASSERT(track && track->trackId != id, "移动超过关联距离时建立新轨迹");
+
+    // 两个同色检测争同一条轨迹时只关联一个
+    ShapeTracker shared(makeConfig(1, 0, 50.0f));
+    shared.update(std::vector<TrackInput>{{0, cv::Point2f(100.0f, 100.0f)}});
+    const auto& split = shared.update(std::vector<TrackInput>{{0, cv::Point2f(110.0f, 100.0f)},
+                                                              {0, cv::Point2f(90.0f, 100.0f)}});
+    TEST_ASSERT(split.size() == 2 && trackOf(split, 0) && trackOf(split, 1) &&
+                trackOf(split, 0)->trackId == 1 && trackOf(split, 1)->trackId == 2,
+                "一条轨迹只关联一个检测");
+}
+
+// 测试丢失帧容忍与轨迹删除
+void testMisses() {
+    std::cout << "\n=== 测试丢失帧 ===" << std::endl;
+
+    ShapeTracker tracker(makeConfig(2, 2, 50.0f));
+    const std::vector<TrackInput> present = {{0, cv::Point2f(200.0f, 200.0f)}};
+    const std::vector<TrackInput> absent;
+
+    tracker.update(present);
+    int id = tracker.update(present)[0].trackId;
+    tracker.update(absent);
+    const auto& lost = tracker.update(absent);
+    TEST_ASSERT(lost.size() == 1 && lost[0].detection < 0 && !lost[0].stable() && lost[0].confirmed,
+                "丢失期间轨迹保留且不输出为稳定");
+
+    const auto& back = tracker.update(present);
+    TEST_ASSERT(back.size() == 1 && back[0].trackId == id && back[0].stable(), "丢失maxMisses帧内重现时恢复原ID");
+
+    for (int i = 0; i < 3; ++i) tracker.update(absent);
+    TEST_ASSERT(tracker.tracks().empty(), "连续丢失超过maxMisses帧后删除");
+
+    const auto& fresh = tracker.update(present);
+    TEST_ASSERT(fresh.size() == 1 && fresh[0].trackId != id && !fresh[0].confirmed, "删除后重现分配新ID");
+
+    tracker.reset();
+    TEST_ASSERT(tracker.update(present)[0].trackId == 1, "reset后ID从1开始");
+}
+
+// 测试DetectedShape输入按颜色名称关联
+void testDetectedShapes() {
+    std::cout << "\n=== 测试形状输入 ===" << std::endl;
+
+    ShapeTracker tracker(makeConfig(1, 0, 50.0f));
+    std::vector<DetectedShape> shapes(2);
+    shapes[0].color = "Red";
+    shapes[0].center = cv::Point2f(10.0f, 10.0f);
+    shapes[1].color = "Blue";
+    shapes[1].center = cv::Point2f(12.0f, 10.0f);
+    tracker.update(shapes);
+
+    std::swap(shapes[0].center, shapes[1].center);
+    const auto& tracks = tracker.update(shapes);
+    const ShapeTrack* red = trackOf(tracks, 0);
+    const ShapeTrack* blue = trackOf(tracks, 1);
+    TEST_ASSERT(tracks.size() == 2 && red && blue && red->trackId == 1 && blue->trackId == 2,
+                "颜色名称映射后同色关联");
+}
+
+int main() {
+    std::cout << "=== ShapeTracker 测试程序 ===" << std::endl;
+
+    testIdAcrossCells();
+    testSeparation();
+    testMisses();
+    testDetectedShapes();
+
+    std::cout << "\n=== 测试结果汇总 ===" << std::endl;
+    std::cout << "通过测试: " << tests_passed << std::endl;
+    std::cout << "失败测试: " << tests_failed << std::endl;
+    std::cout << "总计测试: " << (tests_passed + tests_failed) << std::endl;
+
+    return tests_failed == 0 ? 0 : 1;
+}